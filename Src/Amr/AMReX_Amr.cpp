@@ -30,6 +30,7 @@
 #include <AMReX_FabSet.H>
 #include <AMReX_StateData.H>
 #include <AMReX_PlotFileUtil.H>
+#include <AMReX_MultiFabUtil.H>
 #include <AMReX_Print.H>
 
 #ifdef BL_LAZY
@@ -80,6 +81,7 @@ std::list<std::string> Amr::state_plot_vars;
 std::list<std::string> Amr::state_small_plot_vars;
 std::list<std::string> Amr::derive_plot_vars;
 std::list<std::string> Amr::derive_small_plot_vars;
+Vector<AmrDiagnostic>  Amr::diagnostic_list;
 bool                   Amr::first_plotfile;
 bool                   Amr::first_smallplotfile;
 Vector<BoxArray>       Amr::initial_ba;
@@ -117,8 +119,44 @@ namespace
     bool prereadFAHeaders;
     VisMF::Header::Version plot_headerversion(VisMF::Header::Version_v1);
     VisMF::Header::Version checkpoint_headerversion(VisMF::Header::Version_v1);
+    Vector<Compression::Codec> plot_compression;
+    Vector<Real> plot_compression_tolerance;
+    Vector<Compression::Codec> checkpoint_compression;
+    int  checkpoint_delta_interval;
+    int  checkpoint_delta_count;  // ---- deltas since the last full checkpoint, -1 if none
+    std::string staged_checkpoint;  // ---- the checkpoint being drained from the stage
 //}
 
+namespace {
+    //
+    // A checkpoint written with AsyncOut staging has this file.  It says
+    // "draining" until all of its data have been drained and synced.
+    //
+    const std::string StageStatusFile("StageStatus");
+
+    void WriteStageStatus (const std::string& ckfile, const char* status)
+    {
+        if (ParallelDescriptor::IOProcessor()) {
+            std::string FileName(ckfile + "/" + StageStatusFile);
+            std::ofstream StatusFile(FileName.c_str(), std::ios::out | std::ios::trunc);
+            if ( ! StatusFile.good()) {
+                amrex::FileOpenFailed(FileName);
+            }
+            StatusFile << status << '\n';
+        }
+    }
+
+    //! Wait for the staged checkpoint to be drained and mark it complete.
+    void FinishStagedCheckPoint ()
+    {
+        if (staged_checkpoint.empty()) return;
+        AsyncOut::Finish();
+        ParallelDescriptor::Barrier("Amr::FinishStagedCheckPoint");
+        WriteStageStatus(staged_checkpoint, "complete");
+        staged_checkpoint.clear();
+    }
+}
+
 
 
 bool
@@ -152,6 +190,11 @@ Amr::Initialize ()
     prereadFAHeaders         = true;
     plot_headerversion       = VisMF::Header::Version_v1;
     checkpoint_headerversion = VisMF::Header::Version_v1;
+    plot_compression.clear();
+    plot_compression_tolerance.clear();
+    checkpoint_compression.clear();
+    checkpoint_delta_interval = 0;
+    checkpoint_delta_count   = -1;
 #ifdef BL_USE_SENSEI_INSITU
     insitu_bridge            = nullptr;
 #endif
@@ -166,6 +209,7 @@ Amr::Finalize ()
     Amr::state_plot_vars.clear();
     Amr::derive_plot_vars.clear();
     Amr::derive_small_plot_vars.clear();
+    Amr::diagnostic_list.clear();
     Amr::regrid_ba.clear();
     Amr::initial_ba.clear();
     Amr::finalizeInSitu();
@@ -260,6 +304,8 @@ Amr::InitAmr ()
     //
     plot_int               = -1;
     small_plot_int         = -1;
+    slice_plot_int         = -1;
+    coarse_plot_int        = -1;
     last_plotfile          = 0;
     last_smallplotfile     = -1;
     last_checkpoint        = 0;
@@ -752,8 +798,31 @@ Amr::deleteDeriveSmallPlotVar (const std::string& name)
         derive_small_plot_vars.remove(name);
 }
 
+void
+Amr::addDiagnostic (const AmrDiagnostic& diag)
+{
+    deleteDiagnostic(diag.name);
+    diagnostic_list.push_back(diag);
+}
+
+void
+Amr::deleteDiagnostic (const std::string& name)
+{
+    diagnostic_list.erase(std::remove_if(diagnostic_list.begin(), diagnostic_list.end(),
+                                         [&] (AmrDiagnostic const& d) { return d.name == name; }),
+                          diagnostic_list.end());
+}
+
+void
+Amr::clearDiagnostics ()
+{
+    diagnostic_list.clear();
+}
+
 Amr::~Amr ()
 {
+    FinishStagedCheckPoint();
+
     levelbld->variableCleanUp();
 
     Amr::Finalize();
@@ -938,6 +1007,275 @@ Amr::writeSmallPlotFile ()
     BL_PROFILE_REGION_STOP("Amr::writeSmallPlotFile()");
 }
 
+Vector<std::string>
+Amr::subPlotVars (const Vector<std::string>& vars)
+{
+    if ( ! vars.empty()) return vars;
+
+    if (first_plotfile) {
+        first_plotfile = false;
+        amr_level[0]->setPlotVariables();
+    }
+
+    Vector<std::string> plot_vars;
+    for (auto const& name : statePlotVars()) {
+        int index, scomp;
+        if (AmrLevel::isStateVariable(name, index, scomp) &&
+            AmrLevel::get_desc_lst()[index].getType() == IndexType::TheCellType()) {
+            plot_vars.push_back(name);
+        }
+    }
+    for (auto const& name : derivePlotVars()) {
+        plot_vars.push_back(name);
+    }
+    return plot_vars;
+}
+
+void
+Amr::writeSlicePlotFile ()
+{
+    if ( ! Plot_Files_Output()) {
+      return;
+    }
+
+    BL_PROFILE("Amr::writeSlicePlotFile()");
+
+    const Vector<std::string> vars = subPlotVars(slice_plot_vars);
+    const int nvars = vars.size();
+    if (nvars == 0) {
+      return;
+    }
+
+    const std::string& pltfile = amrex::Concatenate(slice_plot_file_root,
+                                                    level_steps[0],
+                                                    file_name_digits);
+
+    if (verbose > 0) {
+	amrex::Print() << "SLICE PLOTFILE: file = " << pltfile << '\n';
+    }
+
+    if (record_run_info && ParallelDescriptor::IOProcessor()) {
+        runlog << "SLICE PLOTFILE: file = " << pltfile << '\n';
+    }
+
+    //
+    // The slice is written as a plotfile one cell thick in slice_plot_dir,
+    // with index 0 and the thickness of a level 0 cell in that direction on
+    // every level, so that the levels nest as in any other plotfile.
+    //
+    const int dir = slice_plot_dir;
+    const Real coord = slice_plot_coord;
+
+    RealBox slice_rb = Geom(0).ProbDomain();
+    {
+        const Real dx0 = Geom(0).CellSize(dir);
+        const int islice0 = static_cast<int>(std::floor((coord - Geom(0).ProbLo(dir)) / dx0));
+        slice_rb.setLo(dir, Geom(0).ProbLo(dir) + islice0*dx0);
+        slice_rb.setHi(dir, Geom(0).ProbLo(dir) + (islice0+1)*dx0);
+    }
+
+    Array<int,AMREX_SPACEDIM> is_per = Geom(0).isPeriodic();
+    is_per[dir] = 0;
+
+    Vector<MultiFab> slice;
+    Vector<Geometry> slice_geom;
+    Vector<IntVect> slice_ref_ratio;
+
+    for (int lev = 0; lev <= finest_level; ++lev)
+    {
+        const int islice = static_cast<int>(std::floor((coord - Geom(lev).ProbLo(dir))
+                                                       / Geom(lev).CellSize(dir)));
+        Box plane = Geom(lev).Domain();
+        plane.setRange(dir, islice);
+        if ( ! boxArray(lev).intersects(plane)) {
+            break;
+        }
+
+        //
+        // The slices of the grids of this level, on the processes that own them.
+        //
+        AmrLevel& amrlev = *amr_level[lev];
+        MultiFab grid_slices;
+        for (int n = 0; n < nvars; ++n)
+        {
+            int index, scomp;
+            std::unique_ptr<MultiFab> s;
+            if (AmrLevel::isStateVariable(vars[n], index, scomp) &&
+                amrlev.get_new_data(index).is_cell_centered())
+            {
+                s = amrex::get_slice_data(dir, coord, amrlev.get_new_data(index), Geom(lev), scomp, 1);
+            }
+            else
+            {
+                std::unique_ptr<MultiFab> derive_dat = amrlev.derive(vars[n], cumtime, 0);
+                s = amrex::get_slice_data(dir, coord, *derive_dat, Geom(lev), 0, 1);
+            }
+            if (n == 0) {
+                grid_slices.define(s->boxArray(), s->DistributionMap(), nvars, 0);
+            }
+            MultiFab::Copy(grid_slices, *s, 0, n, 1, 0);
+        }
+
+        //
+        // Merge the slices into a few boxes and move the data there.
+        //
+        BoxList bl = grid_slices.boxArray().boxList();
+        bl.simplify();
+        BoxArray ba(std::move(bl));
+        ba.maxSize(maxGridSize(lev));
+        MultiFab merged(ba, DistributionMapping(ba), nvars, 0);
+        merged.ParallelCopy(grid_slices, 0, 0, nvars);
+
+        BoxArray shifted_ba = ba;
+        shifted_ba.shift(dir, -islice);
+        slice.emplace_back(shifted_ba, merged.DistributionMap(), nvars, 0);
+#ifdef _OPENMP
+#pragma omp parallel if (Gpu::notInLaunchRegion())
+#endif
+        for (MFIter mfi(merged); mfi.isValid(); ++mfi)
+        {
+            slice[lev][mfi].copy<RunOn::Device>(merged[mfi], mfi.validbox(), 0,
+                                                amrex::shift(mfi.validbox(), dir, -islice), 0, nvars);
+        }
+
+        Box slice_domain = Geom(lev).Domain();
+        slice_domain.setRange(dir, 0);
+        slice_geom.emplace_back(slice_domain, slice_rb, Geom(lev).Coord(), is_per);
+
+        if (lev > 0) {
+            slice_ref_ratio.push_back(refRatio(lev-1));
+            slice_ref_ratio.back()[dir] = 1;
+        }
+    }
+
+    const int nlevs = slice.size();
+    amrex::WriteMultiLevelPlotfile(pltfile, nlevs, amrex::GetVecOfConstPtrs(slice), vars,
+                                   slice_geom, cumtime, level_steps, slice_ref_ratio);
+}
+
+void
+Amr::writeCoarsePlotFile ()
+{
+    if ( ! Plot_Files_Output()) {
+      return;
+    }
+
+    BL_PROFILE("Amr::writeCoarsePlotFile()");
+
+    const Vector<std::string> vars = subPlotVars(coarse_plot_vars);
+    const int nvars = vars.size();
+    if (nvars == 0) {
+      return;
+    }
+
+    const std::string& pltfile = amrex::Concatenate(coarse_plot_file_root,
+                                                    level_steps[0],
+                                                    file_name_digits);
+
+    if (verbose > 0) {
+	amrex::Print() << "COARSE PLOTFILE: file = " << pltfile << '\n';
+    }
+
+    if (record_run_info && ParallelDescriptor::IOProcessor()) {
+        runlog << "COARSE PLOTFILE: file = " << pltfile << '\n';
+    }
+
+    const int ratio = coarse_plot_ratio;
+
+    //
+    // The region in the index space of level 0, widened to whole coarsened cells.
+    //
+    const Geometry& geom0 = Geom(0);
+    IntVect region_lo, region_hi;
+    for (int d = 0; d < AMREX_SPACEDIM; ++d) {
+        const Real dx = geom0.CellSize(d);
+        region_lo[d] = static_cast<int>(std::floor((coarse_plot_region.lo(d) - geom0.ProbLo(d)) / dx));
+        region_hi[d] = static_cast<int>(std::ceil ((coarse_plot_region.hi(d) - geom0.ProbLo(d)) / dx)) - 1;
+    }
+    Box region(region_lo, region_hi);
+    region &= geom0.Domain();
+    region.coarsen(ratio);
+
+    Array<int,AMREX_SPACEDIM> is_per = geom0.isPeriodic();
+    RealBox crse_rb;
+    for (int d = 0; d < AMREX_SPACEDIM; ++d) {
+        const Real cdx = geom0.CellSize(d) * ratio;
+        crse_rb.setLo(d, geom0.ProbLo(d) + region.smallEnd(d)*cdx);
+        crse_rb.setHi(d, geom0.ProbLo(d) + (region.bigEnd(d)+1)*cdx);
+        if (region.length(d)*ratio != geom0.Domain().length(d)) {
+            is_per[d] = 0;
+        }
+    }
+
+    Vector<MultiFab> crse;
+    Vector<Geometry> crse_geom;
+
+    const int max_lev = std::min(coarse_plot_max_level, finest_level);
+    for (int lev = 0; lev <= max_lev; ++lev)
+    {
+        if (lev > 0) {
+            region.refine(refRatio(lev-1));
+        }
+
+        const BoxArray& fine_ba = boxArray(lev);
+        if ( ! fine_ba.coarsenable(ratio)) {
+            amrex::Abort("Amr::writeCoarsePlotFile: the grids of level " + std::to_string(lev)
+                         + " are not coarsenable by amr.coarse_plot_ratio");
+        }
+
+        BoxArray ba = amrex::intersect(amrex::coarsen(fine_ba, ratio), region);
+        if (ba.empty()) {
+            break;
+        }
+        ba.maxSize(maxGridSize(lev));
+
+        AmrLevel& amrlev = *amr_level[lev];
+        MultiFab fine(fine_ba, DistributionMap(lev), nvars, 0);
+        for (int n = 0; n < nvars; ++n) {
+            amrlev.derive(vars[n], cumtime, fine, n);
+        }
+
+        crse_geom.emplace_back(region, crse_rb, geom0.Coord(), is_per);
+        crse.emplace_back(ba, DistributionMapping(ba), nvars, 0);
+        amrex::average_down(fine, crse[lev], Geom(lev), crse_geom[lev], 0, nvars, ratio);
+    }
+
+    const int nlevs = crse.size();
+    amrex::WriteMultiLevelPlotfile(pltfile, nlevs, amrex::GetVecOfConstPtrs(crse), vars,
+                                   crse_geom, cumtime, level_steps, refRatio());
+}
+
+void
+Amr::writeDiagnostics (bool force)
+{
+    if (diagnostic_list.empty()) return;
+
+    BL_PROFILE("Amr::writeDiagnostics()");
+
+    bool dir_created = false;
+    for (auto const& diag : diagnostic_list)
+    {
+        const int interval = (diag.interval > 0) ? diag.interval : diag_int;
+        if ( ! force && (interval <= 0 || level_steps[0] % interval != 0)) {
+            continue;
+        }
+
+        const std::string file_name = diag_file_prefix + diag.name + ".dat";
+        if ( ! dir_created) {
+            // ---- Create the directory if the prefix has one.
+            const auto slash = diag_file_prefix.rfind('/');
+            if (slash != std::string::npos && ParallelDescriptor::IOProcessor()) {
+                if ( ! amrex::UtilCreateDirectory(diag_file_prefix.substr(0,slash), 0755)) {
+                    amrex::CreateDirectoryFailed(diag_file_prefix.substr(0,slash));
+                }
+            }
+            dir_created = true;
+        }
+
+        diag.evaluate(*this, file_name);
+    }
+}
+
 void
 Amr::writePlotFileDoit (std::string const& pltfile, bool regular)
 {
@@ -946,6 +1284,11 @@ Amr::writePlotFileDoit (std::string const& pltfile, bool regular)
     VisMF::SetNOutFiles(plot_nfiles);
     VisMF::Header::Version currentVersion(VisMF::GetHeaderVersion());
     VisMF::SetHeaderVersion(plot_headerversion);
+    Vector<Compression::Codec> currentCodecs(VisMF::GetCompressionCodecs());
+    Vector<Real> currentTolerances(VisMF::GetCompressionTolerances());
+    if( ! plot_compression.empty()) {
+        VisMF::SetCompression(plot_compression, plot_compression_tolerance);
+    }
 
     amrex::StreamRetry sretry(pltfile, abort_on_stream_retry_failure,
                               stream_max_tries);
@@ -1054,6 +1397,7 @@ Amr::writePlotFileDoit (std::string const& pltfile, bool regular)
     }  // end while
 
     VisMF::SetHeaderVersion(currentVersion);
+    VisMF::SetCompression(currentCodecs, currentTolerances);
 }
 
 void
@@ -1153,6 +1497,16 @@ Amr::init (Real strt_time,
             writeSmallPlotFile();
         }
 
+        if (slice_plot_int > 0) {
+            writeSlicePlotFile();
+        }
+
+        if (coarse_plot_int > 0) {
+            writeCoarsePlotFile();
+        }
+
+        writeDiagnostics();
+
         updateInSitu();
     }
 
@@ -1406,6 +1760,18 @@ Amr::restart (const std::string& filename)
         runlog << "RESTART from file = " << filename << '\n';
     }
 
+    // ---- a checkpoint written with staging must have been drained completely
+    {
+      Vector<char> stageStatus;
+      bool bExitOnError(false);  // ---- only staged checkpoints have this file
+      ParallelDescriptor::ReadAndBcastFile(filename + "/" + StageStatusFile, stageStatus,
+                                           bExitOnError);
+      if(stageStatus.size() > 0 && std::string(stageStatus.dataPtr()).compare(0, 8, "complete") != 0) {
+        amrex::Abort("Amr::restart(): " + filename + " was not completely drained from "
+                     "amrex.async_out_stage_dir; restart from an earlier checkpoint");
+      }
+    }
+
     // ---- preread and broadcast all FabArray headers if this file exists
     std::map<std::string, Vector<char> > faHeaderMap;
     if(prereadFAHeaders) {
@@ -1709,11 +2075,33 @@ Amr::checkPoint ()
 
     VisMF::Header::Version currentVersion(VisMF::GetHeaderVersion());
     VisMF::SetHeaderVersion(checkpoint_headerversion);
+    Vector<Compression::Codec> currentCodecs(VisMF::GetCompressionCodecs());
+    Vector<Real> currentTolerances(VisMF::GetCompressionTolerances());
+    if( ! checkpoint_compression.empty()) {
+        VisMF::SetCompression(checkpoint_compression);
+    }
+
+    //
+    // With AsyncOut staging, the previous checkpoint must be drained before
+    // this one is written.  This only waits if draining is slower than
+    // the checkpoint interval.
+    //
+    const bool staged = AsyncOut::UseAsyncOut() && AsyncOut::UseStaging();
+    FinishStagedCheckPoint();
 
     Real dCheckPointTime0 = amrex::second();
 
     const std::string& ckfile = amrex::Concatenate(check_file_root,level_steps[0],file_name_digits);
 
+    //
+    // Incremental checkpoints: the checkpoint_delta_interval checkpoints after
+    // a full one only write the FABs of the StateData that have changed.
+    //
+    const bool write_delta = checkpoint_delta_interval > 0 && checkpoint_delta_count >= 0 &&
+                             checkpoint_delta_count < checkpoint_delta_interval;
+    StateData::SetIncrementalCheckPoint(checkpoint_delta_interval > 0, write_delta,
+                                        ckfile.substr(ckfile.rfind('/') + 1));
+
     if(verbose > 0) {
 	amrex::Print() << "CHECKPOINT: file = " << ckfile << "\n";
     }
@@ -1753,6 +2141,10 @@ Amr::checkPoint ()
       amrex::UtilCreateCleanDirectory(ckfileTemp, true);  // call barrier
     }
 
+    if (staged) {
+        WriteStageStatus(ckfileTemp, "draining");
+    }
+
     std::string HeaderFileName = ckfileTemp + "/Header";
 
     VisMF::IO_Buffer io_buffer(VisMF::GetIOBufferSize());
@@ -1867,6 +2259,15 @@ Amr::checkPoint ()
   FArrayBox::setFormat(thePrevFormat);
 
   VisMF::SetHeaderVersion(currentVersion);
+  VisMF::SetCompression(currentCodecs, currentTolerances);
+
+  if (checkpoint_delta_interval > 0) {
+      checkpoint_delta_count = write_delta ? checkpoint_delta_count + 1 : 0;
+  }
+  if (staged) {
+      staged_checkpoint = ckfile;
+  }
+  StateData::SetIncrementalCheckPoint(false, false, std::string());
 
   BL_PROFILE_REGION_STOP("Amr::checkPoint()");
 }
@@ -2567,6 +2968,18 @@ Amr::coarseTimeStep (Real stop_time)
         writeSmallPlotFile();
     }
 
+    if (slice_plot_int > 0 && level_steps[0] % slice_plot_int == 0)
+    {
+        writeSlicePlotFile();
+    }
+
+    if (coarse_plot_int > 0 && level_steps[0] % coarse_plot_int == 0)
+    {
+        writeCoarsePlotFile();
+    }
+
+    writeDiagnostics();
+
     updateInSitu();
 
     bUserStopRequest = to_stop;
@@ -2875,7 +3288,7 @@ Amr::regrid (int  lbase,
             new_dmap[lev] = makeLoadBalanceDistributionMap(lev, time, new_grid_places[lev]);
         }
         else if (new_dmap[lev].empty()) {
-	    new_dmap[lev].define(new_grid_places[lev]);
+	    new_dmap[lev] = MakeDistributionMap(lev, new_grid_places[lev]);
 	}
 
         AmrLevel* a = (*levelbld)(*this,lev,Geom(lev),new_grid_places[lev],
@@ -3449,6 +3862,14 @@ Amr::initPltAndChk ()
     check_int = -1;
     pp.query("check_int",check_int);
 
+    //
+    // With amr.checkpoint_delta_interval = n > 0, each full checkpoint is
+    // followed by n incremental ones that only write the StateData FABs
+    // that changed since they were last written in full.  Restarting from
+    // an incremental checkpoint also needs the full one it refers to.
+    //
+    pp.query("checkpoint_delta_interval", checkpoint_delta_interval);
+
     check_per = -1.0;
     pp.query("check_per",check_per);
 
@@ -3497,6 +3918,85 @@ Amr::initPltAndChk ()
     write_plotfile_with_checkpoint = 1;
     pp.query("write_plotfile_with_checkpoint",write_plotfile_with_checkpoint);
 
+    //
+    // Slice and coarsened plotfiles, written every slice_plot_int and
+    // coarse_plot_int level 0 steps, e.g.,
+    //   amr.slice_plot_int = 1
+    //   amr.slice_plot_dir = 2
+    //   amr.slice_plot_coord = 0.5      # defaults to the center of the domain
+    //   amr.coarse_plot_int = 5
+    //   amr.coarse_plot_ratio = 4
+    //   amr.coarse_plot_region = 0.0 0.0 0.0 0.5 0.5 0.5   # lo and hi, defaults to the domain
+    //
+    slice_plot_file_root = "sliceplt";
+    pp.query("slice_plot_file",slice_plot_file_root);
+
+    slice_plot_int = -1;
+    pp.query("slice_plot_int",slice_plot_int);
+
+    slice_plot_dir = AMREX_SPACEDIM-1;
+    pp.query("slice_plot_dir",slice_plot_dir);
+    if (slice_plot_dir < 0 || slice_plot_dir >= AMREX_SPACEDIM) {
+        amrex::Abort("Amr::InitAmr: bad amr.slice_plot_dir");
+    }
+
+    slice_plot_coord = 0.5*(Geom(0).ProbLo(slice_plot_dir) + Geom(0).ProbHi(slice_plot_dir));
+    pp.query("slice_plot_coord",slice_plot_coord);
+    if (slice_plot_coord < Geom(0).ProbLo(slice_plot_dir) ||
+        slice_plot_coord >= Geom(0).ProbHi(slice_plot_dir)) {
+        amrex::Abort("Amr::InitAmr: amr.slice_plot_coord is outside the domain");
+    }
+
+    slice_plot_vars.clear();
+    pp.queryarr("slice_plot_vars",slice_plot_vars);
+
+    coarse_plot_file_root = "coarseplt";
+    pp.query("coarse_plot_file",coarse_plot_file_root);
+
+    coarse_plot_int = -1;
+    pp.query("coarse_plot_int",coarse_plot_int);
+
+    coarse_plot_ratio = 2;
+    pp.query("coarse_plot_ratio",coarse_plot_ratio);
+    if (coarse_plot_ratio < 1) {
+        amrex::Abort("Amr::InitAmr: bad amr.coarse_plot_ratio");
+    }
+
+    coarse_plot_max_level = 0;
+    pp.query("coarse_plot_max_lev",coarse_plot_max_level);
+
+    coarse_plot_region = Geom(0).ProbDomain();
+    if (pp.contains("coarse_plot_region")) {
+        Vector<Real> region;
+        pp.getarr("coarse_plot_region",region,0,2*AMREX_SPACEDIM);
+        coarse_plot_region = RealBox(region.data(), region.data()+AMREX_SPACEDIM);
+    }
+
+    coarse_plot_vars.clear();
+    pp.queryarr("coarse_plot_vars",coarse_plot_vars);
+
+    //
+    // In-situ diagnostics, e.g.,
+    //   amr.diagnostics = rho_avg
+    //   amr.diag_int = 10
+    //   amr.diag.rho_avg.type = planar_average
+    //   amr.diag.rho_avg.vars = density
+    // See AmrDiagnostic for the parameters of each diagnostic.
+    //
+    diag_int = -1;
+    pp.query("diag_int",diag_int);
+
+    diag_file_prefix = "diag_";
+    pp.query("diag_file_prefix",diag_file_prefix);
+
+    {
+      Vector<std::string> diag_names;
+      pp.queryarr("diagnostics", diag_names);
+      for (auto const& name : diag_names) {
+        addDiagnostic(AmrDiagnostic(name));
+      }
+    }
+
     stream_max_tries = 4;
     pp.query("stream_max_tries",stream_max_tries);
     stream_max_tries = std::max(stream_max_tries, 1);
@@ -3516,6 +4016,37 @@ Amr::initPltAndChk ()
     if(chvInt != checkpoint_headerversion) {
       checkpoint_headerversion = static_cast<VisMF::Header::Version> (chvInt);
     }
+
+    //
+    // Compression of the MultiFabs in plotfiles and checkpoints, e.g.,
+    //   amr.plot_compression = lossy
+    //   amr.plot_compression_tolerance = 1.e-8
+    //   amr.checkpoint_compression = lossless
+    // One entry per component is allowed; the last entry is used for the rest.
+    // Checkpoints must be restarted from exactly, so only lossless is allowed.
+    //
+    {
+      Vector<std::string> codecNames;
+      pp.queryarr("plot_compression", codecNames);
+      plot_compression.clear();
+      for(auto const& name : codecNames) {
+        plot_compression.push_back(Compression::CodecFromName(name));
+      }
+      pp.queryarr("plot_compression_tolerance", plot_compression_tolerance);
+      if( ! plot_compression.empty() && plot_compression_tolerance.empty()) {
+        plot_compression_tolerance.push_back(0.0);
+      }
+
+      codecNames.clear();
+      pp.queryarr("checkpoint_compression", codecNames);
+      checkpoint_compression.clear();
+      for(auto const& name : codecNames) {
+        checkpoint_compression.push_back(Compression::CodecFromName(name));
+        if(checkpoint_compression.back() == Compression::Lossy) {
+          amrex::Abort("amr.checkpoint_compression:  lossy compression is not allowed for checkpoints");
+        }
+      }
+    }
 }
 
 
@@ -0,0 +1,331 @@
+
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+
+#include <AMReX_AmrDiagnostics.H>
+#include <AMReX_Amr.H>
+#include <AMReX_AmrLevel.H>
+#include <AMReX_MultiFabUtil.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_Utility.H>
+
+namespace amrex {
+
+namespace {
+    //! The variables of the diagnostic on level lev.
+    MultiFab DiagnosticData (Amr& amr, int lev, const Vector<std::string>& vars)
+    {
+        AmrLevel& amrlev = amr.getLevel(lev);
+        MultiFab mf(amrlev.boxArray(), amrlev.DistributionMap(), vars.size(), 0);
+        for (int n = 0; n < vars.size(); ++n) {
+            amrlev.derive(vars[n], amr.cumTime(), mf, n);
+        }
+        Gpu::streamSynchronize();
+        return mf;
+    }
+
+    //! mf, in host memory for the reductions on the host below.
+    template <class MF>
+    MF OnHost (MF mf)
+    {
+#ifdef AMREX_USE_GPU
+        MF hmf(mf.boxArray(), mf.DistributionMap(), mf.nComp(), mf.nGrowVect(),
+               MFInfo().SetArena(The_Pinned_Arena()));
+        amrex::dtoh_memcpy(hmf, mf);
+        Gpu::streamSynchronize();
+        return hmf;
+#else
+        return mf;
+#endif
+    }
+
+    Real CellCenter (const Geometry& geom, int dir, int i)
+    {
+        return geom.ProbLo(dir) + (i + 0.5) * geom.CellSize(dir);
+    }
+}
+
+AmrDiagnostic::AmrDiagnostic (const std::string& a_name)
+    : name(a_name)
+{
+    ParmParse pp("amr.diag." + name);
+
+    std::string type_name;
+    pp.get("type", type_name);
+    type = TypeFromName(type_name);
+
+    if (pp.countval("vars") == 0) {
+        amrex::Abort("AmrDiagnostic: amr.diag." + name + ".vars must be given");
+    }
+    pp.getarr("vars", vars);
+
+    pp.query("int", interval);
+    pp.query("dir", dir);
+    pp.query("level", level);
+    pp.queryarr("point", point);
+    pp.query("nbins", nbins);
+
+    if (type == Histogram) {
+        Vector<Real> range;
+        pp.getarr("range", range, 0, 2);
+        lo = range[0];
+        hi = range[1];
+    }
+
+    if (dir < 0 || dir >= AMREX_SPACEDIM) {
+        amrex::Abort("AmrDiagnostic: bad amr.diag." + name + ".dir");
+    }
+    if (!point.empty() && point.size() != AMREX_SPACEDIM) {
+        amrex::Abort("AmrDiagnostic: amr.diag." + name + ".point must have AMREX_SPACEDIM values");
+    }
+    if (type == Histogram && (nbins <= 0 || hi <= lo)) {
+        amrex::Abort("AmrDiagnostic: bad amr.diag." + name + ".nbins or range");
+    }
+}
+
+AmrDiagnostic::Type
+AmrDiagnostic::TypeFromName (const std::string& type_name)
+{
+    for (int t = PlanarAverage; t <= Plane; ++t) {
+        if (type_name == TypeName(static_cast<Type>(t))) return static_cast<Type>(t);
+    }
+    amrex::Abort("AmrDiagnostic: unknown type " + type_name);
+    return VolumeIntegral;
+}
+
+std::string
+AmrDiagnostic::TypeName (Type a_type)
+{
+    switch (a_type) {
+    case PlanarAverage:  return "planar_average";
+    case VolumeIntegral: return "volume_integral";
+    case Histogram:      return "histogram";
+    case Line:           return "line";
+    case Plane:          return "plane";
+    }
+    return "";
+}
+
+void
+AmrDiagnostic::evaluate (Amr& amr, const std::string& file_name) const
+{
+    Vector<Geometry> geom;
+    Vector<BoxArray> grids;
+    Vector<IntVect> ref_ratio;
+    for (int lev = 0; lev <= amr.finestLevel(); ++lev) {
+        geom.push_back(amr.Geom(lev));
+        grids.push_back(amr.boxArray(lev));
+        if (lev < amr.finestLevel()) ref_ratio.push_back(amr.refRatio(lev));
+    }
+    evaluate(geom, grids, ref_ratio,
+             [&] (int lev) { return DiagnosticData(amr, lev, vars); },
+             amr.levelSteps(0), amr.cumTime(), file_name);
+}
+
+void
+AmrDiagnostic::evaluate (const Vector<Geometry>& geom, const Vector<BoxArray>& grids,
+                         const Vector<IntVect>& ref_ratio,
+                         const std::function<MultiFab(int)>& data,
+                         int step, Real time, const std::string& file_name) const
+{
+    BL_PROFILE("AmrDiagnostic::evaluate()");
+
+    const int nvars = vars.size();
+    const int finest_level = geom.size() - 1;
+    const int IOProc = ParallelDescriptor::IOProcessorNumber();
+
+    // ---- The results, summed over the processes on the IOProcessor.
+    Vector<Real> result;
+    // ---- For PlanarAverage, Line and Plane, the number of cells summed in each entry.
+    Vector<Real> count;
+    // ---- The index space and the coordinate directions of the entries.
+    Box region;
+    Vector<int> coord_dirs;
+    const int lev = std::min(level, finest_level);
+
+    if (type == VolumeIntegral || type == Histogram)
+    {
+        const int nentries = (type == Histogram) ? nvars*(nbins+2) : nvars;
+        result.resize(nentries, 0.0);
+        Real total_volume = 0.0;
+        const Real dbin = (hi - lo) / nbins;
+
+        for (int ilev = 0; ilev <= finest_level; ++ilev)
+        {
+            const MultiFab mf = OnHost(data(ilev));
+            const Real* dx = geom[ilev].CellSize();
+            const Real dv = AMREX_D_TERM(dx[0], *dx[1], *dx[2]);
+
+            // ---- Cells covered by the next finer level are excluded.
+            iMultiFab mask;
+            if (ilev < finest_level) {
+                mask = OnHost(amrex::makeFineMask(mf, grids[ilev+1], ref_ratio[ilev]));
+            }
+
+            for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+            {
+                const auto a = mf.const_array(mfi);
+                Array4<int const> m;
+                if (ilev < finest_level) m = mask.const_array(mfi);
+                amrex::LoopOnCpu(mfi.validbox(), [&] (int i, int j, int k)
+                {
+                    if (m && m(i,j,k)) return;
+                    total_volume += dv;
+                    for (int n = 0; n < nvars; ++n) {
+                        if (type == VolumeIntegral) {
+                            result[n] += a(i,j,k,n) * dv;
+                        } else {
+                            // ---- Bin 0 is the underflow and bin nbins+1 the
+                            // ---- overflow, which also get the infinities.
+                            // ---- The cast is only done on values in [lo,hi).
+                            const Real v = a(i,j,k,n);
+                            if (std::isnan(v)) continue;
+                            int b;
+                            if (v < lo) {
+                                b = 0;
+                            } else if (v >= hi) {
+                                b = nbins+1;
+                            } else {
+                                b = std::min(static_cast<int>((v-lo)/dbin), nbins-1) + 1;
+                            }
+                            result[n*(nbins+2)+b] += dv;
+                        }
+                    }
+                });
+            }
+        }
+
+        if (type == Histogram) {
+            result.push_back(total_volume);
+        }
+        ParallelDescriptor::ReduceRealSum(result.dataPtr(), result.size(), IOProc);
+        if (type == Histogram) {
+            total_volume = result.back();
+            result.pop_back();
+            for (auto& r : result) r /= total_volume;
+        }
+    }
+    else
+    {
+        const Box& domain = geom[lev].Domain();
+
+        IntVect ipoint;
+        for (int d = 0; d < AMREX_SPACEDIM; ++d) {
+            const Real x = point.empty() ? 0.5*(geom[lev].ProbLo(d) + geom[lev].ProbHi(d))
+                                         : point[d];
+            ipoint[d] = static_cast<int>(std::floor((x - geom[lev].ProbLo(d)) / geom[lev].CellSize(d)));
+            ipoint[d] = std::max(domain.smallEnd(d), std::min(domain.bigEnd(d), ipoint[d]));
+        }
+
+        // ---- The cells are summed into the entries of region.  For
+        // ---- PlanarAverage all the directions but dir are collapsed.
+        region = domain;
+        IntVect collapse(0);
+        if (type == PlanarAverage) {
+            coord_dirs.push_back(dir);
+            for (int d = 0; d < AMREX_SPACEDIM; ++d) {
+                if (d != dir) {
+                    region.setRange(d, domain.smallEnd(d));
+                    collapse[d] = 1;
+                }
+            }
+        } else if (type == Line) {
+            coord_dirs.push_back(dir);
+            for (int d = 0; d < AMREX_SPACEDIM; ++d) {
+                if (d != dir) region.setRange(d, ipoint[d]);
+            }
+        } else {
+            for (int d = 0; d < AMREX_SPACEDIM; ++d) {
+                if (d != dir) coord_dirs.push_back(d);
+            }
+            region.setRange(dir, ipoint[dir]);
+        }
+
+        const Long npts = region.numPts();
+        result.resize(npts*nvars, 0.0);
+        count.resize(npts, 0.0);
+
+        const MultiFab mf = OnHost(data(lev));
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+        {
+            Box bx = mfi.validbox();
+            if (type != PlanarAverage) {
+                bx &= region;
+                if (!bx.ok()) continue;
+            }
+            const auto a = mf.const_array(mfi);
+            amrex::LoopOnCpu(bx, [&] (int i, int j, int k)
+            {
+                IntVect iv(AMREX_D_DECL(i,j,k));
+                for (int d = 0; d < AMREX_SPACEDIM; ++d) {
+                    if (collapse[d]) iv[d] = region.smallEnd(d);
+                }
+                const Long idx = region.index(iv);
+                count[idx] += 1.0;
+                for (int n = 0; n < nvars; ++n) {
+                    result[idx*nvars+n] += a(i,j,k,n);
+                }
+            });
+        }
+
+        ParallelDescriptor::ReduceRealSum(result.dataPtr(), result.size(), IOProc);
+        ParallelDescriptor::ReduceRealSum(count.dataPtr(), count.size(), IOProc);
+    }
+
+    if (ParallelDescriptor::IOProcessor())
+    {
+        const bool new_file = !amrex::FileExists(file_name);
+        std::ofstream ofs(file_name.c_str(), std::ios::out | std::ios::app);
+        if (!ofs.good()) amrex::FileOpenFailed(file_name);
+        ofs << std::setprecision(std::numeric_limits<Real>::max_digits10);
+
+        const char* xyz[] = {"x", "y", "z"};
+        if (new_file) {
+            ofs << "# " << name << ": " << TypeName(type);
+            if (type != VolumeIntegral && type != Histogram) {
+                ofs << " on level " << lev << ", dir = " << dir;
+            }
+            if (type == Histogram) {
+                ofs << " of " << nbins << " bins in [" << lo << ", " << hi
+                    << "), underflow first and overflow last";
+            }
+            ofs << '\n' << "# step time";
+            if (type == Histogram) {
+                ofs << " variable fractions";
+            } else {
+                for (int d : coord_dirs) ofs << ' ' << xyz[d];
+                for (const auto& v : vars) ofs << ' ' << v;
+            }
+            ofs << '\n';
+        }
+
+        if (type == VolumeIntegral) {
+            ofs << step << ' ' << time;
+            for (int n = 0; n < nvars; ++n) ofs << ' ' << result[n];
+            ofs << '\n';
+        } else if (type == Histogram) {
+            for (int n = 0; n < nvars; ++n) {
+                ofs << step << ' ' << time << ' ' << vars[n];
+                for (int b = 0; b < nbins+2; ++b) ofs << ' ' << result[n*(nbins+2)+b];
+                ofs << '\n';
+            }
+        } else {
+            // ---- One block per evaluation, separated by blank lines.
+            for (Long idx = 0; idx < count.size(); ++idx) {
+                if (count[idx] == 0.0) continue;
+                const IntVect iv = region.atOffset(idx);
+                ofs << step << ' ' << time;
+                for (int d : coord_dirs) ofs << ' ' << CellCenter(geom[lev], d, iv[d]);
+                for (int n = 0; n < nvars; ++n) ofs << ' ' << result[idx*nvars+n] / count[idx];
+                ofs << '\n';
+            }
+            ofs << "\n\n";
+        }
+
+        if (!ofs.good()) amrex::Abort("AmrDiagnostic: problem writing " + file_name);
+    }
+}
+
+}
@@ -2,6 +2,9 @@
 #include <iostream>
 #include <limits>
 #include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
 
 #include <AMReX_RealBox.H>
 #include <AMReX_StateData.H>
@@ -26,6 +29,51 @@ static constexpr int MFOLDDATA = 1;
 
 Vector<std::string> StateData::fabArrayHeaderNames;
 std::map<std::string, Vector<char> > *StateData::faHeaderMap;
+bool StateData::chkIncremental = false;
+bool StateData::chkWriteDelta = false;
+std::string StateData::chkName;
+
+namespace {
+    const std::string DeltaSuffix("_Delta");
+
+    //! A 64-bit hash of the bytes of a FAB.
+    std::uint64_t FabHash (const FArrayBox& fab)
+    {
+        const char* p = reinterpret_cast<const char*>(fab.dataPtr());
+        const std::size_t nbytes = fab.nBytes();
+#ifdef AMREX_USE_GPU
+        Vector<char> hbuf;
+        if (fab.arena()->isManaged() || fab.arena()->isDevice()) {
+            hbuf.resize(nbytes);
+            Gpu::dtoh_memcpy(hbuf.data(), p, nbytes);
+            p = hbuf.data();
+        }
+#endif
+        constexpr std::uint64_t m = 0x9E3779B97F4A7C15ULL;
+        std::uint64_t h = nbytes * m;
+        std::size_t i = 0;
+        for ( ; i + sizeof(std::uint64_t) <= nbytes; i += sizeof(std::uint64_t)) {
+            std::uint64_t w;
+            std::memcpy(&w, p+i, sizeof(w));
+            h = (h ^ w) * m;
+            h ^= h >> 29;
+        }
+        for ( ; i < nbytes; ++i) {
+            h = (h ^ static_cast<unsigned char>(p[i])) * m;
+        }
+        h ^= h >> 32;
+        return h;
+    }
+
+    Vector<std::uint64_t> FabHashes (const MultiFab& mf)
+    {
+        Vector<std::uint64_t> hash(mf.size(), 0);
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
+            hash[mfi.index()] = FabHash(mf[mfi]);
+        }
+        return hash;
+    }
+}
 
 
 StateData::StateData () 
@@ -57,7 +105,8 @@ StateData::StateData (StateData&& rhs) noexcept
       old_time(rhs.old_time),
       new_data(std::move(rhs.new_data)),
       old_data(std::move(rhs.old_data)),
-      arena(rhs.arena)
+      arena(rhs.arena),
+      chk_hashes{std::move(rhs.chk_hashes[0]), std::move(rhs.chk_hashes[1])}
 {   
 }
 
@@ -273,10 +322,82 @@ StateData::restartDoit (std::istream& is, const std::string& chkfile)
 	}
       }
 
-      VisMF::Read(*whichMF, FullPathName, faHeader);
+      readCheckPointMF(*whichMF, chkfile, mf_name, faHeader);
     }
 }
 
+void
+StateData::readCheckPointMF (MultiFab& mf, const std::string& chkfile,
+                             const std::string& mf_name, const char* faHeader)
+{
+    std::string FullPathName(chkfile);
+    if ( ! chkfile.empty() && chkfile[chkfile.length()-1] != '/') {
+        FullPathName += '/';
+    }
+    FullPathName += mf_name;
+
+    Vector<char> deltaChars;
+    bool bExitOnError(false);  // ---- only incremental checkpoints have this file
+    ParallelDescriptor::ReadAndBcastFile(FullPathName + DeltaSuffix, deltaChars, bExitOnError);
+    if (deltaChars.empty()) {
+        VisMF::Read(mf, FullPathName, faHeader);
+        return;
+    }
+
+    //
+    // The FABs that changed since the full MultiFab was written.
+    // The full MultiFab is in the checkpoint base next to chkfile.
+    //
+    std::istringstream is(std::string(deltaChars.dataPtr()), std::istringstream::in);
+    std::string base;
+    int nchanged(0);
+    is >> base >> nchanged;
+    Vector<int> changed(nchanged);
+    for (int i = 0; i < nchanged; ++i) {
+        is >> changed[i];
+    }
+    if ( ! is) {
+        amrex::Abort("StateData::restart: bad file " + FullPathName + DeltaSuffix);
+    }
+
+    std::string basechk(chkfile);
+    while ( ! basechk.empty() && basechk.back() == '/') {
+        basechk.pop_back();
+    }
+    const std::size_t slash = basechk.rfind('/');
+    basechk = (slash == std::string::npos) ? base : basechk.substr(0, slash+1) + base;
+    if (basechk == chkfile) {
+        amrex::Abort("StateData::restart: " + FullPathName + " is a delta of itself");
+    }
+
+    readCheckPointMF(mf, basechk, mf_name, nullptr);
+
+    if (nchanged > 0)
+    {
+        BoxList bl(mf.boxArray().ixType());
+        Vector<int> pmap(nchanged);
+        for (int i = 0; i < nchanged; ++i) {
+            bl.push_back(mf.boxArray()[changed[i]]);
+            pmap[i] = mf.DistributionMap()[changed[i]];
+        }
+        MultiFab delta(BoxArray(std::move(bl)), DistributionMapping(std::move(pmap)),
+                       mf.nComp(), mf.nGrowVect());
+        VisMF::Read(delta, FullPathName, faHeader);
+        for (MFIter mfi(delta); mfi.isValid(); ++mfi) {
+            mf[changed[mfi.index()]].copy<RunOn::Device>(delta[mfi]);
+        }
+    }
+}
+
+void
+StateData::SetIncrementalCheckPoint (bool incremental, bool write_delta,
+                                     const std::string& chkname)
+{
+    chkIncremental = incremental;
+    chkWriteDelta = incremental && write_delta;
+    chkName = chkname;
+}
+
 void 
 StateData::restart (const StateDescriptor& d,
 		    const StateData& rhs)
@@ -782,14 +903,52 @@ StateData::checkPoint (const std::string& name,
         dump_old = false;
     }
 
+    const int nsets = desc->store_in_checkpoint() ? (dump_old ? 2 : 1) : 0;
+    const MultiFab* mfs[2] = { new_data.get(), old_data.get() };
+    const std::string suffix[2] = { NewSuffix, OldSuffix };
+
+    //
+    // With incremental checkpoints, a MultiFab is written as a delta if it
+    // has hashes from an earlier full write, otherwise its hashes are reset.
+    // changed[i] holds the global indices of the FABs to write.
+    //
+    bool delta[2] = { false, false };
+    Vector<int> changed[2];
+    if (chkIncremental)
+    {
+        for (int i = 0; i < nsets; ++i)
+        {
+            Vector<std::uint64_t> hash = FabHashes(*mfs[i]);
+            CheckPointHashes& h = chk_hashes[i];
+            if (chkWriteDelta && ! h.base.empty() && h.base != chkName &&
+                h.grids == grids && h.dmap == dmap)
+            {
+                delta[i] = true;
+                Vector<int> is_changed(hash.size(), 0);
+                for (MFIter mfi(*mfs[i]); mfi.isValid(); ++mfi) {
+                    const int k = mfi.index();
+                    is_changed[k] = (hash[k] != h.hash[k]);
+                }
+                ParallelDescriptor::ReduceIntSum(is_changed.dataPtr(), is_changed.size());
+                for (int k = 0, N = is_changed.size(); k < N; ++k) {
+                    if (is_changed[k]) changed[i].push_back(k);
+                }
+            }
+            else
+            {
+                h.base = chkName;
+                h.grids = grids;
+                h.dmap = dmap;
+                h.hash = std::move(hash);
+            }
+        }
+    }
+
     if (ParallelDescriptor::IOProcessor())
     {
         //
         // The relative name gets written to the Header file.
         //
-        std::string mf_name_old(name + OldSuffix);
-        std::string mf_name_new(name + NewSuffix);
-
         os << domain << '\n';
 
         grids.writeOn(os);
@@ -799,46 +958,67 @@ StateData::checkPoint (const std::string& name,
            << new_time.start << '\n'
            << new_time.stop  << '\n';
 
-        if (desc->store_in_checkpoint()) 
-        {
-           if (dump_old)
-           {
-               os << 2 << '\n' << mf_name_new << '\n' << mf_name_old << '\n';
-	       fabArrayHeaderNames.push_back(mf_name_new);
-	       fabArrayHeaderNames.push_back(mf_name_old);
-           }
-           else
-           {
-               os << 1 << '\n' << mf_name_new << '\n';
-	       fabArrayHeaderNames.push_back(mf_name_new);
-           }
-        }
-        else
+        os << nsets << '\n';
+        for (int i = 0; i < nsets; ++i)
         {
-               os << 0 << '\n';
+            const std::string mf_name(name + suffix[i]);
+            os << mf_name << '\n';
+            if ( ! delta[i] || ! changed[i].empty()) {
+                fabArrayHeaderNames.push_back(mf_name);
+            }
         }
     }
 
-    if (desc->store_in_checkpoint())
+    for (int i = 0; i < nsets; ++i)
     {
-       BL_ASSERT(new_data);
-       std::string mf_fullpath_new(fullpathname + NewSuffix);
-       if (AsyncOut::UseAsyncOut()) {
-           VisMF::AsyncWrite(*new_data,mf_fullpath_new);
-       } else {
-           VisMF::Write(*new_data,mf_fullpath_new,how);
-       }
-
-       if (dump_old)
-       {
-           BL_ASSERT(old_data);
-           std::string mf_fullpath_old(fullpathname + OldSuffix);
-           if (AsyncOut::UseAsyncOut()) {
-               VisMF::AsyncWrite(*old_data,mf_fullpath_old);
-           } else {
-               VisMF::Write(*old_data,mf_fullpath_old,how);
-           }
-       }
+        BL_ASSERT(mfs[i]);
+        std::string mf_fullpath(fullpathname + suffix[i]);
+        if ( ! delta[i])
+        {
+            if (AsyncOut::UseAsyncOut()) {
+                VisMF::AsyncWrite(*mfs[i],mf_fullpath);
+            } else {
+                VisMF::Write(*mfs[i],mf_fullpath,how);
+            }
+            continue;
+        }
+
+        if (ParallelDescriptor::IOProcessor())
+        {
+            std::string DeltaFileName(mf_fullpath + DeltaSuffix);
+            std::ofstream DeltaFile(DeltaFileName.c_str(), std::ios::out | std::ios::trunc);
+            if ( ! DeltaFile.good()) {
+                amrex::FileOpenFailed(DeltaFileName);
+            }
+            DeltaFile << chk_hashes[i].base << '\n' << changed[i].size() << '\n';
+            for (int k : changed[i]) {
+                DeltaFile << k << '\n';
+            }
+            if ( ! DeltaFile.good()) {
+                amrex::Error("StateData::checkPoint() failed to write " + DeltaFileName);
+            }
+        }
+
+        if ( ! changed[i].empty())
+        {
+            const int nchanged = changed[i].size();
+            BoxList bl(grids.ixType());
+            Vector<int> pmap(nchanged);
+            for (int k = 0; k < nchanged; ++k) {
+                bl.push_back(grids[changed[i][k]]);
+                pmap[k] = dmap[changed[i][k]];
+            }
+            MultiFab mf(BoxArray(std::move(bl)), DistributionMapping(std::move(pmap)),
+                        mfs[i]->nComp(), mfs[i]->nGrowVect());
+            for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
+                mf[mfi].copy<RunOn::Device>((*mfs[i])[changed[i][mfi.index()]]);
+            }
+            if (AsyncOut::UseAsyncOut()) {
+                VisMF::AsyncWrite(std::move(mf),mf_fullpath);
+            } else {
+                VisMF::Write(mf,mf_fullpath,how);
+            }
+        }
     }
 }
 
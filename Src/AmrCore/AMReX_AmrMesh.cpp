@@ -354,6 +354,9 @@ AmrMesh::InitAmrMesh (int max_level_in, const Vector<int>& n_cell_in,
 	pp.query("refine_grid_layout", refine_grid_layout);
     }
 
+    pp.query("incremental_regrid", incremental_regrid);
+    pp.query("incremental_efficiency", incremental_efficiency);
+
     pp.query("check_input", check_input);
 
     finest_level = -1;
@@ -436,6 +439,21 @@ AmrMesh::ChopGrids (int lev, BoxArray& ba, int target_size) const
     }
 }
 
+DistributionMapping
+AmrMesh::MakeDistributionMap (int lev, const BoxArray& ba) const
+{
+    if (incremental_regrid && lev <= finest_level && lev < static_cast<int>(grids.size())
+        && !grids[lev].empty() && !dmap[lev].empty())
+    {
+        return DistributionMapping::makeIncremental(ba, grids[lev], dmap[lev],
+                                                    incremental_efficiency);
+    }
+    else
+    {
+        return DistributionMapping(ba);
+    }
+}
+
 BoxArray
 AmrMesh::MakeBaseGrids () const
 {
@@ -863,7 +881,7 @@ AmrMesh::MakeNewGrids (Real time)
 	        for (int lev = 1; lev <= new_finest; ++lev) {
 		    if (new_grids[lev] != grids[lev]) {
 		        grids_the_same = false;
-		        DistributionMapping dm(new_grids[lev]);
+		        DistributionMapping dm = MakeDistributionMap(lev, new_grids[lev]);
                         const auto old_num_setdm = num_setdm;
 
                         MakeNewLevelFromScratch(lev, time, new_grids[lev], dm);
@@ -1053,6 +1071,8 @@ std::ostream& operator<< (std::ostream& os, AmrMesh const& amr_mesh)
     os << "  use_fixed_upto_level = " << amr_mesh.use_fixed_upto_level << "\n";
     os << "  use_fixed_coarse_grids = " << amr_mesh.use_fixed_coarse_grids << "\n";
     os << "  refine_grid_layout = " << amr_mesh.refine_grid_layout << "\n";
+    os << "  incremental_regrid = " << amr_mesh.incremental_regrid << "\n";
+    os << "  incremental_efficiency = " << amr_mesh.incremental_efficiency << "\n";
     os << "  check_input = " << amr_mesh.check_input  << "\n";
     os << "  use_new_chop = " << amr_mesh.use_new_chop << "\n";
     os << "  iterate_on_new_grids = " << amr_mesh.iterate_on_new_grids << "\n";
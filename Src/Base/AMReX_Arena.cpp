@@ -4,6 +4,8 @@
 #include <AMReX_CArena.H>
 #include <AMReX_DArena.H>
 #include <AMReX_EArena.H>
+#include <AMReX_TArena.H>
+#include <AMReX_ArenaTrace.H>
 
 #include <AMReX.H>
 #include <AMReX_Print.H>
@@ -11,6 +13,8 @@
 #include <AMReX_ParmParse.H>
 #include <AMReX_Gpu.H>
 
+#include <algorithm>
+
 #ifdef _WIN32
 ///#include <memoryapi.h>
 //#define AMREX_MLOCK(x,y) VirtualLock(x,y)
@@ -43,9 +47,41 @@ namespace {
     bool the_arena_is_managed = true;
 #endif
     bool abort_on_out_of_gpu_memory = false;
+    bool use_thread_cache_arena = false;
+    Long thread_cache_size = 0L;
+    bool use_huge_pages = false;
+    bool use_first_touch = false;
+
+    Arena* untraced (Arena* a)
+    {
+        TraceArena* t = dynamic_cast<TraceArena*>(a);
+        return t ? t->arena() : a;
+    }
+
+    void* allocate_host (std::size_t nbytes, ArenaInfo const& info)
+    {
+        void* p;
+#ifndef _WIN32
+        // Smaller allocations would each waste most of a huge page
+        if (info.use_huge_pages && nbytes >= Arena::huge_page_size)
+        {
+            if (posix_memalign(&p, Arena::huge_page_size, nbytes) != 0) p = nullptr;
+#ifdef MADV_HUGEPAGE
+            if (p) madvise(p, nbytes, MADV_HUGEPAGE);
+#endif
+        }
+        else
+#endif
+        {
+            p = std::malloc(nbytes);
+        }
+        if (p && info.device_use_hostalloc) AMREX_MLOCK(p, nbytes);
+        return p;
+    }
 }
 
 const std::size_t Arena::align_size;
+const std::size_t Arena::huge_page_size;
 
 Arena::~Arena () {}
 
@@ -68,8 +104,7 @@ Arena::allocate_system (std::size_t nbytes)
 #ifdef AMREX_USE_GPU
     if (arena_info.use_cpu_memory)
     {
-        p = std::malloc(nbytes);
-        if (p && arena_info.device_use_hostalloc) AMREX_MLOCK(p, nbytes);
+        p = allocate_host(nbytes, arena_info);
     }
     else if (arena_info.device_use_hostalloc)
     {
@@ -113,8 +148,7 @@ Arena::allocate_system (std::size_t nbytes)
         }
     }
 #else
-    p = std::malloc(nbytes);
-    if (p && arena_info.device_use_hostalloc) AMREX_MLOCK(p, nbytes);
+    p = allocate_host(nbytes, arena_info);
 #endif
     if (p == nullptr) amrex::Abort("Sorry, malloc failed");
     return p;
@@ -167,7 +201,26 @@ Arena::Initialize ()
     pp.query("the_arena_init_size", the_arena_init_size);
     pp.query("the_arena_is_managed", the_arena_is_managed);
     pp.query("abort_on_out_of_gpu_memory", abort_on_out_of_gpu_memory);
+    pp.query("use_thread_cache_arena", use_thread_cache_arena);
+    pp.query("thread_cache_size", thread_cache_size);
+    pp.query("use_huge_pages", use_huge_pages);
+    pp.query("use_first_touch", use_first_touch);
 
+#ifndef AMREX_USE_GPU
+    ArenaInfo cpu_info = ArenaInfo().SetCpuMemory();
+    if (use_huge_pages) cpu_info.SetHugePages();
+    if (use_first_touch) cpu_info.SetFirstTouch();
+
+    if (use_thread_cache_arena)
+    {
+        the_arena = new TArena(0, static_cast<std::size_t>(std::max(thread_cache_size,0L)), cpu_info);
+    }
+    else if (use_huge_pages || use_first_touch)
+    {
+        the_arena = new BArena(cpu_info);
+    }
+    else
+#endif
 #ifdef AMREX_USE_GPU
     if (use_buddy_allocator)
     {
@@ -241,6 +294,16 @@ Arena::Initialize ()
     the_pinned_arena->free(p);
 
     the_cpu_arena = new BArena;
+
+    ArenaTrace::Initialize();
+    if (ArenaTrace::Enabled())
+    {
+        the_arena = new TraceArena(the_arena, 0);
+        the_device_arena = new TraceArena(the_device_arena, 1);
+        the_managed_arena = new TraceArena(the_managed_arena, 2);
+        the_pinned_arena = new TraceArena(the_pinned_arena, 3);
+        the_cpu_arena = new TraceArena(the_cpu_arena, 4);
+    }
 }
 
 void
@@ -274,25 +337,29 @@ Arena::PrintUsage ()
     }
 #endif
     if (The_Arena()) {
-        CArena* p = dynamic_cast<CArena*>(The_Arena());
+        CArena* p = dynamic_cast<CArena*>(untraced(The_Arena()));
         if (p) {
             p->PrintUsage("The         Arena");
         }
+        TArena* pt = dynamic_cast<TArena*>(untraced(The_Arena()));
+        if (pt) {
+            pt->PrintUsage("The         Arena");
+        }
     }
     if (The_Device_Arena()) {
-        CArena* p = dynamic_cast<CArena*>(The_Device_Arena());
+        CArena* p = dynamic_cast<CArena*>(untraced(The_Device_Arena()));
         if (p) {
             p->PrintUsage("The  Device Arena");
         }
     }
     if (The_Managed_Arena()) {
-        CArena* p = dynamic_cast<CArena*>(The_Managed_Arena());
+        CArena* p = dynamic_cast<CArena*>(untraced(The_Managed_Arena()));
         if (p) {
             p->PrintUsage("The Managed Arena");
         }
     }
     if (The_Pinned_Arena()) {
-        CArena* p = dynamic_cast<CArena*>(The_Pinned_Arena());
+        CArena* p = dynamic_cast<CArena*>(untraced(The_Pinned_Arena()));
         if (p) {
             p->PrintUsage("The  Pinned Arena");
         }
@@ -309,7 +376,9 @@ Arena::Finalize ()
 #endif
         PrintUsage();
     }
-    
+
+    ArenaTrace::Finalize();
+
     initialized = false;
     
     delete the_arena;
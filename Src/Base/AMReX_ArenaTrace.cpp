@@ -0,0 +1,349 @@
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
+#include <AMReX_ArenaTrace.H>
+#include <AMReX_ParallelDescriptor.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_Print.H>
+#include <AMReX_Utility.H>
+
+namespace amrex {
+
+std::atomic<bool> ArenaTrace::s_enabled{false};
+
+namespace {
+
+    constexpr char trace_magic[] = "AMRXTRC1";
+    constexpr char trace_end_magic[] = "AMRXTEND";
+    constexpr std::size_t trace_buffer_size = 65536;
+
+    struct RegionStats
+    {
+        Long nalloc = 0;     // number of allocations
+        Long allocated = 0;  // bytes allocated in total
+        Long live = 0;       // bytes currently allocated
+        Long peak = 0;       // maximum of live
+    };
+
+    struct TraceState
+    {
+        std::mutex mutex;
+        double t_start = 0.0;
+        std::string file_name;
+        std::ofstream ofs;
+        std::vector<ArenaTrace::Event> buffer;
+        Long nevents = 0;
+
+        std::map<std::string,int> region_ids;
+        std::vector<std::string> region_names;
+        std::vector<int> region_stack;
+        std::vector<RegionStats> regions;
+
+        std::unordered_map<void*,std::pair<std::size_t,int> > live_ptrs;
+        Long total_live = 0;
+        Long total_hwm = 0;
+        std::vector<Long> live_at_hwm;
+
+        //! Everything but the mutex back to the initial state.
+        void clear ()
+        {
+            t_start = 0.0;
+            file_name.clear();
+            buffer = std::vector<ArenaTrace::Event>();
+            nevents = 0;
+            region_ids.clear();
+            region_names = std::vector<std::string>();
+            region_stack = std::vector<int>();
+            regions = std::vector<RegionStats>();
+            live_ptrs = std::unordered_map<void*,std::pair<std::size_t,int> >();
+            total_live = 0;
+            total_hwm = 0;
+            live_at_hwm = std::vector<Long>();
+        }
+
+        int regionID (const std::string& name)
+        {
+            auto it = region_ids.find(name);
+            if (it != region_ids.end()) return it->second;
+            int id = region_names.size();
+            region_ids.insert(std::make_pair(name, id));
+            region_names.push_back(name);
+            regions.emplace_back();
+            return id;
+        }
+
+        void flush ()
+        {
+            if (ofs.is_open() && !buffer.empty()) {
+                ofs.write(reinterpret_cast<const char*>(buffer.data()),
+                          buffer.size()*sizeof(ArenaTrace::Event));
+            }
+            buffer.clear();
+        }
+
+        void record (std::int64_t nbytes, int region, int arena)
+        {
+            if (ofs.is_open()) {
+                ArenaTrace::Event e;
+                e.time = ParallelDescriptor::second() - t_start;
+                e.nbytes = nbytes;
+                e.region_live = regions[region].live;
+                e.region = region;
+                e.arena = arena;
+                buffer.push_back(e);
+                ++nevents;
+                if (buffer.size() >= trace_buffer_size) flush();
+            }
+        }
+    };
+
+    // Allocated by the first Initialize and never freed, because other
+    // threads may still reach it after Finalize.
+    TraceState* trace_state = nullptr;
+
+    void PrintSummary (const TraceState& ts)
+    {
+        Vector<std::string> localNames, syncedNames;
+        bool alreadySynced;
+        for (int i = 0, N = ts.region_names.size(); i < N; ++i) {
+            if (ts.regions[i].nalloc > 0) localNames.push_back(ts.region_names[i]);
+        }
+        amrex::SyncStrings(localNames, syncedNames, alreadySynced);
+        const Vector<std::string>& names = alreadySynced ? localNames : syncedNames;
+
+        const int n = names.size();
+        Vector<Long> sums(2*n, 0L);
+        Vector<Long> maxs(3*n+1, 0L);
+        for (int i = 0; i < n; ++i) {
+            auto it = ts.region_ids.find(names[i]);
+            if (it != ts.region_ids.end()) {
+                const int id = it->second;
+                const RegionStats& rs = ts.regions[id];
+                sums[2*i  ] = rs.nalloc;
+                sums[2*i+1] = rs.allocated;
+                maxs[3*i  ] = rs.peak;
+                maxs[3*i+1] = (id < static_cast<int>(ts.live_at_hwm.size()))
+                    ? ts.live_at_hwm[id] : 0L;
+                maxs[3*i+2] = rs.live;
+            }
+        }
+        maxs[3*n] = ts.total_hwm;
+        Long hwm_min = ts.total_hwm;
+
+        const int ioproc = ParallelDescriptor::IOProcessorNumber();
+        ParallelDescriptor::ReduceLongSum(sums.data(), sums.size(), ioproc);
+        ParallelDescriptor::ReduceLongMax(maxs.data(), maxs.size(), ioproc);
+        ParallelDescriptor::ReduceLongMin(hwm_min, ioproc);
+
+        if (!ParallelDescriptor::IOProcessor()) return;
+
+        std::vector<int> order(n);
+        for (int i = 0; i < n; ++i) order[i] = i;
+        std::sort(order.begin(), order.end(), [&] (int a, int b)
+                  { return maxs[3*a+1] > maxs[3*b+1]; });
+
+        constexpr double MB = 1024.*1024.;
+        int wname = 6;
+        for (auto const& s : names) wname = std::max(wname, static_cast<int>(s.size()));
+        wname += 2;
+
+        amrex::Print() << "\nArena trace: high-water mark of a process [min ... max] "
+                       << std::fixed << std::setprecision(2)
+                       << hwm_min/MB << " ... " << maxs[3*n]/MB << " MB\n"
+                       << "Allocs and Allocated are summed over processes; the others are"
+                       << " the maxima over processes.\n"
+                       << "At HWM is the memory live when the process reached its"
+                       << " high-water mark.\n\n";
+
+        std::ostringstream os;
+        os << std::fixed << std::setprecision(2);
+        os << std::setw(wname) << std::left << "Region" << std::right
+           << std::setw(12) << "Allocs"
+           << std::setw(16) << "Allocated(MB)"
+           << std::setw(12) << "Peak(MB)"
+           << std::setw(12) << "At HWM(MB)"
+           << std::setw(14) << "At end(MB)" << "\n";
+        os << std::string(wname+66, '-') << "\n";
+        for (int i : order) {
+            os << std::setw(wname) << std::left << names[i] << std::right
+               << std::setw(12) << sums[2*i]
+               << std::setw(16) << sums[2*i+1]/MB
+               << std::setw(12) << maxs[3*i]/MB
+               << std::setw(12) << maxs[3*i+1]/MB
+               << std::setw(14) << maxs[3*i+2]/MB << "\n";
+        }
+        os << std::string(wname+66, '-') << "\n";
+        amrex::Print() << os.str() << std::endl;
+    }
+}
+
+void
+ArenaTrace::Initialize ()
+{
+    int trace = 0;
+    std::string file_name = "arena_trace";
+    ParmParse pp("amrex");
+    pp.query("arena_trace", trace);
+    pp.query("arena_trace_file", file_name);
+
+    if (trace == 0) return;
+
+    if (trace_state == nullptr) trace_state = new TraceState;
+    trace_state->t_start = ParallelDescriptor::second();
+    trace_state->regionID("main");
+    trace_state->buffer.reserve(trace_buffer_size);
+    if (!file_name.empty()) {
+        trace_state->file_name = amrex::Concatenate(file_name+"_", ParallelDescriptor::MyProc(), 5);
+        trace_state->ofs.open(trace_state->file_name.c_str(),
+                              std::ios::out | std::ios::trunc | std::ios::binary);
+        if (!trace_state->ofs.good()) {
+            amrex::FileOpenFailed(trace_state->file_name);
+        }
+        trace_state->ofs.write(trace_magic, 8);
+    }
+
+    s_enabled.store(true, std::memory_order_release);
+}
+
+void
+ArenaTrace::Finalize ()
+{
+    if (!Enabled()) return;
+
+    // ---- Once s_enabled is false under the lock, no other thread changes the state.
+    {
+        std::lock_guard<std::mutex> lock(trace_state->mutex);
+        s_enabled.store(false, std::memory_order_release);
+    }
+
+    TraceState& ts = *trace_state;
+    if (ts.ofs.is_open())
+    {
+        ts.flush();
+        std::int64_t table_offset = ts.ofs.tellp();
+        std::int32_t nregions = ts.region_names.size();
+        ts.ofs.write(reinterpret_cast<const char*>(&nregions), sizeof(nregions));
+        for (auto const& s : ts.region_names) {
+            std::int32_t len = s.size();
+            ts.ofs.write(reinterpret_cast<const char*>(&len), sizeof(len));
+            ts.ofs.write(s.data(), len);
+        }
+        std::int64_t nevents = ts.nevents;
+        ts.ofs.write(reinterpret_cast<const char*>(&nevents), sizeof(nevents));
+        ts.ofs.write(reinterpret_cast<const char*>(&table_offset), sizeof(table_offset));
+        ts.ofs.write(trace_end_magic, 8);
+        ts.ofs.close();
+    }
+
+    PrintSummary(ts);
+
+    std::lock_guard<std::mutex> lock(ts.mutex);
+    ts.clear();
+}
+
+void
+ArenaTrace::PushRegion (const std::string& name)
+{
+    if (!Enabled()) return;
+    std::lock_guard<std::mutex> lock(trace_state->mutex);
+    if (!Enabled()) return;
+    trace_state->region_stack.push_back(trace_state->regionID(name));
+}
+
+void
+ArenaTrace::PopRegion ()
+{
+    if (!Enabled()) return;
+    std::lock_guard<std::mutex> lock(trace_state->mutex);
+    if (!Enabled()) return;
+    if (!trace_state->region_stack.empty()) {
+        trace_state->region_stack.pop_back();
+    }
+}
+
+void
+ArenaTrace::RecordAlloc (void* p, std::size_t nbytes, int arena)
+{
+    if (p == nullptr or !Enabled()) return;
+
+    TraceState& ts = *trace_state;
+    std::lock_guard<std::mutex> lock(ts.mutex);
+    if (!Enabled()) return;
+
+    const int r = ts.region_stack.empty() ? 0 : ts.region_stack.back();
+    ts.live_ptrs[p] = std::make_pair(nbytes, r);
+
+    RegionStats& rs = ts.regions[r];
+    ++rs.nalloc;
+    rs.allocated += nbytes;
+    rs.live += nbytes;
+    rs.peak = std::max(rs.peak, rs.live);
+
+    ts.total_live += nbytes;
+    if (ts.total_live > ts.total_hwm) {
+        ts.total_hwm = ts.total_live;
+        ts.live_at_hwm.resize(ts.regions.size());
+        for (int i = 0, N = ts.regions.size(); i < N; ++i) {
+            ts.live_at_hwm[i] = ts.regions[i].live;
+        }
+    }
+
+    ts.record(static_cast<std::int64_t>(nbytes), r, arena);
+}
+
+void
+ArenaTrace::RecordFree (void* p, int arena)
+{
+    if (p == nullptr or !Enabled()) return;
+
+    TraceState& ts = *trace_state;
+    std::lock_guard<std::mutex> lock(ts.mutex);
+    if (!Enabled()) return;
+
+    auto it = ts.live_ptrs.find(p);
+    if (it == ts.live_ptrs.end()) return;
+
+    const std::size_t nbytes = it->second.first;
+    const int r = it->second.second;
+    ts.live_ptrs.erase(it);
+
+    ts.regions[r].live -= nbytes;
+    ts.total_live -= nbytes;
+
+    ts.record(-static_cast<std::int64_t>(nbytes), r, arena);
+}
+
+TraceArena::TraceArena (Arena* a, int id)
+    : m_arena(a), m_id(id)
+{
+    arena_info = a->arenaInfo();
+}
+
+TraceArena::~TraceArena ()
+{
+    delete m_arena;
+}
+
+void*
+TraceArena::alloc (std::size_t nbytes)
+{
+    void* p = m_arena->alloc(nbytes);
+    if (ArenaTrace::Enabled()) ArenaTrace::RecordAlloc(p, nbytes, m_id);
+    return p;
+}
+
+void
+TraceArena::free (void* p)
+{
+    if (ArenaTrace::Enabled()) ArenaTrace::RecordFree(p, m_id);
+    m_arena->free(p);
+}
+
+}
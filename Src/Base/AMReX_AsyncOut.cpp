@@ -6,6 +6,13 @@
 #include <AMReX_Utility.H>
 #include <AMReX.H>
 
+#include <atomic>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 namespace amrex {
 namespace AsyncOut {
 
@@ -14,8 +21,12 @@ namespace {
 int s_asyncout = false;
 int s_noutfiles = 64;
 MPI_Comm s_comm = MPI_COMM_NULL;
+MPI_Comm s_job_comm = MPI_COMM_NULL;
 
 std::unique_ptr<BackgroundThread> s_thread;
+std::unique_ptr<BackgroundThread> s_drain_thread;
+std::string s_stage_dir;
+std::atomic<int> s_stage_count{0};
 
 WriteInfo s_info;
 
@@ -23,11 +34,12 @@ WriteInfo s_info;
 
 void Initialize ()
 {
-    amrex::ignore_unused(s_comm,s_info);
+    amrex::ignore_unused(s_comm,s_job_comm,s_info);
 
     ParmParse pp("amrex");
     pp.query("async_out", s_asyncout);
     pp.query("async_out_nfiles", s_noutfiles);
+    pp.query("async_out_stage_dir", s_stage_dir);
 
     int nprocs = ParallelDescriptor::NProcs();
     s_noutfiles = std::min(s_noutfiles, nprocs);
@@ -44,8 +56,29 @@ void Initialize ()
 #endif
     }
 
+#ifdef AMREX_MPI_THREAD_MULTIPLE
+    if (s_asyncout and nprocs > 1) {
+        MPI_Comm_dup(ParallelDescriptor::Communicator(), &s_job_comm);
+    }
+#endif
+
     if (s_asyncout) s_thread.reset(new BackgroundThread());
 
+    if (s_asyncout and !s_stage_dir.empty())
+    {
+#ifdef _WIN32
+        amrex::Abort("AsyncOut: amrex.async_out_stage_dir is not supported on Windows");
+#endif
+        if (!amrex::UtilCreateDirectory(s_stage_dir, 0755)) {
+            amrex::CreateDirectoryFailed(s_stage_dir);
+        }
+        s_drain_thread.reset(new BackgroundThread());
+    }
+    else
+    {
+        s_stage_dir.clear();
+    }
+
     ExecOnFinalize(Finalize);
 }
 
@@ -54,15 +87,22 @@ void Finalize ()
     if (s_thread) {
         s_thread.reset();
     }
+    if (s_drain_thread) {
+        s_drain_thread.reset();
+    }
 
 #ifdef AMREX_USE_MPI
     if (s_comm != MPI_COMM_NULL) MPI_Comm_free(&s_comm);
     s_comm = MPI_COMM_NULL;
+    if (s_job_comm != MPI_COMM_NULL) MPI_Comm_free(&s_job_comm);
+    s_job_comm = MPI_COMM_NULL;
 #endif
 }
 
 bool UseAsyncOut () { return s_asyncout; }
 
+MPI_Comm JobCommunicator () { return s_job_comm; }
+
 WriteInfo GetWriteInfo (int rank)
 {
     const int nfiles = s_noutfiles;
@@ -99,6 +139,56 @@ void Submit (std::function<void()> const& a_f)
 void Finish ()
 {
     s_thread->Finish();
+    if (s_drain_thread) s_drain_thread->Finish();
+}
+
+bool UseStaging () { return s_drain_thread != nullptr; }
+
+std::string StageFileName ()
+{
+    std::string name = s_stage_dir + "/amrex_stage_";
+#ifndef _WIN32
+    name += std::to_string(getpid()) + "_";
+#endif
+    return name + std::to_string(ParallelDescriptor::MyProc()) + "_"
+        + std::to_string(s_stage_count++);
+}
+
+void Drain (const std::string& staged_file, const std::string& dest_file,
+            Long offset, Long dest_size)
+{
+#ifndef _WIN32
+    s_drain_thread->Submit([=] ()
+    {
+        int ifd = open(staged_file.c_str(), O_RDONLY);
+        if (ifd < 0) amrex::FileOpenFailed(staged_file);
+        int ofd = open(dest_file.c_str(), O_WRONLY | O_CREAT, 0644);
+        if (ofd < 0) amrex::FileOpenFailed(dest_file);
+        if (dest_size >= 0 and ftruncate(ofd, dest_size) != 0) {
+            amrex::Abort("AsyncOut::Drain: failed to truncate " + dest_file);
+        }
+
+        Vector<char> buf(8*1024*1024);
+        Long pos = offset;
+        while (true) {
+            ssize_t n = read(ifd, buf.data(), buf.size());
+            if (n < 0) amrex::Abort("AsyncOut::Drain: failed to read " + staged_file);
+            if (n == 0) break;
+            for (ssize_t done = 0; done < n; ) {
+                ssize_t m = pwrite(ofd, buf.data()+done, n-done, pos);
+                if (m < 0) amrex::Abort("AsyncOut::Drain: failed to write " + dest_file);
+                done += m;
+                pos += m;
+            }
+        }
+        if (fsync(ofd) != 0) amrex::Abort("AsyncOut::Drain: failed to fsync " + dest_file);
+        close(ofd);
+        close(ifd);
+        unlink(staged_file.c_str());
+    });
+#else
+    amrex::ignore_unused(staged_file, dest_file, offset, dest_size);
+#endif
 }
 
 void Wait ()
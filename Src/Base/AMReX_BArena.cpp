@@ -3,7 +3,11 @@
 void*
 amrex::BArena::alloc (std::size_t sz_)
 {
-    return std::malloc(sz_);
+    if (arena_info.use_huge_pages) {
+        return allocate_system(sz_);
+    } else {
+        return std::malloc(sz_);
+    }
 }
 
 void
@@ -11,6 +11,7 @@
 #include <AMReX_NFiles.H>
 #include <AMReX_Print.H>
 #include <AMReX_ParmParse.H>
+#include <AMReX_ArenaTrace.H>
 #include <iostream>
 #include <iomanip>
 #include <fstream>
@@ -323,6 +324,10 @@ void BLProfiler::start() {
   bRunning = true;
   nestedTimeStack.push(0.0);
 
+  if(ArenaTrace::Enabled()) {
+    ArenaTrace::PushRegion(fname);
+  }
+
 #ifdef BL_TRACE_PROFILING
   int fnameNumber;
   std::map<std::string, int>::iterator it = BLProfiler::mFNameNumbers.find(fname);
@@ -367,6 +372,10 @@ void BLProfiler::stop() {
   }
   mProfStats[fname].totalTime += thisFuncTime;
 
+  if(ArenaTrace::Enabled()) {
+    ArenaTrace::PopRegion();
+  }
+
 #ifdef BL_TRACE_PROFILING
   prevCallStackDepth = callStackDepth;
   --callStackDepth;
@@ -22,6 +22,22 @@ Long private_total_cells_allocated_in_fabs_hwm = 0L;
 namespace
 {
     static bool basefab_initialized = false;
+    bool defer_fab_init = false;
+#ifdef _OPENMP
+#pragma omp threadprivate(defer_fab_init)
+#endif
+}
+
+bool
+DeferFabInit () noexcept
+{
+    return defer_fab_init;
+}
+
+void
+SetDeferFabInit (bool flag) noexcept
+{
+    defer_fab_init = flag;
 }
 
 void
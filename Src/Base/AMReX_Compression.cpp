@@ -0,0 +1,307 @@
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include <AMReX_Compression.H>
+#include <AMReX.H>
+#include <AMReX_Extension.H>
+
+namespace amrex {
+namespace Compression {
+
+namespace {
+
+    constexpr Long MinMatch  = 4;
+    constexpr int  HashLog   = 16;
+    constexpr Long MaxOffset = 65535;
+    constexpr Long BlockHeaderSize = 1 + sizeof(std::int64_t);
+
+    void put_length (Vector<char>& out, Long len)
+    {
+        while (len >= 255) {
+            out.push_back(static_cast<char>(255));
+            len -= 255;
+        }
+        out.push_back(static_cast<char>(len));
+    }
+
+    //! A run of literals followed by a match.  mlen == 0 means no match.
+    void put_sequence (Vector<char>& out, const char* lit, Long nlit, Long offset, Long mlen)
+    {
+        const Long ml = (mlen > 0) ? mlen - MinMatch : 0;
+        const int token = static_cast<int>((std::min(nlit,Long(15)) << 4) | std::min(ml,Long(15)));
+        out.push_back(static_cast<char>(token));
+        if (nlit >= 15) put_length(out, nlit-15);
+        out.insert(out.end(), lit, lit+nlit);
+        if (mlen > 0) {
+            out.push_back(static_cast<char>(offset & 0xff));
+            out.push_back(static_cast<char>((offset >> 8) & 0xff));
+            if (ml >= 15) put_length(out, ml-15);
+        }
+    }
+
+    void put_varint (Vector<char>& out, std::uint64_t v)
+    {
+        while (v >= 0x80) {
+            out.push_back(static_cast<char>((v & 0x7f) | 0x80));
+            v >>= 7;
+        }
+        out.push_back(static_cast<char>(v));
+    }
+
+    //! Quantize src with step 2*tolerance.  Returns false if the error bound cannot be met.
+    bool quantize (const Real* src, Long n, Real tolerance, Vector<char>& out)
+    {
+        const double step = 2.0 * static_cast<double>(tolerance);
+        const double qmax = 4503599627370496.0; // 2^52
+        out.resize(sizeof(double));
+        std::memcpy(out.data(), &step, sizeof(double));
+        std::int64_t prev = 0;
+        for (Long i = 0; i < n; ++i) {
+            const double x = src[i];
+            if (!std::isfinite(x)) return false;
+            const double r = x / step;
+            if (std::abs(r) >= qmax) return false;
+            const std::int64_t q = std::llround(r);
+            if (std::abs(static_cast<Real>(q*step) - src[i]) > tolerance) return false;
+            const std::int64_t d = q - prev;
+            prev = q;
+            put_varint(out, (static_cast<std::uint64_t>(d) << 1) ^ static_cast<std::uint64_t>(d >> 63));
+        }
+        return true;
+    }
+
+    void dequantize (const char* src, Long nbytes, Real* dst, Long n)
+    {
+        if (nbytes < static_cast<Long>(sizeof(double))) {
+            amrex::Abort("Compression::Decompress: corrupt lossy block");
+        }
+        double step;
+        std::memcpy(&step, src, sizeof(double));
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(src);
+        Long ip = sizeof(double);
+        std::int64_t q = 0;
+        for (Long i = 0; i < n; ++i) {
+            std::uint64_t v = 0;
+            int shift = 0;
+            unsigned char b;
+            do {
+                if (ip >= nbytes || shift > 63) {
+                    amrex::Abort("Compression::Decompress: corrupt lossy block");
+                }
+                b = p[ip++];
+                v |= static_cast<std::uint64_t>(b & 0x7f) << shift;
+                shift += 7;
+            } while (b & 0x80);
+            const std::int64_t d = static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1);
+            q += d;
+            dst[i] = static_cast<Real>(q*step);
+        }
+    }
+}
+
+std::string
+CodecName (Codec codec)
+{
+    switch (codec) {
+    case NoCompression: return "none";
+    case Lossless:      return "lossless";
+    case Lossy:         return "lossy";
+    }
+    return "unknown";
+}
+
+Codec
+CodecFromName (const std::string& name)
+{
+    if (name == "none") {
+        return NoCompression;
+    } else if (name == "lossless") {
+        return Lossless;
+    } else if (name == "lossy") {
+        return Lossy;
+    } else {
+        amrex::Abort("Compression: unknown codec " + name);
+        return NoCompression;
+    }
+}
+
+void
+LZCompress (const char* src, Long n, Vector<char>& out)
+{
+    Vector<Long> table(1 << HashLog, -1);
+    Long anchor = 0;
+    Long ip = 0;
+    while (ip + MinMatch <= n)
+    {
+        std::uint32_t seq;
+        std::memcpy(&seq, src+ip, sizeof(seq));
+        const std::uint32_t h = (seq * 2654435761u) >> (32 - HashLog);
+        const Long ref = table[h];
+        table[h] = ip;
+        if (ref >= 0 && ip - ref <= MaxOffset && std::memcmp(src+ref, src+ip, MinMatch) == 0)
+        {
+            Long mlen = MinMatch;
+            while (ip+mlen < n && src[ref+mlen] == src[ip+mlen]) ++mlen;
+            put_sequence(out, src+anchor, ip-anchor, ip-ref, mlen);
+            ip += mlen;
+            anchor = ip;
+        }
+        else
+        {
+            ++ip;
+        }
+    }
+    put_sequence(out, src+anchor, n-anchor, 0, 0);
+}
+
+void
+LZDecompress (const char* src, Long nbytes, char* dst, Long n)
+{
+    const unsigned char* in = reinterpret_cast<const unsigned char*>(src);
+    Long ip = 0, op = 0;
+
+    auto get_length = [&] (Long len) -> Long
+    {
+        if (len == 15) {
+            unsigned char b;
+            do {
+                if (ip >= nbytes) amrex::Abort("LZDecompress: truncated data");
+                b = in[ip++];
+                len += b;
+            } while (b == 255);
+        }
+        return len;
+    };
+
+    while (op < n)
+    {
+        if (ip >= nbytes) amrex::Abort("LZDecompress: truncated data");
+        const int token = in[ip++];
+        const Long nlit = get_length(token >> 4);
+        if (ip + nlit > nbytes || op + nlit > n) amrex::Abort("LZDecompress: corrupt data");
+        std::memcpy(dst+op, in+ip, nlit);
+        ip += nlit;
+        op += nlit;
+        if (op == n) break;
+
+        if (ip + 2 > nbytes) amrex::Abort("LZDecompress: truncated data");
+        const Long offset = static_cast<Long>(in[ip]) | (static_cast<Long>(in[ip+1]) << 8);
+        ip += 2;
+        const Long mlen = get_length(token & 15) + MinMatch;
+        if (offset == 0 || offset > op || op + mlen > n) amrex::Abort("LZDecompress: corrupt data");
+        // The match may overlap the bytes being written, so copy forward one byte at a time.
+        for (Long i = 0; i < mlen; ++i) {
+            dst[op+i] = dst[op-offset+i];
+        }
+        op += mlen;
+    }
+}
+
+Long
+Compress (const Real* src, Long n, Codec codec, Real tolerance, Vector<char>& out)
+{
+    const Long start = out.size();
+    const Long rawbytes = n * sizeof(Real);
+
+    Vector<char> tmp;
+    if (codec == Lossy) {
+        if (!(tolerance > 0) || !quantize(src, n, tolerance, tmp)) {
+            codec = Lossless;
+        }
+    }
+    if (codec == Lossless) {
+        constexpr int S = sizeof(Real);
+        tmp.resize(rawbytes);
+        const char* bytes = reinterpret_cast<const char*>(src);
+        for (int b = 0; b < S; ++b) {
+            char* AMREX_RESTRICT p = tmp.data() + b*n;
+            for (Long i = 0; i < n; ++i) {
+                p[i] = bytes[i*S+b];
+            }
+        }
+    }
+
+    if (codec != NoCompression)
+    {
+        out.push_back(static_cast<char>(codec));
+        const std::int64_t len = tmp.size();
+        out.insert(out.end(), reinterpret_cast<const char*>(&len),
+                   reinterpret_cast<const char*>(&len)+sizeof(len));
+        LZCompress(tmp.data(), tmp.size(), out);
+        if (static_cast<Long>(out.size()) - start >= BlockHeaderSize + rawbytes) {
+            out.resize(start);
+            codec = NoCompression;
+        }
+    }
+
+    if (codec == NoCompression)
+    {
+        out.push_back(static_cast<char>(NoCompression));
+        const std::int64_t len = rawbytes;
+        out.insert(out.end(), reinterpret_cast<const char*>(&len),
+                   reinterpret_cast<const char*>(&len)+sizeof(len));
+        out.insert(out.end(), reinterpret_cast<const char*>(src),
+                   reinterpret_cast<const char*>(src)+rawbytes);
+    }
+
+    return static_cast<Long>(out.size()) - start;
+}
+
+void
+Decompress (const char* src, Long nbytes, Real* dst, Long n)
+{
+    if (nbytes < BlockHeaderSize) amrex::Abort("Compression::Decompress: truncated block");
+
+    const int codec = src[0];
+    std::int64_t len;
+    std::memcpy(&len, src+1, sizeof(len));
+    const char* data = src + BlockHeaderSize;
+    const Long ndata = nbytes - BlockHeaderSize;
+    const Long rawbytes = n * sizeof(Real);
+
+    if (codec == NoCompression)
+    {
+        if (len != rawbytes || ndata < len) amrex::Abort("Compression::Decompress: corrupt block");
+        std::memcpy(dst, data, rawbytes);
+    }
+    else if (codec == Lossless || codec == Lossy)
+    {
+        // Check len before it is used to allocate.  A lossy stream has the
+        // step and at most 10 varint bytes per value, and the LZ coder can
+        // expand its input at most 255 times (plus the final token).
+        bool len_ok;
+        if (codec == Lossless) {
+            len_ok = (len == rawbytes);
+        } else {
+            len_ok = len >= static_cast<std::int64_t>(sizeof(double))
+                && len <= static_cast<std::int64_t>(sizeof(double)) + 10*n
+                && len <= ndata*255 + 16;
+        }
+        if (!len_ok) amrex::Abort("Compression::Decompress: corrupt block");
+
+        Vector<char> tmp(len);
+        LZDecompress(data, ndata, tmp.data(), len);
+        if (codec == Lossless) {
+            constexpr int S = sizeof(Real);
+            char* bytes = reinterpret_cast<char*>(dst);
+            for (int b = 0; b < S; ++b) {
+                const char* AMREX_RESTRICT p = tmp.data() + b*n;
+                for (Long i = 0; i < n; ++i) {
+                    bytes[i*S+b] = p[i];
+                }
+            }
+        } else {
+            dequantize(tmp.data(), len, dst, n);
+        }
+    }
+    else
+    {
+        amrex::Abort("Compression::Decompress: unknown codec " + std::to_string(codec));
+    }
+}
+
+}
+}
@@ -21,6 +21,7 @@
 #include <string>
 #include <cstring>
 #include <iomanip>
+#include <limits>
 
 namespace {
 int flag_verbose_mapper;
@@ -36,6 +37,43 @@ namespace amrex {
     int    sfc_threshold;
     Real   max_efficiency;
     int    node_size;
+    Real   graph_imbalance;
+    int    graph_ngrow;
+
+namespace {
+    // Node ID of each rank in ParallelDescriptor::Communicator()
+    Vector<int> rank_node_ids;
+
+    void FindNodeIDs ()
+    {
+        const int nprocs = ParallelDescriptor::NProcs();
+        rank_node_ids.resize(nprocs);
+
+        if (node_size > 0)
+        {
+            for (int i = 0; i < nprocs; ++i) {
+                rank_node_ids[i] = i / node_size;
+            }
+            return;
+        }
+
+#ifdef BL_USE_MPI
+        // The node ID is the lowest rank on the node.
+        const int myproc = ParallelDescriptor::MyProc();
+        MPI_Comm node_comm;
+        BL_MPI_REQUIRE( MPI_Comm_split_type(ParallelDescriptor::Communicator(),
+                                            MPI_COMM_TYPE_SHARED, myproc,
+                                            MPI_INFO_NULL, &node_comm) );
+        int leader = myproc;
+        BL_MPI_REQUIRE( MPI_Bcast(&leader, 1, MPI_INT, 0, node_comm) );
+        BL_MPI_REQUIRE( MPI_Comm_free(&node_comm) );
+        ParallelAllGather::AllGather(leader, rank_node_ids.dataPtr(),
+                                     ParallelDescriptor::Communicator());
+#else
+        rank_node_ids[0] = 0;
+#endif
+    }
+}
 
 // We default to SFC.
 DistributionMapping::Strategy DistributionMapping::m_Strategy = DistributionMapping::SFC;
@@ -73,6 +111,12 @@ DistributionMapping::strategy (DistributionMapping::Strategy how)
     case RRSFC:
         m_BuildMap = &DistributionMapping::RRSFCProcessorMap;
         break;
+    case SFC_NODE:
+        m_BuildMap = &DistributionMapping::SFCNodeProcessorMap;
+        break;
+    case GRAPH:
+        m_BuildMap = &DistributionMapping::GraphProcessorMap;
+        break;
     default:
         amrex::Error("Bad DistributionMapping::Strategy");
     }
@@ -113,6 +157,8 @@ DistributionMapping::Initialize ()
     sfc_threshold    = 0;
     max_efficiency   = 0.9;
     node_size        = 0;
+    graph_imbalance  = 1.05;
+    graph_ngrow      = 1;
     flag_verbose_mapper = 0;
 
     ParmParse pp("DistributionMapping");
@@ -123,6 +169,8 @@ DistributionMapping::Initialize ()
     pp.query("sfc_threshold",       sfc_threshold);
     pp.query("node_size",           node_size);
     pp.query("verbose_mapper",      flag_verbose_mapper);
+    pp.query("graph_imbalance",     graph_imbalance);
+    pp.query("graph_ngrow",         graph_ngrow);
 
     std::string theStrategy;
 
@@ -144,6 +192,14 @@ DistributionMapping::Initialize ()
         {
             strategy(RRSFC);
         }
+        else if (theStrategy == "SFC_NODE")
+        {
+            strategy(SFC_NODE);
+        }
+        else if (theStrategy == "GRAPH")
+        {
+            strategy(GRAPH);
+        }
         else
         {
             std::string msg("Unknown strategy: ");
@@ -156,6 +212,8 @@ DistributionMapping::Initialize ()
         strategy(m_Strategy);  // default
     }
 
+    FindNodeIDs();
+
     amrex::ExecOnFinalize(DistributionMapping::Finalize);
 
     initialized = true;
@@ -169,6 +227,15 @@ DistributionMapping::Finalize ()
     m_Strategy = SFC;
 
     DistributionMapping::m_BuildMap = 0;
+
+    rank_node_ids.clear();
+}
+
+int
+DistributionMapping::NodeID (int rank)
+{
+    BL_ASSERT(rank >= 0 && rank < static_cast<int>(rank_node_ids.size()));
+    return rank_node_ids[rank];
 }
 
 void
@@ -1366,6 +1433,1030 @@ DistributionMapping::RRSFCProcessorMap (const BoxArray&          boxes,
     RRSFCDoIt(boxes,nprocs);
 }
 
+namespace
+{
+    // Split tokens[begin,end) into contiguous pieces, one for each bin, with
+    // weights proportional to binwgt.  Each bin gets at least one token if
+    // there are enough.  ranges[i] is [first,last) of bin i.
+    void
+    DistributeProportional (const std::vector<SFCToken>&     tokens,
+                            int                              begin,
+                            int                              end,
+                            const Vector<int>&               binwgt,
+                            Vector<std::pair<int,int> >&     ranges)
+    {
+        const int nbins = binwgt.size();
+        ranges.resize(nbins);
+
+        Real totalvol = 0;
+        for (int K = begin; K < end; ++K) {
+            totalvol += tokens[K].m_vol;
+        }
+        const Real totalwgt = std::accumulate(binwgt.begin(), binwgt.end(), 0.0);
+
+        int  K      = begin;
+        Real vol    = 0;
+        Real target = 0;
+        for (int i = 0; i < nbins; ++i)
+        {
+            target += totalvol * binwgt[i] / totalwgt;
+            const int b = K;
+            if (i == nbins-1)
+            {
+                K = end;
+            }
+            else
+            {
+                const int nleft = nbins - i - 1;
+                while (K < end - nleft && (K == b || vol + 0.5*tokens[K].m_vol <= target))
+                {
+                    vol += tokens[K].m_vol;
+                    ++K;
+                }
+            }
+            ranges[i] = std::make_pair(b,K);
+        }
+    }
+}
+
+void
+DistributionMapping::SFCNodeDoIt (const BoxArray&          boxes,
+                                  const std::vector<Long>& wgts,
+                                  Real*                    eff)
+{
+    if (flag_verbose_mapper) {
+        Print() << "DM: SFCNodeDoIt called..." << std::endl;
+    }
+
+    BL_PROFILE("DistributionMapping::SFCNodeDoIt()");
+
+    const int nprocs = ParallelContext::NProcsSub();
+
+    //
+    // Group the ranks by node.  The nodes are ordered by their lowest rank.
+    //
+    std::map<int,Vector<int> > node_ranks;
+    for (int i = 0; i < nprocs; ++i) {
+        node_ranks[NodeID(ParallelContext::local_to_global_rank(i))].push_back(i);
+    }
+
+    Vector<int> node_nranks;
+    for (auto const& kv : node_ranks) {
+        node_nranks.push_back(kv.second.size());
+    }
+    const int nnodes = node_nranks.size();
+
+    std::vector<SFCToken> tokens;
+
+    const int N = boxes.size();
+
+    tokens.reserve(N);
+
+    int maxijk = 0;
+
+    for (int i = 0; i < N; ++i)
+    {
+	const Box& bx = boxes[i];
+        tokens.push_back(SFCToken(i,bx.smallEnd(),wgts[i]));
+
+        const SFCToken& token = tokens.back();
+
+        AMREX_D_TERM(maxijk = std::max(maxijk, token.m_idx[0]);,
+                     maxijk = std::max(maxijk, token.m_idx[1]);,
+                     maxijk = std::max(maxijk, token.m_idx[2]););
+    }
+    //
+    // Set SFCToken::MaxPower for BoxArray.
+    //
+    int m = 0;
+    for ( ; (1 << m) <= maxijk; ++m) {
+        ;  // do nothing
+    }
+    SFCToken::MaxPower = m;
+    //
+    // Put'm in Morton space filling curve order.
+    //
+    std::sort(tokens.begin(), tokens.end(), SFCToken::Compare());
+    //
+    // Split'm across nodes in proportion to the number of ranks on the node,
+    // and then split each node's piece across its ranks.
+    //
+    Vector<std::pair<int,int> > node_ranges;
+    DistributeProportional(tokens, 0, N, node_nranks, node_ranges);
+
+    Vector<Long> rank_wgt(nprocs, 0);
+
+    int inode = 0;
+    for (auto const& kv : node_ranks)
+    {
+        const Vector<int>& ranks = kv.second;
+        const int nr = ranks.size();
+
+        Vector<std::pair<int,int> > rank_ranges;
+        DistributeProportional(tokens, node_ranges[inode].first, node_ranges[inode].second,
+                               Vector<int>(nr,1), rank_ranges);
+
+        for (int j = 0; j < nr; ++j)
+        {
+            for (int K = rank_ranges[j].first; K < rank_ranges[j].second; ++K)
+            {
+                const int ibox = tokens[K].m_box;
+                m_ref->m_pmap[ibox] = ParallelContext::local_to_global_rank(ranks[j]);
+                rank_wgt[ranks[j]] += wgts[ibox];
+            }
+        }
+
+        if (flag_verbose_mapper) {
+            Print() << "  Node " << kv.first << " gets SFC tokens [" << node_ranges[inode].first
+                    << ", " << node_ranges[inode].second << ") for " << nr << " ranks\n";
+        }
+
+        ++inode;
+    }
+
+    if (eff || verbose)
+    {
+        Real sum_wgt = 0, max_wgt = 0;
+        for (int i = 0; i < nprocs; ++i)
+        {
+            const Long W = rank_wgt[i];
+            if (W > max_wgt) max_wgt = W;
+            sum_wgt += W;
+        }
+        Real efficiency = (sum_wgt/(nprocs*max_wgt));
+        if (eff) *eff = efficiency;
+
+        if (verbose)
+        {
+            amrex::Print() << "SFC_NODE efficiency: " << efficiency
+                           << ", # of nodes: " << nnodes << '\n';
+        }
+    }
+}
+
+void
+DistributionMapping::SFCNodeProcessorMap (const BoxArray& boxes,
+                                          int             nprocs)
+{
+    BL_ASSERT(boxes.size() > 0);
+
+    m_ref->clear();
+    m_ref->m_pmap.resize(boxes.size());
+
+    if (boxes.size() < sfc_threshold*nprocs)
+    {
+        KnapSackProcessorMap(boxes,nprocs);
+    }
+    else
+    {
+        std::vector<Long> wgts;
+
+        wgts.reserve(boxes.size());
+
+        for (int i = 0, N = boxes.size(); i < N; ++i)
+        {
+            wgts.push_back(boxes[i].volume());
+        }
+
+        SFCNodeDoIt(boxes,wgts,nullptr);
+    }
+}
+
+void
+DistributionMapping::SFCNodeProcessorMap (const BoxArray&          boxes,
+                                          const std::vector<Long>& wgts,
+                                          int                   /* nprocs */,
+                                          Real*                    eff)
+{
+    BL_ASSERT(boxes.size() > 0);
+    BL_ASSERT(boxes.size() == static_cast<int>(wgts.size()));
+
+    m_ref->clear();
+    m_ref->m_pmap.resize(wgts.size());
+
+    SFCNodeDoIt(boxes,wgts,eff);
+}
+
+namespace
+{
+    //
+    // A multilevel graph partitioner.  The vertices are boxes and the edges
+    // connect boxes whose ghost cells overlap.  The graph is split by
+    // recursive bisection.  Each bisection coarsens the graph with heavy
+    // edge matching, bisects the coarsest graph by graph growing, and
+    // refines the bisection with Fiduccia-Mattheyses passes on the way back
+    // to the finest level.  Finally, greedy k-way moves enforce the load
+    // balance constraint.  Everything here is deterministic so that all
+    // ranks get the same answer.
+    //
+    struct PartGraph
+    {
+        Vector<int>  xadj;   // edges of vertex v are [xadj[v], xadj[v+1])
+        Vector<int>  adjncy;
+        Vector<Long> adjwgt;
+        Vector<Long> vwgt;
+
+        int nv () const { return vwgt.size(); }
+    };
+
+    PartGraph
+    BuildBoxGraph (const BoxArray& ba, const std::vector<Long>& wgts, const IntVect& ngrow)
+    {
+        const int N = ba.size();
+
+        // The edge weight is the number of ghost cells exchanged in both
+        // directions.
+        Vector<std::map<int,Long> > adj(N);
+        std::vector< std::pair<int,Box> > isects;
+        for (int i = 0; i < N; ++i)
+        {
+            ba.intersections(amrex::grow(ba[i],ngrow), isects);
+            for (auto const& is : isects)
+            {
+                const int j = is.first;
+                if (j == i) continue;
+                const Long npts = is.second.numPts();
+                adj[i][j] += npts;
+                adj[j][i] += npts;
+            }
+        }
+
+        PartGraph g;
+        g.vwgt.assign(wgts.begin(), wgts.end());
+        g.xadj.resize(N+1);
+        g.xadj[0] = 0;
+        for (int i = 0; i < N; ++i)
+        {
+            for (auto const& kv : adj[i])
+            {
+                g.adjncy.push_back(kv.first);
+                g.adjwgt.push_back(kv.second);
+            }
+            g.xadj[i+1] = g.adjncy.size();
+        }
+        return g;
+    }
+
+    PartGraph
+    CoarsenGraph (const PartGraph& g, Long maxvwgt, Vector<int>& cmap)
+    {
+        const int nv = g.nv();
+
+        Vector<int> match(nv, -1);
+        for (int v = 0; v < nv; ++v)
+        {
+            if (match[v] != -1) continue;
+            int  best = -1;
+            Long bestw = -1;
+            for (int e = g.xadj[v]; e < g.xadj[v+1]; ++e)
+            {
+                const int u = g.adjncy[e];
+                if (match[u] == -1 && g.vwgt[v]+g.vwgt[u] <= maxvwgt && g.adjwgt[e] > bestw)
+                {
+                    best  = u;
+                    bestw = g.adjwgt[e];
+                }
+            }
+            if (best >= 0) {
+                match[v] = best;
+                match[best] = v;
+            } else {
+                match[v] = v;
+            }
+        }
+
+        cmap.assign(nv, -1);
+        Vector<int> rep;
+        for (int v = 0; v < nv; ++v)
+        {
+            if (cmap[v] == -1)
+            {
+                cmap[v] = cmap[match[v]] = rep.size();
+                rep.push_back(v);
+            }
+        }
+
+        const int cnv = rep.size();
+
+        PartGraph cg;
+        cg.xadj.resize(cnv+1);
+        cg.vwgt.resize(cnv);
+        cg.xadj[0] = 0;
+
+        Vector<int> htable(cnv, -1);
+        for (int c = 0; c < cnv; ++c)
+        {
+            const int v = rep[c];
+            const int u = match[v];
+            const int estart = cg.adjncy.size();
+            cg.vwgt[c] = (u == v) ? g.vwgt[v] : g.vwgt[v] + g.vwgt[u];
+            for (int w : {v, u})
+            {
+                for (int e = g.xadj[w]; e < g.xadj[w+1]; ++e)
+                {
+                    const int cu = cmap[g.adjncy[e]];
+                    if (cu == c) continue;
+                    if (htable[cu] == -1) {
+                        htable[cu] = cg.adjncy.size();
+                        cg.adjncy.push_back(cu);
+                        cg.adjwgt.push_back(g.adjwgt[e]);
+                    } else {
+                        cg.adjwgt[htable[cu]] += g.adjwgt[e];
+                    }
+                }
+                if (u == v) break;
+            }
+            for (int e = estart, eend = cg.adjncy.size(); e < eend; ++e) {
+                htable[cg.adjncy[e]] = -1;
+            }
+            cg.xadj[c+1] = cg.adjncy.size();
+        }
+
+        return cg;
+    }
+
+    //
+    // Grow part 0 of a bisection of verts from the vertex start, always
+    // adding the frontier vertex with the largest gain in internal edge
+    // weight, until it has the target weight.  On return, state is 1 for
+    // the vertices in part 0.
+    //
+    void
+    GrowBisection (const PartGraph& g, const Vector<int>& verts, Real target,
+                   int start, Vector<int>& state)
+    {
+        // -1: not in this set, 0: unassigned, 1: in part 0
+        const int nv = g.nv();
+        state.assign(nv, -1);
+        for (int v : verts) state[v] = 0;
+
+        // Find a peripheral vertex with a breadth-first search.
+        int seed = start;
+        {
+            Vector<int> visited(nv, 0);
+            std::queue<int> q;
+            q.push(seed);
+            visited[seed] = 1;
+            while (!q.empty())
+            {
+                seed = q.front();
+                q.pop();
+                for (int e = g.xadj[seed]; e < g.xadj[seed+1]; ++e)
+                {
+                    const int u = g.adjncy[e];
+                    if (state[u] == 0 && !visited[u]) {
+                        visited[u] = 1;
+                        q.push(u);
+                    }
+                }
+            }
+        }
+
+        Vector<Long> gain(nv, 0);
+        for (int v : verts)
+        {
+            for (int e = g.xadj[v]; e < g.xadj[v+1]; ++e)
+            {
+                if (state[g.adjncy[e]] >= 0) gain[v] -= g.adjwgt[e];
+            }
+        }
+
+        std::priority_queue<std::pair<Long,int> > frontier;
+        frontier.push(std::make_pair(gain[seed], seed));
+
+        Real w0 = 0;
+        int next = 0;
+        int n0 = 0;
+        const int nverts = verts.size();
+        while (w0 < target && n0 < nverts-1)
+        {
+            int v = -1;
+            while (!frontier.empty())
+            {
+                auto top = frontier.top();
+                frontier.pop();
+                if (state[top.second] == 0 && top.first == gain[top.second]) {
+                    v = top.second;
+                    break;
+                }
+            }
+            if (v == -1)
+            {
+                // Disconnected; start again from the next unassigned vertex.
+                while (state[verts[next]] != 0) ++next;
+                v = verts[next];
+            }
+
+            if (w0 > 0 && (w0 + g.vwgt[v] - target) > (target - w0)) break;
+
+            state[v] = 1;
+            w0 += g.vwgt[v];
+            ++n0;
+            for (int e = g.xadj[v]; e < g.xadj[v+1]; ++e)
+            {
+                const int u = g.adjncy[e];
+                if (state[u] == 0) {
+                    gain[u] += 2*g.adjwgt[e];
+                    frontier.push(std::make_pair(gain[u], u));
+                }
+            }
+        }
+    }
+
+    //
+    // Fiduccia-Mattheyses refinement of a bisection.  In each pass, the
+    // vertex with the largest gain is moved to the other side, as long as
+    // the weight of part 0 stays within [target-slack, target+slack], even
+    // if the edge cut increases.  The best prefix of the moves is kept.
+    //
+    void
+    RefineBisection (const PartGraph& g, const Vector<int>& verts, Real target,
+                     Real slack, Vector<int>& state)
+    {
+        const int nv = g.nv();
+
+        Real w0 = 0;
+        for (int v : verts) {
+            if (state[v] == 1) w0 += g.vwgt[v];
+        }
+
+        Vector<Long> gain(nv);
+        Vector<int> locked(nv);
+        Vector<int> moved;
+
+        const int max_passes = 4;
+        const int max_bad_moves = 100;
+        for (int pass = 0; pass < max_passes; ++pass)
+        {
+            std::priority_queue<std::pair<Long,int> > pq[2];
+            for (int v : verts)
+            {
+                gain[v] = 0;
+                locked[v] = 0;
+                for (int e = g.xadj[v]; e < g.xadj[v+1]; ++e)
+                {
+                    const int su = state[g.adjncy[e]];
+                    if (su < 0) continue;
+                    gain[v] += (su == state[v]) ? -g.adjwgt[e] : g.adjwgt[e];
+                }
+                pq[state[v]].push(std::make_pair(gain[v], v));
+            }
+
+            moved.clear();
+            Long cutchange = 0, bestchange = 0;
+            int nbest = 0;
+            Real bestdev = std::abs(w0 - target);
+
+            while (static_cast<int>(moved.size()) - nbest < max_bad_moves)
+            {
+                // Pick the best vertex among the sides it is allowed to leave.
+                int v = -1;
+                for (int side = 0; side < 2; ++side)
+                {
+                    auto& q = pq[side];
+                    while (!q.empty() && (locked[q.top().second] ||
+                                          state[q.top().second] != side ||
+                                          q.top().first != gain[q.top().second])) {
+                        q.pop();
+                    }
+                    if (q.empty()) continue;
+                    const int u = q.top().second;
+                    const Real neww0 = (side == 1) ? w0 - g.vwgt[u] : w0 + g.vwgt[u];
+                    if (std::abs(neww0 - target) > slack &&
+                        std::abs(neww0 - target) >= std::abs(w0 - target)) continue;
+                    if (v == -1 || gain[u] > gain[v]) v = u;
+                }
+                if (v == -1) break;
+
+                const int from = state[v];
+                state[v] = 1 - from;
+                locked[v] = 1;
+                w0 += (from == 1) ? -g.vwgt[v] : g.vwgt[v];
+                cutchange -= gain[v];
+                moved.push_back(v);
+
+                for (int e = g.xadj[v]; e < g.xadj[v+1]; ++e)
+                {
+                    const int u = g.adjncy[e];
+                    if (state[u] < 0 || locked[u]) continue;
+                    gain[u] += (state[u] == from) ? 2*g.adjwgt[e] : -2*g.adjwgt[e];
+                    pq[state[u]].push(std::make_pair(gain[u], u));
+                }
+
+                const Real dev = std::abs(w0 - target);
+                if ((dev <= slack && (cutchange < bestchange ||
+                                      (cutchange == bestchange && dev < bestdev))) ||
+                    (bestdev > slack && dev < bestdev))
+                {
+                    bestchange = cutchange;
+                    bestdev = dev;
+                    nbest = moved.size();
+                }
+            }
+
+            // Undo the moves after the best prefix.
+            for (int k = moved.size()-1; k >= nbest; --k)
+            {
+                const int v = moved[k];
+                state[v] = 1 - state[v];
+                w0 += (state[v] == 1) ? g.vwgt[v] : -g.vwgt[v];
+            }
+
+            if (nbest == 0) break;
+        }
+    }
+
+    //
+    // The subgraph induced by verts.
+    //
+    PartGraph
+    ExtractSubgraph (const PartGraph& g, const Vector<int>& verts)
+    {
+        Vector<int> lid(g.nv(), -1);
+        for (int i = 0, N = verts.size(); i < N; ++i) lid[verts[i]] = i;
+
+        PartGraph sg;
+        sg.xadj.push_back(0);
+        for (int v : verts)
+        {
+            sg.vwgt.push_back(g.vwgt[v]);
+            for (int e = g.xadj[v]; e < g.xadj[v+1]; ++e)
+            {
+                const int u = lid[g.adjncy[e]];
+                if (u >= 0) {
+                    sg.adjncy.push_back(u);
+                    sg.adjwgt.push_back(g.adjwgt[e]);
+                }
+            }
+            sg.xadj.push_back(sg.adjncy.size());
+        }
+        return sg;
+    }
+
+    //
+    // Multilevel bisection.  The graph is coarsened, bisected on the
+    // coarsest level from a few different starting vertices, and the
+    // bisection is refined on every level on the way back.  On return,
+    // state is 1 for the vertices in part 0, which has a fraction frac0 of
+    // the total weight.
+    //
+    void
+    MultilevelBisection (const PartGraph& g0, Real frac0, Vector<int>& state)
+    {
+        Long total = 0, maxvwgt = 0;
+        for (Long w : g0.vwgt) {
+            total += w;
+            maxvwgt = std::max(maxvwgt, w);
+        }
+        const Real target = frac0 * total;
+        const Real slack = std::max(Real(maxvwgt), 0.01*total);
+
+        const int coarsen_to = 64;
+        const Long max_cvwgt = std::max(maxvwgt, total/coarsen_to);
+        std::vector<PartGraph> graphs;
+        Vector<Vector<int> > cmaps;
+        graphs.push_back(g0);
+        while (graphs.back().nv() > coarsen_to)
+        {
+            Vector<int> cmap;
+            PartGraph cg = CoarsenGraph(graphs.back(), max_cvwgt, cmap);
+            if (cg.nv() > 0.9*graphs.back().nv()) break;
+            graphs.push_back(std::move(cg));
+            cmaps.push_back(std::move(cmap));
+        }
+
+        const PartGraph& gc = graphs.back();
+        const int nc = gc.nv();
+        Vector<int> verts(nc);
+        std::iota(verts.begin(), verts.end(), 0);
+
+        const int ntries = 4;
+        Long bestcut = std::numeric_limits<Long>::max();
+        Vector<int> trial;
+        for (int itry = 0; itry < std::min(ntries,nc); ++itry)
+        {
+            GrowBisection(gc, verts, target, (itry*nc)/ntries, trial);
+            RefineBisection(gc, verts, target, slack, trial);
+            Long cut = 0;
+            for (int v = 0; v < nc; ++v) {
+                if (trial[v] != 1) continue;
+                for (int e = gc.xadj[v]; e < gc.xadj[v+1]; ++e) {
+                    if (trial[gc.adjncy[e]] == 0) cut += gc.adjwgt[e];
+                }
+            }
+            if (cut < bestcut) {
+                bestcut = cut;
+                state.swap(trial);
+            }
+        }
+
+        for (int lev = graphs.size()-2; lev >= 0; --lev)
+        {
+            const Vector<int>& cmap = cmaps[lev];
+            const int nf = graphs[lev].nv();
+            Vector<int> fstate(nf);
+            for (int v = 0; v < nf; ++v) {
+                fstate[v] = state[cmap[v]];
+            }
+            state.swap(fstate);
+            verts.resize(nf);
+            std::iota(verts.begin(), verts.end(), 0);
+            RefineBisection(graphs[lev], verts, target, slack, state);
+        }
+    }
+
+    //
+    // Split verts into nparts parts numbered from first_part by recursive
+    // multilevel bisection.
+    //
+    void
+    RecursiveBisection (const PartGraph& g, const Vector<int>& verts,
+                        int first_part, int nparts, Vector<int>& where)
+    {
+        if (nparts == 1 || verts.size() <= 1)
+        {
+            for (int v : verts) where[v] = first_part;
+            return;
+        }
+
+        const int np0 = nparts/2;
+
+        Vector<int> state;
+        MultilevelBisection(ExtractSubgraph(g, verts), Real(np0)/nparts, state);
+
+        Vector<int> verts0, verts1;
+        for (int i = 0, N = verts.size(); i < N; ++i) {
+            if (state[i] == 1) {
+                verts0.push_back(verts[i]);
+            } else {
+                verts1.push_back(verts[i]);
+            }
+        }
+
+        RecursiveBisection(g, verts0, first_part    ,        np0, where);
+        RecursiveBisection(g, verts1, first_part+np0, nparts-np0, where);
+    }
+
+    //
+    // Greedy k-way refinement.  A vertex moves to the neighboring part that
+    // reduces the edge cut the most without exceeding maxload.  Moves with
+    // zero gain are taken if they improve the balance, and vertices of
+    // overloaded parts are moved even if the edge cut increases.
+    //
+    void
+    RefinePartition (const PartGraph& g, int nparts, Long maxload, Vector<int>& where)
+    {
+        const int nv = g.nv();
+
+        Vector<Long> load(nparts, 0);
+        for (int v = 0; v < nv; ++v) load[where[v]] += g.vwgt[v];
+
+        Vector<Long> conn(nparts, 0);
+        Vector<int> nbrparts;
+
+        const int max_passes = 8;
+        for (int pass = 0; pass < max_passes; ++pass)
+        {
+            int nmoves = 0;
+            for (int v = 0; v < nv; ++v)
+            {
+                const int from = where[v];
+                const Long vw = g.vwgt[v];
+
+                nbrparts.clear();
+                for (int e = g.xadj[v]; e < g.xadj[v+1]; ++e)
+                {
+                    const int p = where[g.adjncy[e]];
+                    if (conn[p] == 0) nbrparts.push_back(p);
+                    conn[p] += g.adjwgt[e];
+                }
+
+                const Long internal = conn[from];
+                const bool overloaded = load[from] > maxload;
+
+                int  to = from;
+                Long bestgain = overloaded ? std::numeric_limits<Long>::lowest() : 0;
+                for (int p : nbrparts)
+                {
+                    if (p == from || load[p] + vw > maxload) continue;
+                    const Long gain = conn[p] - internal;
+                    if (gain > bestgain ||
+                        (gain == bestgain && load[p] + vw < load[from] &&
+                         (to == from || load[p] < load[to])))
+                    {
+                        to = p;
+                        bestgain = gain;
+                    }
+                }
+
+                if (to == from && overloaded)
+                {
+                    const int p = std::min_element(load.begin(), load.end()) - load.begin();
+                    if (load[p] + vw <= maxload) to = p;
+                }
+
+                for (int p : nbrparts) conn[p] = 0;
+
+                if (to != from)
+                {
+                    load[from] -= vw;
+                    load[to]   += vw;
+                    where[v] = to;
+                    ++nmoves;
+                }
+            }
+            if (nmoves == 0) break;
+        }
+    }
+
+    Vector<int>
+    PartitionGraph (const PartGraph& g, int nparts, Real imbalance)
+    {
+        Long total = 0, maxvwgt = 0;
+        for (Long w : g.vwgt) {
+            total += w;
+            maxvwgt = std::max(maxvwgt, w);
+        }
+        const Long maxload = std::max(maxvwgt, Long(imbalance*total/nparts) + 1);
+
+        Vector<int> where(g.nv());
+        Vector<int> verts(g.nv());
+        std::iota(verts.begin(), verts.end(), 0);
+        RecursiveBisection(g, verts, 0, nparts, where);
+
+        // Enforce the balance constraint and smooth the partition boundaries.
+        RefinePartition(g, nparts, maxload, where);
+
+        return where;
+    }
+}
+
+void
+DistributionMapping::GraphDoIt (const BoxArray&          boxes,
+                                const std::vector<Long>& wgts,
+                                Real*                    eff)
+{
+    if (flag_verbose_mapper) {
+        Print() << "DM: GraphDoIt called..." << std::endl;
+    }
+
+    BL_PROFILE("DistributionMapping::GraphDoIt()");
+
+    const int nprocs = ParallelContext::NProcsSub();
+
+    PartGraph g = BuildBoxGraph(boxes, wgts, IntVect(graph_ngrow));
+
+    Vector<int> where = PartitionGraph(g, nprocs, graph_imbalance);
+
+    Vector<Long> rank_wgt(nprocs, 0);
+    for (int i = 0, N = boxes.size(); i < N; ++i)
+    {
+        m_ref->m_pmap[i] = ParallelContext::local_to_global_rank(where[i]);
+        rank_wgt[where[i]] += wgts[i];
+    }
+
+    if (eff || verbose)
+    {
+        Real sum_wgt = 0, max_wgt = 0;
+        for (int i = 0; i < nprocs; ++i)
+        {
+            const Long W = rank_wgt[i];
+            if (W > max_wgt) max_wgt = W;
+            sum_wgt += W;
+        }
+        Real efficiency = (sum_wgt/(nprocs*max_wgt));
+        if (eff) *eff = efficiency;
+
+        if (verbose)
+        {
+            Long cut = 0, total = 0;
+            for (int v = 0; v < g.nv(); ++v) {
+                for (int e = g.xadj[v]; e < g.xadj[v+1]; ++e) {
+                    total += g.adjwgt[e];
+                    if (where[v] != where[g.adjncy[e]]) cut += g.adjwgt[e];
+                }
+            }
+            amrex::Print() << "GRAPH efficiency: " << efficiency
+                           << ", edge cut fraction: "
+                           << ((total > 0) ? Real(cut)/Real(total) : 0.0) << '\n';
+        }
+    }
+}
+
+void
+DistributionMapping::GraphProcessorMap (const BoxArray& boxes,
+                                        int             nprocs)
+{
+    BL_ASSERT(boxes.size() > 0);
+
+    m_ref->clear();
+    m_ref->m_pmap.resize(boxes.size());
+
+    if (boxes.size() < sfc_threshold*nprocs)
+    {
+        KnapSackProcessorMap(boxes,nprocs);
+    }
+    else
+    {
+        std::vector<Long> wgts;
+
+        wgts.reserve(boxes.size());
+
+        for (int i = 0, N = boxes.size(); i < N; ++i)
+        {
+            wgts.push_back(boxes[i].volume());
+        }
+
+        GraphDoIt(boxes,wgts,nullptr);
+    }
+}
+
+void
+DistributionMapping::GraphProcessorMap (const BoxArray&          boxes,
+                                        const std::vector<Long>& wgts,
+                                        int                   /* nprocs */,
+                                        Real*                    eff)
+{
+    BL_ASSERT(boxes.size() > 0);
+    BL_ASSERT(boxes.size() == static_cast<int>(wgts.size()));
+
+    m_ref->clear();
+    m_ref->m_pmap.resize(wgts.size());
+
+    GraphDoIt(boxes,wgts,eff);
+}
+
+DistributionMapping
+DistributionMapping::makeIncremental (const BoxArray& ba,
+                                      const Vector<Real>& rcost,
+                                      const BoxArray& old_ba,
+                                      const DistributionMapping& old_dm,
+                                      Real target_efficiency,
+                                      Real* eff,
+                                      Real* migrated_fraction)
+{
+    BL_PROFILE("makeIncremental");
+
+    BL_ASSERT(ba.size() == rcost.size());
+    BL_ASSERT(old_ba.size() == old_dm.size());
+
+    const int N = ba.size();
+    const int nprocs = ParallelContext::NProcsSub();
+
+    Vector<Long> cost(N);
+    {
+        Real wmax = *std::max_element(rcost.begin(), rcost.end());
+        Real scale = (wmax == 0) ? 1.e9 : 1.e9/wmax;
+        for (int i = 0; i < N; ++i) {
+            cost[i] = Long(rcost[i]*scale) + 1L;
+        }
+    }
+
+    //
+    // ovlp[i] holds the number of cells of box i owned by each rank in the
+    // old mapping.  The box starts on the rank owning most of it.
+    //
+    Vector<std::map<int,Long> > ovlp(N);
+    Vector<int> owner(N, -1);
+    Long old_cells = 0;
+    {
+        std::vector< std::pair<int,Box> > isects;
+        for (int i = 0; i < N; ++i)
+        {
+            old_ba.intersections(ba[i], isects);
+            for (auto const& is : isects)
+            {
+                const int rank = ParallelContext::global_to_local_rank(old_dm[is.first]);
+                if (rank < 0) continue;
+                ovlp[i][rank] += is.second.numPts();
+                old_cells += is.second.numPts();
+            }
+            Long maxcells = 0;
+            for (auto const& kv : ovlp[i]) {
+                if (kv.second > maxcells) {
+                    maxcells = kv.second;
+                    owner[i] = kv.first;
+                }
+            }
+        }
+    }
+
+    auto cells_on = [&ovlp] (int i, int rank) -> Long
+    {
+        auto it = ovlp[i].find(rank);
+        return (it == ovlp[i].end()) ? 0 : it->second;
+    };
+
+    Vector<Long> load(nprocs, 0);
+    Vector<Vector<int> > rank_boxes(nprocs);
+    for (int i = 0; i < N; ++i) {
+        if (owner[i] >= 0) {
+            load[owner[i]] += cost[i];
+            rank_boxes[owner[i]].push_back(i);
+        }
+    }
+    //
+    // Boxes without old data go to the least loaded ranks, largest first.
+    //
+    {
+        std::vector<LIpair> newboxes;
+        for (int i = 0; i < N; ++i) {
+            if (owner[i] < 0) newboxes.push_back(LIpair(cost[i],i));
+        }
+        Sort(newboxes, true);
+        for (auto const& p : newboxes)
+        {
+            const int rank = std::min_element(load.begin(), load.end()) - load.begin();
+            owner[p.second] = rank;
+            load[rank] += p.first;
+            rank_boxes[rank].push_back(p.second);
+        }
+    }
+
+    const Real avgload = Real(std::accumulate(load.begin(), load.end(), Long(0))) / nprocs;
+    //
+    // Move boxes from the most loaded rank to the least loaded rank.  The box
+    // with the largest reduction of the imbalance per migrated cell is moved.
+    //
+    int nmoves = 0;
+    Real efficiency = 1.0;
+    while (true)
+    {
+        const int maxrank = std::max_element(load.begin(), load.end()) - load.begin();
+        const int minrank = std::min_element(load.begin(), load.end()) - load.begin();
+        efficiency = avgload / load[maxrank];
+        if (efficiency >= target_efficiency || maxrank == minrank) break;
+
+        const Long gap = load[maxrank] - load[minrank];
+        const Real excess = load[maxrank] - avgload;
+
+        int  best = -1;
+        Real bestscore = 0;
+        Vector<int>& boxes = rank_boxes[maxrank];
+        for (int k = 0, nb = boxes.size(); k < nb; ++k)
+        {
+            const int i = boxes[k];
+            if (cost[i] >= gap) continue;
+            const Long extra = cells_on(i,maxrank) - cells_on(i,minrank);
+            const Real score = std::min(Real(cost[i]),excess) / Real(1 + std::max(extra,Long(0)));
+            if (score > bestscore) {
+                bestscore = score;
+                best = k;
+            }
+        }
+        if (best < 0) break;
+
+        const int i = boxes[best];
+        boxes[best] = boxes.back();
+        boxes.pop_back();
+        rank_boxes[minrank].push_back(i);
+        owner[i] = minrank;
+        load[maxrank] -= cost[i];
+        load[minrank] += cost[i];
+        ++nmoves;
+    }
+
+    Long moved_cells = 0;
+    for (int i = 0; i < N; ++i)
+    {
+        for (auto const& kv : ovlp[i]) {
+            if (kv.first != owner[i]) moved_cells += kv.second;
+        }
+    }
+
+    Real migrated = (old_cells > 0) ? Real(moved_cells)/Real(old_cells) : 0.0;
+    if (eff) *eff = efficiency;
+    if (migrated_fraction) *migrated_fraction = migrated;
+
+    if (verbose)
+    {
+        amrex::Print() << "Incremental efficiency: " << efficiency
+                       << ", migrated fraction: " << migrated
+                       << ", # of boxes moved for balance: " << nmoves << '\n';
+    }
+
+    Vector<int> pmap(N);
+    for (int i = 0; i < N; ++i) {
+        pmap[i] = ParallelContext::local_to_global_rank(owner[i]);
+    }
+    return DistributionMapping(std::move(pmap));
+}
+
+DistributionMapping
+DistributionMapping::makeIncremental (const BoxArray& ba,
+                                      const BoxArray& old_ba,
+                                      const DistributionMapping& old_dm,
+                                      Real target_efficiency,
+                                      Real* eff,
+                                      Real* migrated_fraction)
+{
+    Vector<Real> rcost(ba.size());
+    for (int i = 0, N = ba.size(); i < N; ++i) {
+        rcost[i] = ba[i].d_numPts();
+    }
+    return makeIncremental(ba, rcost, old_ba, old_dm, target_efficiency, eff, migrated_fraction);
+}
+
 DistributionMapping
 DistributionMapping::makeKnapSack (const Vector<Real>& rcost, int nmax)
 {
@@ -1526,6 +2617,46 @@ DistributionMapping::ComputeDistributionMappingEfficiency (const DistributionMap
                                    rankToCost.end(), 0.0) / (nprocs*maxCost));
 }
 
+void
+DistributionMapping::ComputeNodeCommunicationFraction (const DistributionMapping& dm,
+                                                       const BoxArray& ba,
+                                                       const IntVect& ngrow,
+                                                       Real* offnode_fraction,
+                                                       Real* offrank_fraction)
+{
+    BL_PROFILE("DistributionMapping::ComputeNodeCommunicationFraction()");
+
+    Long total = 0, offrank = 0, offnode = 0;
+
+    std::vector< std::pair<int,Box> > isects;
+
+    for (int i = 0, N = ba.size(); i < N; ++i)
+    {
+        const Box& gbx = amrex::grow(ba[i], ngrow);
+        ba.intersections(gbx, isects);
+        for (auto const& is : isects)
+        {
+            const int j = is.first;
+            if (j == i) continue;
+            const Long npts = is.second.numPts();
+            total += npts;
+            if (dm[i] != dm[j]) {
+                offrank += npts;
+                if (NodeID(dm[i]) != NodeID(dm[j])) {
+                    offnode += npts;
+                }
+            }
+        }
+    }
+
+    if (offnode_fraction) {
+        *offnode_fraction = (total > 0) ? Real(offnode)/Real(total) : 0.0;
+    }
+    if (offrank_fraction) {
+        *offrank_fraction = (total > 0) ? Real(offrank)/Real(total) : 0.0;
+    }
+}
+
 namespace {
 Vector<Long>
 gather_weights (const MultiFab& weight)
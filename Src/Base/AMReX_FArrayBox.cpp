@@ -154,6 +154,8 @@ FArrayBox::FArrayBox (const Box& b, int ncomp, Real const* p) noexcept
 void
 FArrayBox::initVal () noexcept
 {
+    if (DeferFabInit()) return;
+
     Real * p = dataPtr();
     Long s = size();
     if (p and s > 0) {
@@ -200,6 +202,31 @@ FArrayBox::initVal () noexcept
     }
 }
 
+void
+FArrayBox::initVal (const Box& bx) noexcept
+{
+    const auto a = this->array();
+    const int ncomp = nComp();
+    if (init_snan) {
+        const auto lo = amrex::lbound(bx);
+        const auto hi = amrex::ubound(bx);
+        const std::size_t len = hi.x - lo.x + 1;
+        for (int n = 0; n < ncomp; ++n) {
+            for (int k = lo.z; k <= hi.z; ++k) {
+                for (int j = lo.y; j <= hi.y; ++j) {
+                    amrex_array_init_snan(a.ptr(lo.x,j,k,n), len);
+                }
+            }
+        }
+    } else {
+        const Real x = do_initval ? initval : 0.0;
+        amrex::LoopConcurrentOnCpu(bx, ncomp, [=] (int i, int j, int k, int n) noexcept
+        {
+            a(i,j,k,n) = x;
+        });
+    }
+}
+
 void
 FArrayBox::resize (const Box& b, int N)
 {
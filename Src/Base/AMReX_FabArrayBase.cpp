@@ -24,6 +24,7 @@ namespace amrex {
 // Set default values in Initialize()!!!
 //
 int     FabArrayBase::MaxComp;
+bool    FabArrayBase::fb_persistent_comm;
 
 #if defined(AMREX_USE_GPU)
 
@@ -78,6 +79,12 @@ namespace
 {
     Arena* the_fa_arena = nullptr;
     bool initialized = false;
+#ifdef BL_USE_MPI
+    // Persistent FillBoundary requests use their own communicator so that
+    // their fixed tags never collide with the rotating sequence numbers.
+    MPI_Comm the_persistent_comm = MPI_COMM_NULL;
+    int      the_persistent_tag  = 0;
+#endif
 }
 
 void
@@ -90,6 +97,7 @@ FabArrayBase::Initialize ()
     // Set default values here!!!
     //
     FabArrayBase::MaxComp           = 25;
+    FabArrayBase::fb_persistent_comm = false;
 
     ParmParse pp("fabarray");
 
@@ -111,6 +119,7 @@ FabArrayBase::Initialize ()
     }
 
     pp.query("maxcomp",             FabArrayBase::MaxComp);
+    pp.query("fb_persistent_comm",  FabArrayBase::fb_persistent_comm);
 
     if (MaxComp < 1) {
         MaxComp = 1;
@@ -126,6 +135,12 @@ FabArrayBase::Initialize ()
     the_fa_arena = The_Cpu_Arena();
 #endif
 
+#ifdef BL_USE_MPI
+    if (ParallelDescriptor::NProcs() > 1) {
+        ParallelDescriptor::Comm_dup(ParallelContext::CommunicatorAll(), the_persistent_comm);
+    }
+#endif
+
     amrex::ExecOnFinalize(FabArrayBase::Finalize);
 
 #ifdef AMREX_MEM_PROFILING
@@ -270,6 +285,12 @@ FabArrayBase::FB::bytes () const
     if (m_RcvTags)
 	cnt += FabArrayBase::bytesOfMapOfCopyComTagContainers(*m_RcvTags);
 
+#ifdef BL_USE_MPI
+    for (auto const& kv : m_persistent_plans) {
+        cnt += kv.second->bytes();
+    }
+#endif
+
     return cnt;
 }
 
@@ -1012,6 +1033,177 @@ FabArrayBase::FB::define_epo (const FabArrayBase& fa)
 FabArrayBase::FB::~FB ()
 {}
 
+#ifdef BL_USE_MPI
+
+namespace {
+    MPI_Datatype persistent_comm_datatype (std::size_t nbytes, int& count)
+    {
+        const int comm_data_type = ParallelDescriptor::select_comm_data_type(nbytes);
+        if (comm_data_type == 1) {
+            count = static_cast<int>(nbytes);
+            return ParallelDescriptor::Mpi_typemap<char>::type();
+        } else if (comm_data_type == 2) {
+            count = static_cast<int>(nbytes/sizeof(unsigned long long));
+            return ParallelDescriptor::Mpi_typemap<unsigned long long>::type();
+        } else if (comm_data_type == 3) {
+            count = static_cast<int>(nbytes/sizeof(ParallelDescriptor::lull_t));
+            return ParallelDescriptor::Mpi_typemap<ParallelDescriptor::lull_t>::type();
+        } else {
+            amrex::Abort("TODO: message size is too big");
+            count = 0;
+            return MPI_DATATYPE_NULL;
+        }
+    }
+
+    std::size_t persistent_message_layout (const FabArrayBase::MapOfCopyComTagContainers& m,
+                                           bool is_recv, int ncomp,
+                                           std::size_t value_size, std::size_t value_align,
+                                           Vector<std::size_t>& size,
+                                           Vector<std::size_t>& offset,
+                                           Vector<const FabArrayBase::CopyComTagsContainer*>& cctc)
+    {
+        std::size_t total_volume = 0;
+        for (auto const& kv : m)
+        {
+            std::size_t nbytes = 0;
+            for (auto const& cct : kv.second)
+            {
+                const Box& bx = is_recv ? cct.dbox : cct.sbox;
+                nbytes += bx.numPts() * ncomp * value_size;
+            }
+
+            std::size_t acd = ParallelDescriptor::alignof_comm_data(nbytes);
+            nbytes = amrex::aligned_size(acd, nbytes);
+            total_volume = amrex::aligned_size(std::max(value_align,acd), total_volume);
+
+            offset.push_back(total_volume);
+            total_volume += nbytes;
+
+            size.push_back(nbytes);
+            cctc.push_back(&(kv.second));
+        }
+        return total_volume;
+    }
+}
+
+FabArrayBase::PersistentPlan::~PersistentPlan ()
+{
+    for (auto& r : recv_reqs) {
+        if (r != MPI_REQUEST_NULL) MPI_Request_free(&r);
+    }
+    for (auto& r : send_reqs) {
+        if (r != MPI_REQUEST_NULL) MPI_Request_free(&r);
+    }
+    if (the_recv_data) The_FA_Arena()->free(the_recv_data);
+    if (the_send_data) The_FA_Arena()->free(the_send_data);
+}
+
+Long
+FabArrayBase::PersistentPlan::bytes () const
+{
+    return sizeof(PersistentPlan) + total_bytes
+        + amrex::bytesOf(recv_data) + amrex::bytesOf(recv_size) + amrex::bytesOf(recv_cctc)
+        + amrex::bytesOf(send_data) + amrex::bytesOf(send_size) + amrex::bytesOf(send_cctc)
+        + amrex::bytesOf(recv_reqs) + amrex::bytesOf(send_reqs)
+        + amrex::bytesOf(recv_stat) + amrex::bytesOf(send_stat);
+}
+
+FabArrayBase::PersistentPlan*
+FabArrayBase::FB::getPersistentPlan (int ncomp, std::size_t value_size,
+                                     std::size_t value_align) const
+{
+    if (the_persistent_comm == MPI_COMM_NULL ||
+        ParallelContext::CommunicatorSub() != ParallelContext::CommunicatorAll())
+    {
+        return nullptr;
+    }
+
+    const auto key = std::make_pair(ncomp, value_size);
+    auto found = m_persistent_plans.find(key);
+    if (found != m_persistent_plans.end()) {
+        PersistentPlan* p = found->second.get();
+        return (p->in_use) ? nullptr : p;
+    }
+
+    BL_PROFILE("FabArrayBase::FB::getPersistentPlan()");
+
+    // Every process builds the plan in the same call, so the tag agrees.
+    std::unique_ptr<PersistentPlan> plan(new PersistentPlan);
+    plan->tag = the_persistent_tag;
+    the_persistent_tag = (the_persistent_tag < ParallelDescriptor::MaxTag())
+        ? the_persistent_tag+1 : 0;
+
+    Vector<std::size_t> recv_offset, send_offset;
+    const std::size_t recv_volume = persistent_message_layout
+        (*m_RcvTags, true, ncomp, value_size, value_align,
+         plan->recv_size, recv_offset, plan->recv_cctc);
+    const std::size_t send_volume = persistent_message_layout
+        (*m_SndTags, false, ncomp, value_size, value_align,
+         plan->send_size, send_offset, plan->send_cctc);
+    plan->total_bytes = recv_volume + send_volume;
+
+    if (recv_volume > 0) {
+        plan->the_recv_data = static_cast<char*>(The_FA_Arena()->alloc(recv_volume));
+    }
+    if (send_volume > 0) {
+        plan->the_send_data = static_cast<char*>(The_FA_Arena()->alloc(send_volume));
+    }
+
+    const int N_rcvs = plan->recv_size.size();
+    plan->recv_data.resize(N_rcvs, nullptr);
+    auto rit = m_RcvTags->cbegin();
+    for (int i = 0; i < N_rcvs; ++i, ++rit)
+    {
+        if (plan->recv_size[i] > 0)
+        {
+            plan->recv_data[i] = plan->the_recv_data + recv_offset[i];
+            int count;
+            MPI_Datatype dtype = persistent_comm_datatype(plan->recv_size[i], count);
+            MPI_Request req;
+            BL_MPI_REQUIRE( MPI_Recv_init(plan->recv_data[i], count, dtype,
+                                          ParallelContext::global_to_local_rank(rit->first),
+                                          plan->tag, the_persistent_comm, &req) );
+            plan->recv_reqs.push_back(req);
+        }
+        else
+        {
+            plan->recv_cctc[i] = nullptr;
+        }
+    }
+
+    const int N_snds = plan->send_size.size();
+    plan->send_data.resize(N_snds, nullptr);
+    auto sit = m_SndTags->cbegin();
+    for (int i = 0; i < N_snds; ++i, ++sit)
+    {
+        if (plan->send_size[i] > 0)
+        {
+            plan->send_data[i] = plan->the_send_data + send_offset[i];
+            int count;
+            MPI_Datatype dtype = persistent_comm_datatype(plan->send_size[i], count);
+            MPI_Request req;
+            BL_MPI_REQUIRE( MPI_Send_init(plan->send_data[i], count, dtype,
+                                          ParallelContext::global_to_local_rank(sit->first),
+                                          plan->tag, the_persistent_comm, &req) );
+            plan->send_reqs.push_back(req);
+        }
+    }
+
+    plan->recv_stat.resize(plan->recv_reqs.size());
+    plan->send_stat.resize(plan->send_reqs.size());
+
+#ifdef AMREX_MEM_PROFILING
+    m_FBC_stats.bytes += plan->bytes();
+    m_FBC_stats.bytes_hwm = std::max(m_FBC_stats.bytes_hwm, m_FBC_stats.bytes);
+#endif
+
+    PersistentPlan* r = plan.get();
+    m_persistent_plans.emplace(key, std::move(plan));
+    return r;
+}
+
+#endif
+
 void
 FabArrayBase::flushFB (bool no_assertion) const
 {
@@ -1403,6 +1595,14 @@ FabArrayBase::Finalize ()
     FabArrayBase::flushCPCache();
     FabArrayBase::flushTileArrayCache();
 
+#ifdef BL_USE_MPI
+    if (the_persistent_comm != MPI_COMM_NULL) {
+        BL_MPI_REQUIRE( MPI_Comm_free(&the_persistent_comm) );
+        the_persistent_comm = MPI_COMM_NULL;
+    }
+    the_persistent_tag = 0;
+#endif
+
     if (ParallelDescriptor::IOProcessor() && amrex::system::verbose > 1) {
 	m_FA_stats.print();
 	m_TAC_stats.print();
@@ -702,4 +702,94 @@ MFGhostIter::Initialize ()
     tile_array      = &(lta.tileArray);
 }
 
+MFSplitIter::MFSplitIter (const FabArrayBase& fabarray, Region region,
+                          const IntVect& stencil_width, const IntVect& tilesize)
+    :
+    MFIter(fabarray, tilesize, (unsigned char)(SkipInit|Tiling)),
+    m_region(region)
+{
+    Initialize(stencil_width);
+}
+
+void
+MFSplitIter::Initialize (const IntVect& stencil_width)
+{
+    int rit = 0;
+    int nworkers = 1;
+#ifdef BL_USE_TEAM
+    if (ParallelDescriptor::TeamSize() > 1) {
+	rit = ParallelDescriptor::MyRankInTeam();
+	nworkers = ParallelDescriptor::TeamSize();
+    }
+#endif
+
+    int tid = OpenMP::get_thread_num();
+    int nthreads = OpenMP::get_num_threads();
+
+    int npes = nworkers*nthreads;
+    int pid = rit*nthreads+tid;
+
+    BoxList alltiles;
+    Vector<int> allindex;
+    Vector<int> alllocalindex;
+
+    for (int i=0; i < fabArray.IndexArray().size(); ++i) {
+	int K = fabArray.IndexArray()[i];
+	const Box& vbx = fabArray.boxArray().getCellCenteredBox(K);
+	const Box& ibx = amrex::grow(vbx, -stencil_width);
+
+	BoxList parts;
+	if (m_region == Inner) {
+	    if (ibx.ok()) parts.push_back(ibx);
+	} else {
+	    if (ibx.ok()) {
+		parts = amrex::boxDiff(vbx, ibx);
+	    } else {
+		parts.push_back(vbx);
+	    }
+	}
+
+	for (BoxList::const_iterator bli = parts.begin(); bli != parts.end(); ++bli) {
+	    BoxList tiles(*bli, tile_size);
+	    int nt = tiles.size();
+	    for (int it=0; it<nt; ++it) {
+		allindex.push_back(K);
+		alllocalindex.push_back(i);
+	    }
+	    alltiles.catenate(tiles);
+	}
+    }
+
+    int n_tot_tiles = alltiles.size();
+    int navg = n_tot_tiles / npes;
+    int nleft = n_tot_tiles - navg*npes;
+    int ntiles = navg;
+    if (pid < nleft) ntiles++;
+
+    // how many tiles should we skip?
+    int nskip = pid*navg + std::min(pid,nleft);
+    BoxList::const_iterator bli = alltiles.begin();
+    for (int i=0; i<nskip; ++i) ++bli;
+
+    lta.indexMap.reserve(ntiles);
+    lta.localIndexMap.reserve(ntiles);
+    lta.tileArray.reserve(ntiles);
+
+    for (int i=0; i<ntiles; ++i) {
+	lta.indexMap.push_back(allindex[i+nskip]);
+	lta.localIndexMap.push_back(alllocalindex[i+nskip]);
+	lta.tileArray.push_back(*bli++);
+    }
+
+    currentIndex = beginIndex = 0;
+    endIndex = lta.indexMap.size();
+
+    lta.nuse = 0;
+    index_map       = &(lta.indexMap);
+    local_index_map = &(lta.localIndexMap);
+    tile_array      = &(lta.tileArray);
+
+    typ = fabArray.boxArray().ixType();
+}
+
 }
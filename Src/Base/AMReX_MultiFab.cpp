@@ -1335,12 +1335,15 @@ MultiFab::OverrideSync (const iMultiFab& msk, const Periodicity& period)
 void
 FillBoundary (Vector<MultiFab*> const& mf, const Periodicity& period)
 {
+#ifdef AMREX_USE_GPU
+    // The fused version is actually slower on summit
     for (auto x : mf) {
         x->FillBoundary(period);
     }
-// The following is actually slower on summit
-//    Vector<FabArray<FArrayBox>*> fa{mf.begin(),mf.end()};
-//    FillBoundary(fa,period);
+#else
+    Vector<FabArray<FArrayBox>*> fa{mf.begin(),mf.end()};
+    FillBoundary(fa,period);
+#endif
 }
 
 }
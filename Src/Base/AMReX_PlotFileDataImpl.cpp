@@ -142,4 +142,29 @@ PlotFileDataImpl::get (int level, std::string const& varname) noexcept
     return mf;
 }
 
+int
+PlotFileDataImpl::varIndex (std::string const& varname) const
+{
+    auto r = std::find(std::begin(m_var_names), std::end(m_var_names), varname);
+    if (r == std::end(m_var_names)) {
+        amrex::Abort("PlotFileDataImpl::varIndex: varname not found "+varname);
+    }
+    return std::distance(std::begin(m_var_names), r);
+}
+
+void
+PlotFileDataImpl::fill (int level, FArrayBox& fab, int scomp, int dcomp, int ncomp)
+{
+    if (m_ncomp == 0) return;
+    for (auto const& is : m_ba[level].intersections(fab.box())) {
+        m_vismf[level]->readRegion(is.first, is.second, scomp, ncomp, fab, dcomp);
+    }
+}
+
+void
+PlotFileDataImpl::fill (int level, std::string const& varname, FArrayBox& fab, int dcomp)
+{
+    fill(level, fab, varIndex(varname), dcomp, 1);
+}
+
 }
@@ -0,0 +1,427 @@
+
+#include <AMReX_TArena.H>
+#include <AMReX_Print.H>
+#include <AMReX_ParallelDescriptor.H>
+#include <AMReX_ParallelReduce.H>
+
+#include <algorithm>
+#include <map>
+
+namespace amrex {
+
+struct TArena::ThreadCache
+{
+    explicit ThreadCache (int nclasses)
+        : head(nclasses, nullptr), count(nclasses, 0) {}
+
+    std::vector<FreeBlock*> head;
+    std::vector<int>        count;
+
+    // These are only written by the owning thread.  They are atomic so that
+    // they can be read by stats() at any time.
+    std::atomic<Long> nalloc {0};
+    std::atomic<Long> nthread_hits {0};
+    std::atomic<Long> ncentral_hits {0};
+    std::atomic<Long> nsystem {0};
+    std::atomic<Long> bytes_requested {0};
+    std::atomic<Long> bytes_in_use {0};
+
+    std::atomic<bool> active {true};
+};
+
+namespace {
+
+    void add (std::atomic<Long>& x, Long v) noexcept
+    {
+        x.store(x.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+    }
+
+    //
+    // The live arenas, so that exiting threads do not return blocks to an
+    // arena that has been destroyed.
+    //
+    std::mutex tarena_registry_mutex;
+    std::atomic<int> tarena_next_id {0};
+
+    std::map<int,TArena*>& tarena_registry ()
+    {
+        static std::map<int,TArena*> r;
+        return r;
+    }
+
+    struct ThreadCacheHolder
+    {
+        std::vector<std::pair<int,TArena::ThreadCache*> > caches;
+        ~ThreadCacheHolder () { TArena::ReleaseThreadCaches(caches); }
+    };
+
+    thread_local ThreadCacheHolder t_caches;
+}
+
+constexpr std::size_t TArena::DefaultMaxCachedSize;
+constexpr std::size_t TArena::DefaultThreadCacheSize;
+constexpr std::size_t TArena::SlabSize;
+constexpr std::size_t TArena::HeaderSize;
+constexpr std::size_t TArena::SlabHeaderSize;
+constexpr std::uint32_t TArena::LargeClass;
+
+TArena::TArena (std::size_t max_cached_size, std::size_t thread_cache_size, ArenaInfo info)
+    : m_slabs(nullptr), m_heap(0), m_heap_hwm(0)
+{
+    arena_info = info;
+
+    m_max_cached = (max_cached_size == 0) ? DefaultMaxCachedSize : max_cached_size;
+    m_thread_cache_size = (thread_cache_size == 0) ? DefaultThreadCacheSize : thread_cache_size;
+
+    m_nclasses = SizeClass(m_max_cached) + 1;
+    m_central.reset(new std::atomic<FreeBlock*>[m_nclasses]);
+    for (int c = 0; c < m_nclasses; ++c) {
+        m_central[c].store(nullptr);
+    }
+
+    std::lock_guard<std::mutex> lock(tarena_registry_mutex);
+    m_id = tarena_next_id++;
+    tarena_registry()[m_id] = this;
+}
+
+TArena::~TArena ()
+{
+    {
+        std::lock_guard<std::mutex> lock(tarena_registry_mutex);
+        tarena_registry().erase(m_id);
+    }
+
+    Slab* s = m_slabs.load();
+    while (s)
+    {
+        Slab* next = s->next;
+        deallocate_system(s, s->size);
+        s = next;
+    }
+}
+
+int
+TArena::SizeClass (std::size_t sz) noexcept
+{
+    // Class 0 is 64 bytes.  Above that, there are four classes between
+    // consecutive powers of two.
+    if (sz <= 64) return 0;
+    const std::size_t v = sz-1;
+    int k = 6;
+    while (v >> (k+1)) ++k;
+    return 1 + (k-6)*4 + static_cast<int>((v >> (k-2)) & 3);
+}
+
+std::size_t
+TArena::ClassSize (int c) noexcept
+{
+    if (c == 0) return 64;
+    const int k = (c-1)/4 + 6;
+    const int sub = (c-1)%4;
+    return (std::size_t(1) << k) + (std::size_t(sub+1) << (k-2));
+}
+
+TArena::ThreadCache*
+TArena::getThreadCache ()
+{
+    for (auto const& p : t_caches.caches) {
+        if (p.first == m_id) return p.second;
+    }
+
+    // The first time this thread uses this arena.  Reuse the cache of a
+    // thread that has exited if there is one.
+    ThreadCache* tc = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_cache_mutex);
+        for (auto const& c : m_caches) {
+            bool expected = false;
+            if (c->active.compare_exchange_strong(expected, true)) {
+                tc = c.get();
+                break;
+            }
+        }
+        if (tc == nullptr) {
+            m_caches.emplace_back(new ThreadCache(m_nclasses));
+            tc = m_caches.back().get();
+        }
+    }
+    t_caches.caches.emplace_back(m_id, tc);
+    return tc;
+}
+
+void
+TArena::ReleaseThreadCaches (std::vector<std::pair<int,ThreadCache*> >& caches)
+{
+    std::lock_guard<std::mutex> lock(tarena_registry_mutex);
+    for (auto const& p : caches)
+    {
+        auto it = tarena_registry().find(p.first);
+        if (it != tarena_registry().end())
+        {
+            TArena* arena = it->second;
+            for (int c = 0; c < arena->m_nclasses; ++c) {
+                arena->flush(*p.second, c, 0);
+            }
+            p.second->active = false;
+        }
+    }
+    caches.clear();
+}
+
+void
+TArena::pushCentral (int c, FreeBlock* first, FreeBlock* last) noexcept
+{
+    FreeBlock* head = m_central[c].load(std::memory_order_relaxed);
+    do {
+        last->next = head;
+    } while (!m_central[c].compare_exchange_weak(head, first,
+                                                 std::memory_order_release,
+                                                 std::memory_order_relaxed));
+}
+
+void
+TArena::flush (ThreadCache& tc, int c, int nkeep)
+{
+    FreeBlock* last_kept = nullptr;
+    FreeBlock* b = tc.head[c];
+    for (int n = 0; n < nkeep && b; ++n) {
+        last_kept = b;
+        b = b->next;
+    }
+    if (b == nullptr) return;
+
+    if (last_kept) {
+        last_kept->next = nullptr;
+    } else {
+        tc.head[c] = nullptr;
+    }
+    tc.count[c] = nkeep;
+
+    FreeBlock* last = b;
+    while (last->next) last = last->next;
+    pushCentral(c, b, last);
+}
+
+void
+TArena::addHeap (std::size_t nbytes) noexcept
+{
+    const std::size_t heap = m_heap.fetch_add(nbytes) + nbytes;
+    std::size_t hwm = m_heap_hwm.load(std::memory_order_relaxed);
+    while (heap > hwm && !m_heap_hwm.compare_exchange_weak(hwm, heap)) {}
+}
+
+void*
+TArena::refill (ThreadCache& tc, int c)
+{
+    const std::size_t bsize = ClassSize(c);
+    const int limit = static_cast<int>(std::max(std::size_t(2), m_thread_cache_size/bsize));
+
+    //
+    // Take all the free blocks of this class from the central list.  Keep up
+    // to limit of them and give the rest back.
+    //
+    FreeBlock* chain = m_central[c].exchange(nullptr, std::memory_order_acquire);
+    if (chain)
+    {
+        add(tc.ncentral_hits, 1);
+        FreeBlock* b = chain;
+        FreeBlock* rest = chain->next;
+        FreeBlock* last = nullptr;
+        int n = 0;
+        tc.head[c] = rest;
+        while (rest && n < limit) {
+            last = rest;
+            rest = rest->next;
+            ++n;
+        }
+        tc.count[c] = n;
+        if (last) last->next = nullptr;
+        if (rest) {
+            FreeBlock* tail = rest;
+            while (tail->next) tail = tail->next;
+            pushCentral(c, rest, tail);
+        }
+        return b;
+    }
+
+    //
+    // Carve a new slab into blocks.
+    //
+    add(tc.nsystem, 1);
+    std::size_t nblocks = std::max(std::size_t(1), SlabSize/bsize);
+    std::size_t nbytes = SlabHeaderSize + nblocks*bsize;
+    if (arena_info.use_huge_pages) {
+        // Whole huge pages, so that allocate_system gives the slab huge pages
+        nbytes = amrex::aligned_size(Arena::huge_page_size, nbytes);
+        nblocks = (nbytes - SlabHeaderSize) / bsize;
+    }
+    Slab* s = static_cast<Slab*>(allocate_system(nbytes));
+    s->size = nbytes;
+    s->next = m_slabs.load(std::memory_order_relaxed);
+    while (!m_slabs.compare_exchange_weak(s->next, s)) {}
+    addHeap(nbytes);
+
+    char* p = reinterpret_cast<char*>(s) + SlabHeaderSize;
+    for (std::size_t i = nblocks-1; i >= 1; --i)
+    {
+        FreeBlock* b = reinterpret_cast<FreeBlock*>(p + i*bsize);
+        b->next = tc.head[c];
+        tc.head[c] = b;
+        ++tc.count[c];
+    }
+    if (tc.count[c] > limit) {
+        flush(tc, c, limit);
+    }
+
+    return p;
+}
+
+void*
+TArena::alloc (std::size_t nbytes)
+{
+    if (nbytes == 0) nbytes = 1;
+    const std::size_t total = Arena::align(nbytes) + HeaderSize;
+
+    ThreadCache& tc = *getThreadCache();
+    add(tc.nalloc, 1);
+    add(tc.bytes_requested, nbytes);
+
+    Header* h;
+    if (total > m_max_cached)
+    {
+        add(tc.nsystem, 1);
+        add(tc.bytes_in_use, total);
+        h = static_cast<Header*>(allocate_system(total));
+        addHeap(total);
+        h->size_class = LargeClass;
+    }
+    else
+    {
+        const int c = SizeClass(total);
+        add(tc.bytes_in_use, ClassSize(c));
+        FreeBlock* b = tc.head[c];
+        if (b)
+        {
+            add(tc.nthread_hits, 1);
+            tc.head[c] = b->next;
+            --tc.count[c];
+            h = reinterpret_cast<Header*>(b);
+        }
+        else
+        {
+            h = static_cast<Header*>(refill(tc, c));
+        }
+        h->size_class = c;
+    }
+    h->nbytes = nbytes;
+
+    return reinterpret_cast<char*>(h) + HeaderSize;
+}
+
+void
+TArena::free (void* vp)
+{
+    if (vp == nullptr) return;
+
+    Header* h = reinterpret_cast<Header*>(static_cast<char*>(vp) - HeaderSize);
+
+    ThreadCache& tc = *getThreadCache();
+    add(tc.bytes_requested, -static_cast<Long>(h->nbytes));
+
+    if (h->size_class == LargeClass)
+    {
+        const std::size_t total = Arena::align(h->nbytes) + HeaderSize;
+        add(tc.bytes_in_use, -static_cast<Long>(total));
+        deallocate_system(h, total);
+        m_heap.fetch_sub(total);
+    }
+    else
+    {
+        const int c = h->size_class;
+        const std::size_t bsize = ClassSize(c);
+        add(tc.bytes_in_use, -static_cast<Long>(bsize));
+        FreeBlock* b = reinterpret_cast<FreeBlock*>(h);
+        b->next = tc.head[c];
+        tc.head[c] = b;
+        const int limit = static_cast<int>(std::max(std::size_t(2), m_thread_cache_size/bsize));
+        if (++tc.count[c] > limit) {
+            flush(tc, c, limit/2);
+        }
+    }
+}
+
+std::size_t
+TArena::heap_space_used () const noexcept
+{
+    return m_heap.load();
+}
+
+std::size_t
+TArena::heap_space_high_water_mark () const noexcept
+{
+    return m_heap_hwm.load();
+}
+
+TArena::Stats
+TArena::stats () const
+{
+    Stats r;
+    std::lock_guard<std::mutex> lock(m_cache_mutex);
+    for (auto const& tc : m_caches)
+    {
+        r.nalloc          += tc->nalloc.load(std::memory_order_relaxed);
+        r.nthread_hits    += tc->nthread_hits.load(std::memory_order_relaxed);
+        r.ncentral_hits   += tc->ncentral_hits.load(std::memory_order_relaxed);
+        r.nsystem         += tc->nsystem.load(std::memory_order_relaxed);
+        r.bytes_requested += tc->bytes_requested.load(std::memory_order_relaxed);
+        r.bytes_in_use    += tc->bytes_in_use.load(std::memory_order_relaxed);
+    }
+    return r;
+}
+
+void
+TArena::PrintUsage (std::string const& name) const
+{
+    const Stats s = stats();
+
+    Long min_megabytes = heap_space_used() / (1024*1024);
+    Long max_megabytes = min_megabytes;
+    Long hwm_min_megabytes = heap_space_high_water_mark() / (1024*1024);
+    Long hwm_max_megabytes = hwm_min_megabytes;
+    Long used_min_megabytes = s.bytes_in_use / (1024*1024);
+    Long used_max_megabytes = used_min_megabytes;
+    const int IOProc = ParallelDescriptor::IOProcessorNumber();
+    ParallelReduce::Min<Long>({min_megabytes, hwm_min_megabytes, used_min_megabytes},
+                              IOProc, ParallelDescriptor::Communicator());
+    ParallelReduce::Max<Long>({max_megabytes, hwm_max_megabytes, used_max_megabytes},
+                              IOProc, ParallelDescriptor::Communicator());
+
+    const Real nalloc = std::max(Long(1), s.nalloc);
+    const Real thread_hit_rate = s.nthread_hits / nalloc;
+    const Real central_hit_rate = s.ncentral_hits / nalloc;
+    const Real internal_frag = (s.bytes_in_use > 0)
+        ? 1.0 - Real(s.bytes_requested)/Real(s.bytes_in_use) : 0.0;
+    const Real cached_frac = (heap_space_used() > 0)
+        ? 1.0 - Real(s.bytes_in_use)/Real(heap_space_used()) : 0.0;
+
+#ifdef AMREX_USE_MPI
+    amrex::Print() << "[" << name << "]" << " space (MB) allocated spread across MPI: ["
+                   << min_megabytes << " ... " << max_megabytes << "]\n"
+                   << "[" << name << "]" << " space (MB) used      spread across MPI: ["
+                   << used_min_megabytes << " ... " << used_max_megabytes << "]\n"
+                   << "[" << name << "]" << " space (MB) high water mark across MPI: ["
+                   << hwm_min_megabytes << " ... " << hwm_max_megabytes << "]\n";
+#else
+    amrex::Print() << "[" << name << "]" << " space allocated (MB): " << min_megabytes << "\n";
+    amrex::Print() << "[" << name << "]" << " space used      (MB): " << used_min_megabytes << "\n";
+    amrex::Print() << "[" << name << "]" << " high water mark (MB): " << hwm_min_megabytes << "\n";
+#endif
+    amrex::Print() << "[" << name << "]" << " thread cache hit rate: " << thread_hit_rate
+                   << ", central list hit rate: " << central_hit_rate
+                   << " (on I/O rank)\n"
+                   << "[" << name << "]" << " internal fragmentation: " << internal_frag
+                   << ", fraction of space cached: " << cached_frac
+                   << " (on I/O rank)\n";
+}
+
+}
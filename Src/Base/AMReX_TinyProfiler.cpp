@@ -12,6 +12,7 @@
 #include <AMReX_ParallelReduce.H>
 #include <AMReX_Utility.H>
 #include <AMReX_Print.H>
+#include <AMReX_ArenaTrace.H>
 
 #ifdef AMREX_USE_CUPTI
 #include <AMReX_CuptiTrace.H>
@@ -87,6 +88,8 @@ TinyProfiler::start () noexcept
 	ttstack.emplace_back(std::make_tuple(t, 0.0, &fname));
 	global_depth = ttstack.size();
 
+        if (ArenaTrace::Enabled()) ArenaTrace::PushRegion(fname);
+
 #ifdef AMREX_USE_CUDA
 	nvtxRangePush(fname.c_str());
 #endif
@@ -170,6 +173,8 @@ TinyProfiler::stop () noexcept
 	}
 
     stats.clear();
+
+    if (ArenaTrace::Enabled()) ArenaTrace::PopRegion();
     }
 }
 
@@ -239,6 +244,8 @@ TinyProfiler::stop (unsigned boxUintID) noexcept
         }
 
         stats.clear();
+
+        if (ArenaTrace::Enabled()) ArenaTrace::PopRegion();
     }
 }
 #endif
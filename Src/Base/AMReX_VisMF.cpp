@@ -4,6 +4,7 @@
 #include <vector>
 #include <deque>
 #include <cerrno>
+#include <cstring>
 #include <atomic>
 #include <cstdio>
 #include <limits>
@@ -19,6 +20,14 @@
 #include <AMReX_FPC.H>
 #include <AMReX_FabArrayUtility.H>
 #include <AMReX_AsyncOut.H>
+#include <AMReX_ParallelReduce.H>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 namespace amrex {
 
@@ -39,6 +48,12 @@ bool VisMF::usePersistentIFStreams(false);
 bool VisMF::useSynchronousReads(false);
 bool VisMF::useDynamicSetSelection(true);
 bool VisMF::allowSparseWrites(true);
+bool VisMF::useMMap(true);
+bool VisMF::useMPIIO(false);
+int VisMF::mpiioAggregators(1);
+IntVect VisMF::brickSize(AMREX_D_DECL(32,32,32));
+Vector<Compression::Codec> VisMF::compressionCodecs;
+Vector<Real> VisMF::compressionTolerances;
 
 Long VisMF::ioBufferSize(VisMF::IO_Buffer_Size);
 
@@ -51,6 +66,30 @@ int VisMF::nMFFileInStreams(4);
 namespace
 {
     bool initialized = false;
+
+    //! Copy the cells of region of one component from src, laid out on srcbox,
+    //! to dst, laid out on dstbox, a contiguous run in x at a time.  src need
+    //! not be aligned.
+    void copy_runs (const char* src, const Box& srcbox, char* dst, const Box& dstbox,
+                    const Box& region)
+    {
+        const auto slo  = amrex::lbound(srcbox);
+        const auto slen = amrex::length(srcbox);
+        const auto dlo  = amrex::lbound(dstbox);
+        const auto dlen = amrex::length(dstbox);
+        const auto lo   = amrex::lbound(region);
+        const auto hi   = amrex::ubound(region);
+        const std::size_t runBytes = (hi.x - lo.x + 1) * sizeof(Real);
+        for (int k = lo.z; k <= hi.z; ++k) {
+            for (int j = lo.y; j <= hi.y; ++j) {
+                const Long is = (lo.x - slo.x) + Long(j - slo.y) * slen.x
+                                               + Long(k - slo.z) * slen.x * slen.y;
+                const Long id = (lo.x - dlo.x) + Long(j - dlo.y) * dlen.x
+                                               + Long(k - dlo.z) * dlen.x * dlen.y;
+                std::memcpy(dst + id*sizeof(Real), src + is*sizeof(Real), runBytes);
+            }
+        }
+    }
 }
 
 void
@@ -87,6 +126,31 @@ VisMF::Initialize ()
     pp.query("usedynamicsetselection", useDynamicSetSelection);
     pp.query("iobuffersize", ioBufferSize);
     pp.query("allowsparsewrites", allowSparseWrites);
+    pp.query("usemmap", useMMap);
+    pp.query("usempiio", useMPIIO);
+    pp.query("mpiioaggregators", mpiioAggregators);
+    if(pp.contains("bricksize")) {
+      Vector<int> bs;
+      pp.getarr("bricksize", bs);
+      AMREX_ALWAYS_ASSERT_WITH_MESSAGE(!bs.empty(), "vismf.bricksize must not be empty");
+      for(int i(0); i < AMREX_SPACEDIM; ++i) {
+        brickSize[i] = bs[std::min(i, int(bs.size())-1)];
+      }
+      AMREX_ALWAYS_ASSERT_WITH_MESSAGE(brickSize.allGT(IntVect::TheZeroVector()),
+                                       "vismf.bricksize must be positive");
+    }
+
+    if(pp.contains("compression")) {
+      Vector<std::string> codecNames;
+      Vector<Real> tolerances;
+      pp.queryarr("compression", codecNames);
+      pp.queryarr("compression_tolerance", tolerances);
+      Vector<Compression::Codec> codecs;
+      for(auto const& name : codecNames) {
+        codecs.push_back(Compression::CodecFromName(name));
+      }
+      SetCompression(codecs, tolerances);
+    }
 
     initialized = true;
 }
@@ -285,7 +349,9 @@ operator<< (std::ostream        &os,
     os << hd.m_fod      << '\n';
 
     if(hd.m_vers == VisMF::Header::Version_v1 ||
-       hd.m_vers == VisMF::Header::NoFabHeaderMinMax_v1)
+       hd.m_vers == VisMF::Header::NoFabHeaderMinMax_v1 ||
+       hd.m_vers == VisMF::Header::Compressed_v1 ||
+       hd.m_vers == VisMF::Header::Bricked_v1)
     {
       os << hd.m_min      << '\n';
       os << hd.m_max      << '\n';
@@ -317,6 +383,36 @@ operator<< (std::ostream        &os,
       }
     }
 
+    if(hd.m_vers == VisMF::Header::Compressed_v1)
+    {
+      // ---- compressed data are always in the native format
+      os << FPC::NativeRealDescriptor() << '\n';
+      BL_ASSERT(hd.m_codec.size() == hd.m_ncomp);
+      BL_ASSERT(hd.m_tolerance.size() == hd.m_ncomp);
+      for(int i(0); i < hd.m_codec.size(); ++i) {
+        os << hd.m_codec[i] << ',';
+      }
+      os << '\n';
+      for(int i(0); i < hd.m_tolerance.size(); ++i) {
+        os << hd.m_tolerance[i] << ',';
+      }
+      os << '\n';
+      BL_ASSERT(hd.m_compsize.size() == hd.m_ba.size());
+      for(int j(0); j < hd.m_compsize.size(); ++j) {
+        for(int i(0); i < hd.m_compsize[j].size(); ++i) {
+          os << hd.m_compsize[j][i] << ',';
+        }
+        os << '\n';
+      }
+    }
+
+    if(hd.m_vers == VisMF::Header::Bricked_v1)
+    {
+      // ---- bricked data are always in the native format
+      os << FPC::NativeRealDescriptor() << '\n';
+      os << hd.m_bricksize << '\n';
+    }
+
     os.flags(oflags);
     os.precision(oldPrec);
 
@@ -369,7 +465,9 @@ operator>> (std::istream  &is,
     BL_ASSERT(hd.m_ba.size() == hd.m_fod.size());
 
     if(hd.m_vers == VisMF::Header::Version_v1 ||
-       hd.m_vers == VisMF::Header::NoFabHeaderMinMax_v1)
+       hd.m_vers == VisMF::Header::NoFabHeaderMinMax_v1 ||
+       hd.m_vers == VisMF::Header::Compressed_v1 ||
+       hd.m_vers == VisMF::Header::Bricked_v1)
     {
       is >> hd.m_min;
       is >> hd.m_max;
@@ -401,6 +499,42 @@ operator>> (std::istream  &is,
       is >> hd.m_writtenRD;
     }
 
+    if(hd.m_vers == VisMF::Header::Compressed_v1)
+    {
+      is >> hd.m_writtenRD;
+      char ch;
+      hd.m_codec.resize(hd.m_ncomp);
+      hd.m_tolerance.resize(hd.m_ncomp);
+      hd.m_compsize.resize(hd.m_ba.size());
+      for(int i(0); i < hd.m_codec.size(); ++i) {
+        is >> hd.m_codec[i] >> ch;
+        if( ch != ',' ) {
+          amrex::Error("Expected a ',' when reading hd.m_codec");
+        }
+      }
+      for(int i(0); i < hd.m_tolerance.size(); ++i) {
+        is >> hd.m_tolerance[i] >> ch;
+        if( ch != ',' ) {
+          amrex::Error("Expected a ',' when reading hd.m_tolerance");
+        }
+      }
+      for(int j(0); j < hd.m_compsize.size(); ++j) {
+        hd.m_compsize[j].resize(hd.m_ncomp);
+        for(int i(0); i < hd.m_ncomp; ++i) {
+          is >> hd.m_compsize[j][i] >> ch;
+          if( ch != ',' ) {
+            amrex::Error("Expected a ',' when reading hd.m_compsize");
+          }
+        }
+      }
+    }
+
+    if(hd.m_vers == VisMF::Header::Bricked_v1)
+    {
+      is >> hd.m_writtenRD;
+      is >> hd.m_bricksize;
+    }
+
 
     if( ! is.good()) {
         amrex::Error("Read of VisMF::Header failed");
@@ -948,6 +1082,13 @@ VisMF::Write (const FabArray<FArrayBox>&    mf,
     BL_ASSERT(mf_name[mf_name.length() - 1] != '/');
     BL_ASSERT(currentVersion != VisMF::Header::Undefined_v1);
 
+    // ---- bricked data are always written in the native format
+    const bool bricked(currentVersion == VisMF::Header::Bricked_v1);
+    const FABio::Format prevFormat(FArrayBox::getFormat());
+    if(bricked) {
+      FArrayBox::setFormat(FABio::FAB_NATIVE);
+    }
+
     // ---- add stream retry
     // ---- add stream buffer (to nfiles)
     RealDescriptor *whichRD = nullptr;
@@ -992,26 +1133,28 @@ VisMF::Write (const FabArray<FArrayBox>&    mf,
 
     amrex::prefetchToHost(mf);
 
-    // ---- check if mf has sparse data
-    bool useSparseFPP(false);
-    const Vector<int> &pmap = mf.DistributionMap().ProcessorMap();
-    std::set<int> procsWithData;
-    Vector<int> procsWithDataVector;
-    for(int i(0); i < pmap.size(); ++i) {
-      procsWithData.insert(pmap[i]);
-    }
-    if(allowSparseWrites && (procsWithData.size() < nOutFiles)) {
-      useSparseFPP = true;
-//      amrex::Print() << "SSSSSSSS:  in VisMF::Write:  useSparseFPP for:  " << mf_name << '\n';
-      for(std::set<int>::iterator it = procsWithData.begin(); it != procsWithData.end(); ++it) {
-        procsWithDataVector.push_back(*it);
-      }
+    if(UseCompression()) {
+        delete whichRD;
+        FArrayBox::setFormat(prevFormat);
+        return WriteCompressed(mf, mf_name, how);
     }
 
     int coordinatorProc(ParallelDescriptor::IOProcessorNumber());
     Long bytesWritten(0);
     bool calcMinMax(false);
     VisMF::Header hdr(mf, how, currentVersion, calcMinMax);
+    if(bricked) {
+      hdr.m_bricksize = brickSize;
+    }
+
+#ifdef BL_USE_MPI
+    if(how == MPIIO || useMPIIO) {
+      bytesWritten = WriteMPIIO(mf, mf_name, hdr, *whichRD);
+      delete whichRD;
+      FArrayBox::setFormat(prevFormat);
+      return bytesWritten;
+    }
+#endif
 
     std::string filePrefix(mf_name + FabFileSuffix);
 
@@ -1019,11 +1162,8 @@ VisMF::Write (const FabArray<FArrayBox>&    mf,
 
     bool oldHeader(currentVersion == VisMF::Header::Version_v1);
 
-    if(useSparseFPP) {
-        nfi.SetSparseFPP(procsWithDataVector);
-    } else if(useDynamicSetSelection) {
-        nfi.SetDynamic();
-    }
+    SetNFilesIterSets(nfi, mf.DistributionMap());
+
     for( ; nfi.ReadyToWrite(); ++nfi) {
         // ---- find the total number of bytes including fab headers if needed
         const FABio &fio = FArrayBox::getFABio();
@@ -1065,7 +1205,9 @@ VisMF::Write (const FabArray<FArrayBox>&    mf,
                     auto tstr = hss.str();
                     memcpy(afPtr, tstr.c_str(), hLength);  // ---- the fab header
                 }
-                if(doConvert) {
+                if(bricked) {
+                    VisMF::BrickFab(fab, brickSize, afPtr + hLength);
+                } else if(doConvert) {
                     RealDescriptor::convertFromNativeFormat(static_cast<void *> (afPtr + hLength),
                                                             writeDataItems,
                                                             fab.dataPtr(), *whichRD);
@@ -1092,7 +1234,12 @@ VisMF::Write (const FabArray<FArrayBox>&    mf,
                     nfi.Stream().write(tstr.c_str(), hLength);    // ---- the fab header
                     nfi.Stream().flush();
                 }
-                if(doConvert) {
+                if(bricked) {
+                    Vector<char> bricks(writeDataSize);
+                    VisMF::BrickFab(fab, brickSize, bricks.dataPtr());
+                    nfi.Stream().write(bricks.dataPtr(), writeDataSize);
+                    nfi.Stream().flush();
+                } else if(doConvert) {
                     char *cDataPtr = new char[writeDataSize];
                     RealDescriptor::convertFromNativeFormat(static_cast<void *> (cDataPtr),
                                                             writeDataItems,
@@ -1117,7 +1264,8 @@ VisMF::Write (const FabArray<FArrayBox>&    mf,
     }
 
     if(currentVersion == VisMF::Header::Version_v1 ||
-       currentVersion == VisMF::Header::NoFabHeaderMinMax_v1)
+       currentVersion == VisMF::Header::NoFabHeaderMinMax_v1 ||
+       currentVersion == VisMF::Header::Bricked_v1)
     {
         hdr.CalculateMinMax(mf, coordinatorProc);
     }
@@ -1128,6 +1276,371 @@ VisMF::Write (const FabArray<FArrayBox>&    mf,
     bytesWritten += VisMF::WriteHeader(mf_name, hdr, coordinatorProc);
 
     delete whichRD;
+    FArrayBox::setFormat(prevFormat);
+
+    return bytesWritten;
+}
+
+
+Long
+VisMF::WriteMPIIO (const FabArray<FArrayBox> &mf,
+                   const std::string& mf_name,
+                   VisMF::Header &hdr,
+                   const RealDescriptor &whichRD)
+{
+    BL_PROFILE("VisMF::WriteMPIIO()");
+
+    Long bytesWritten(0);
+#ifdef BL_USE_MPI
+    MPI_Comm comm(ParallelDescriptor::Communicator());
+    const int coordinatorProc(ParallelDescriptor::IOProcessorNumber());
+    const bool oldHeader(hdr.m_vers == VisMF::Header::Version_v1);
+    const bool bricked(hdr.m_vers == VisMF::Header::Bricked_v1);
+    const bool doConvert(whichRD != FPC::NativeRealDescriptor());
+    const int whichRDBytes(whichRD.numBytes());
+    const FABio &fio = FArrayBox::getFABio();
+
+    // ---- pack the local fabs, each with its fab header if needed, in MFIter order
+    Vector<Long> fabHead(mf.size(), 0);
+    Vector<std::string> fabHeaders;
+    for(MFIter mfi(mf); mfi.isValid(); ++mfi) {
+      std::string tstr;
+      if(oldHeader) {
+        std::stringstream hss;
+        fio.write_header(hss, mf[mfi], mf.nComp());
+        tstr = hss.str();
+      }
+      fabHead[mfi.index()] = bytesWritten;
+      bytesWritten += tstr.size() + mf[mfi].box().numPts() * mf.nComp() * whichRDBytes;
+      fabHeaders.push_back(std::move(tstr));
+    }
+
+    Vector<char> allFabData(bytesWritten);
+    int ifab(0);
+    for(MFIter mfi(mf); mfi.isValid(); ++mfi, ++ifab) {
+      const FArrayBox &fab = mf[mfi];
+      const Long writeDataItems(fab.box().numPts() * mf.nComp());
+      char *afPtr = allFabData.dataPtr() + fabHead[mfi.index()];
+      const std::string &tstr = fabHeaders[ifab];
+      memcpy(afPtr, tstr.c_str(), tstr.size());
+      afPtr += tstr.size();
+      if(bricked) {
+        VisMF::BrickFab(fab, hdr.m_bricksize, afPtr);
+      } else if(doConvert) {
+        RealDescriptor::convertFromNativeFormat(static_cast<void *> (afPtr),
+                                                writeDataItems, fab.dataPtr(), whichRD);
+      } else {
+        memcpy(afPtr, fab.dataPtr(), writeDataItems * whichRDBytes);
+      }
+    }
+
+    // ---- the offset of the data of this process in the file
+    Long myOffset(0);
+    BL_MPI_REQUIRE( MPI_Exscan(&bytesWritten, &myOffset, 1,
+                               ParallelDescriptor::Mpi_typemap<Long>::type(), MPI_SUM, comm) );
+    if(ParallelDescriptor::MyProc() == 0) {
+      myOffset = 0;
+    }
+
+    // ---- hints for the two-phase collective buffering of ROMIO
+    MPI_Info info;
+    BL_MPI_REQUIRE( MPI_Info_create(&info) );
+    BL_MPI_REQUIRE( MPI_Info_set(info, const_cast<char *>("romio_cb_write"),
+                                 const_cast<char *>("enable")) );
+    const std::string cbConfigList("*:" + std::to_string(std::max(1, mpiioAggregators)));
+    BL_MPI_REQUIRE( MPI_Info_set(info, const_cast<char *>("cb_config_list"),
+                                 const_cast<char *>(cbConfigList.c_str())) );
+
+    const std::string fileName(mf_name + FabFileSuffix + "00000");
+    MPI_File fh;
+    int rc = MPI_File_open(comm, const_cast<char *>(fileName.c_str()),
+                           MPI_MODE_CREATE | MPI_MODE_WRONLY, info, &fh);
+    if(rc != MPI_SUCCESS) {
+      amrex::FileOpenFailed(fileName);
+    }
+    BL_MPI_REQUIRE( MPI_File_set_size(fh, 0) );
+
+    // ---- every process takes part in every collective write, in chunks
+    // ---- whose byte counts fit in an int
+    const Long chunkSize(1L << 30);
+    Long maxBytes(bytesWritten);
+    ParallelDescriptor::ReduceLongMax(maxBytes);
+    const Long nChunks((maxBytes + chunkSize - 1) / chunkSize);
+    for(Long ichunk(0); ichunk < nChunks; ++ichunk) {
+      const Long pos(std::min(ichunk * chunkSize, bytesWritten));
+      const int count(static_cast<int>(std::min(chunkSize, bytesWritten - pos)));
+      BL_MPI_REQUIRE( MPI_File_write_at_all(fh, myOffset + pos, allFabData.dataPtr() + pos,
+                                            count, MPI_BYTE, MPI_STATUS_IGNORE) );
+    }
+
+    BL_MPI_REQUIRE( MPI_File_close(&fh) );
+    BL_MPI_REQUIRE( MPI_Info_free(&info) );
+
+    // ---- the header is that of NFiles with one file
+    hdr.m_how = VisMF::NFiles;
+    for(MFIter mfi(mf); mfi.isValid(); ++mfi) {
+      fabHead[mfi.index()] += myOffset;
+    }
+    ParallelDescriptor::ReduceLongSum(fabHead.dataPtr(), fabHead.size(), coordinatorProc);
+    if(ParallelDescriptor::MyProc() == coordinatorProc) {
+      for(int i(0); i < mf.size(); ++i) {
+        hdr.m_fod[i].m_name = VisMF::BaseName(fileName);
+        hdr.m_fod[i].m_head = fabHead[i];
+      }
+    }
+
+    if(hdr.m_vers == VisMF::Header::Version_v1 ||
+       hdr.m_vers == VisMF::Header::NoFabHeaderMinMax_v1 ||
+       hdr.m_vers == VisMF::Header::Bricked_v1)
+    {
+      hdr.CalculateMinMax(mf, coordinatorProc);
+    }
+
+    bytesWritten += VisMF::WriteHeader(mf_name, hdr, coordinatorProc);
+#else
+    amrex::ignore_unused(mf, mf_name, hdr, whichRD);
+#endif
+    return bytesWritten;
+}
+
+
+Vector<Box>
+VisMF::MakeBricks (const Box& fab_box, const IntVect& bricksize)
+{
+    Dim3 bs{1,1,1};
+    AMREX_D_TERM(bs.x = bricksize[0];, bs.y = bricksize[1];, bs.z = bricksize[2];)
+    const auto lo = amrex::lbound(fab_box);
+    const auto hi = amrex::ubound(fab_box);
+    Vector<Box> bricks;
+    for(int k(lo.z); k <= hi.z; k += bs.z) {
+      for(int j(lo.y); j <= hi.y; j += bs.y) {
+        for(int i(lo.x); i <= hi.x; i += bs.x) {
+          const IntVect small(AMREX_D_DECL(i,j,k));
+          bricks.push_back(Box(small, small + bricksize - 1, fab_box.ixType()) & fab_box);
+        }
+      }
+    }
+    return bricks;
+}
+
+void
+VisMF::BrickFab (const FArrayBox& fab, const IntVect& bricksize, char* buf)
+{
+    const Box& fab_box = fab.box();
+    const Vector<Box> bricks = MakeBricks(fab_box, bricksize);
+    for(int n(0); n < fab.nComp(); ++n) {
+      const char *src = reinterpret_cast<const char*>(fab.dataPtr(n));
+      for(auto const& brick : bricks) {
+        copy_runs(src, fab_box, buf, brick, brick);
+        buf += brick.numPts() * sizeof(Real);
+      }
+    }
+}
+
+void
+VisMF::UnBrickFab (const char* buf, const IntVect& bricksize, FArrayBox& fab,
+                   int dcomp, int ncomp)
+{
+    const Box& fab_box = fab.box();
+    const Vector<Box> bricks = MakeBricks(fab_box, bricksize);
+    for(int n(0); n < ncomp; ++n) {
+      char *dst = reinterpret_cast<char*>(fab.dataPtr(dcomp+n));
+      for(auto const& brick : bricks) {
+        copy_runs(buf, brick, dst, fab_box, brick);
+        buf += brick.numPts() * sizeof(Real);
+      }
+    }
+}
+
+void
+VisMF::SetCompression (const Vector<Compression::Codec>& codecs,
+                       const Vector<Real>& tolerances)
+{
+    compressionCodecs = codecs;
+    compressionTolerances = tolerances;
+}
+
+bool
+VisMF::UseCompression ()
+{
+    for(auto codec : compressionCodecs) {
+      if(codec != Compression::NoCompression) {
+        return true;
+      }
+    }
+    return false;
+}
+
+void
+VisMF::SetHeaderCompression (VisMF::Header& hdr)
+{
+    BL_ASSERT(hdr.m_vers == VisMF::Header::Compressed_v1);
+    hdr.m_codec.resize(hdr.m_ncomp);
+    hdr.m_tolerance.resize(hdr.m_ncomp);
+    for(int i(0); i < hdr.m_ncomp; ++i) {
+      hdr.m_codec[i] = compressionCodecs.empty() ? Compression::NoCompression
+                     : compressionCodecs[std::min(i, int(compressionCodecs.size())-1)];
+      hdr.m_tolerance[i] = compressionTolerances.empty() ? 0.0
+                     : compressionTolerances[std::min(i, int(compressionTolerances.size())-1)];
+    }
+    hdr.m_writtenRD = FPC::NativeRealDescriptor();
+    hdr.m_compsize.resize(hdr.m_ba.size());
+}
+
+void
+VisMF::CompressFab (const FArrayBox& fab, const VisMF::Header& hdr,
+                    Vector<char>& buf, Long* compsize)
+{
+    const Long npts = fab.box().numPts();
+    for(int i(0); i < hdr.m_ncomp; ++i) {
+      compsize[i] = Compression::Compress(fab.dataPtr(i), npts,
+                                          static_cast<Compression::Codec>(hdr.m_codec[i]),
+                                          hdr.m_tolerance[i], buf);
+    }
+}
+
+void
+VisMF::ReadCompressed (std::istream& is, const VisMF::Header& hdr, int idx,
+                       FArrayBox& fab, int scomp, int dcomp, int ncomp)
+{
+    BL_ASSERT(Compressed(hdr));
+    BL_ASSERT(scomp+ncomp <= hdr.m_ncomp && dcomp+ncomp <= fab.nComp());
+
+    const Vector<Long>& compsize = hdr.m_compsize[idx];
+    Long skip(0);
+    for(int i(0); i < scomp; ++i) {
+      skip += compsize[i];
+    }
+    is.seekg(hdr.m_fod[idx].m_head + skip, std::ios::beg);
+
+    Vector<char> buf;
+    for(int i(0); i < ncomp; ++i) {
+      buf.resize(compsize[scomp+i]);
+      is.read(buf.data(), buf.size());
+      if( ! is.good()) {
+        amrex::Error("VisMF::ReadCompressed:  read failed");
+      }
+      Compression::Decompress(buf.data(), buf.size(), fab.dataPtr(dcomp+i), fab.box().numPts());
+    }
+}
+
+void
+VisMF::SetNFilesIterSets (NFilesIter &nfi, const DistributionMapping &dm)
+{
+    const Vector<int> &pmap = dm.ProcessorMap();
+    std::set<int> procsWithData(pmap.begin(), pmap.end());
+    if(allowSparseWrites && (static_cast<int>(procsWithData.size()) < nOutFiles)) {
+      nfi.SetSparseFPP(Vector<int>(procsWithData.begin(), procsWithData.end()));
+    } else if(useDynamicSetSelection) {
+      nfi.SetDynamic();
+    }
+}
+
+Long
+VisMF::WriteCompressed (const FabArray<FArrayBox> &mf,
+                        const std::string& mf_name,
+                        VisMF::How how)
+{
+    BL_PROFILE("VisMF::WriteCompressed()");
+
+    const int myProc(ParallelDescriptor::MyProc());
+    const int nProcs(ParallelDescriptor::NProcs());
+    const int ncomp(mf.nComp());
+
+    bool calcMinMax(false);
+    VisMF::Header hdr(mf, how, VisMF::Header::Compressed_v1, calcMinMax);
+    SetHeaderCompression(hdr);
+
+    // ---- compress before entering the file sets so all ranks do it at once
+    // ---- each fab contributes its offset, ncomp sizes, ncomp mins and ncomp maxes
+    Vector<char> buf;
+    Vector<Long> lsend;
+    Vector<Real> rsend;
+    int nFABs(0);
+    for(MFIter mfi(mf); mfi.isValid(); ++mfi) {
+      const FArrayBox &fab = mf[mfi];
+      const Box &vbx = mf.box(mfi.index());
+      lsend.push_back(buf.size());
+      lsend.resize(lsend.size() + ncomp);
+      CompressFab(fab, hdr, buf, lsend.dataPtr() + lsend.size() - ncomp);
+      for(int i(0); i < ncomp; ++i) {
+        rsend.push_back(fab.min<RunOn::Host>(vbx, i));
+      }
+      for(int i(0); i < ncomp; ++i) {
+        rsend.push_back(fab.max<RunOn::Host>(vbx, i));
+      }
+      ++nFABs;
+    }
+
+    int coordinatorProc(ParallelDescriptor::IOProcessorNumber());
+    std::string filePrefix(mf_name + FabFileSuffix);
+    NFilesIter nfi(nOutFiles, filePrefix, groupSets, setBuf);
+    SetNFilesIterSets(nfi, mf.DistributionMap());
+
+    int myFileNumber(-1);
+    for( ; nfi.ReadyToWrite(); ++nfi) {
+      const Long head = VisMF::FileOffset(nfi.Stream());
+      for(int j(0); j < nFABs; ++j) {
+        lsend[j*(ncomp+1)] += head;
+      }
+      nfi.Stream().write(buf.dataPtr(), buf.size());
+      nfi.Stream().flush();
+      myFileNumber = nfi.FileNumber();
+    }
+
+    if(nfi.GetDynamic()) {
+      coordinatorProc = nfi.CoordinatorProc();
+    }
+
+    Long bytesWritten(buf.size());
+
+    // ---- collect the offsets, sizes, min and max values and file numbers
+    const Vector<int> &pmap = mf.DistributionMap().ProcessorMap();
+    Vector<int> nfabs(nProcs, 0);
+    for(int i(0), N(pmap.size()); i < N; ++i) {
+      ++nfabs[pmap[i]];
+    }
+    Vector<int> lcnt(nProcs), rcnt(nProcs), ldisp(nProcs, 0), rdisp(nProcs, 0);
+    for(int i(0); i < nProcs; ++i) {
+      lcnt[i] = nfabs[i] * (ncomp+1);
+      rcnt[i] = nfabs[i] * 2*ncomp;
+      if(i > 0) {
+        ldisp[i] = ldisp[i-1] + lcnt[i-1];
+        rdisp[i] = rdisp[i-1] + rcnt[i-1];
+      }
+    }
+    const bool iAmCoordinator(myProc == coordinatorProc);
+#ifdef BL_USE_MPI
+    Vector<Long> lrecv(iAmCoordinator ? mf.size()*(ncomp+1) : 0);
+    Vector<Real> rrecv(iAmCoordinator ? mf.size()*2*ncomp : 0);
+    ParallelDescriptor::Gatherv(lsend.dataPtr(), lsend.size(), lrecv.dataPtr(),
+                                lcnt, ldisp, coordinatorProc);
+    ParallelDescriptor::Gatherv(rsend.dataPtr(), rsend.size(), rrecv.dataPtr(),
+                                rcnt, rdisp, coordinatorProc);
+#else
+    const Vector<Long> &lrecv = lsend;
+    const Vector<Real> &rrecv = rsend;
+#endif
+    const std::vector<int> fileNumbers(ParallelDescriptor::Gather(myFileNumber, coordinatorProc));
+
+    if(iAmCoordinator) {
+      hdr.m_min.resize(mf.size());
+      hdr.m_max.resize(mf.size());
+      Vector<int> cnt(nProcs, 0);
+      for(int j(0), N(mf.size()); j < N; ++j) {
+        const int rank(pmap[j]);
+        const Long *lp = lrecv.dataPtr() + ldisp[rank] + cnt[rank]*(ncomp+1);
+        const Real *rp = rrecv.dataPtr() + rdisp[rank] + cnt[rank]*2*ncomp;
+        hdr.m_fod[j].m_name = VisMF::BaseName(NFilesIter::FileName(fileNumbers[rank], filePrefix));
+        hdr.m_fod[j].m_head = lp[0];
+        hdr.m_compsize[j].assign(lp+1, lp+1+ncomp);
+        hdr.m_min[j].assign(rp, rp+ncomp);
+        hdr.m_max[j].assign(rp+ncomp, rp+2*ncomp);
+        ++cnt[rank];
+      }
+    }
+
+    bytesWritten += VisMF::WriteHeader(mf_name, hdr, coordinatorProc);
 
     return bytesWritten;
 }
@@ -1389,11 +1902,179 @@ VisMF::VisMF (const std::string &fafab_name)
             m_pa[n][ii] = 0;
         }
     }
+
+    m_dataoffset.resize(m_hdr.m_ba.size(), -1);
 }
 
 
 VisMF::~VisMF ()
 {
+#ifndef _WIN32
+    for(auto const& m : m_mapped) {
+      if(m.second.first != nullptr) {
+        munmap(m.second.first, m.second.second);
+      }
+    }
+#endif
+}
+
+
+const char*
+VisMF::mappedData (int fabIndex) const
+{
+#ifdef _WIN32
+    amrex::ignore_unused(fabIndex);
+    return nullptr;
+#else
+    if(m_dataoffset[fabIndex] == -2) {
+      return nullptr;
+    }
+
+    std::string FullName(VisMF::DirName(m_fafabname));
+    FullName += m_hdr.m_fod[fabIndex].m_name;
+
+    auto it = m_mapped.find(FullName);
+    if(it == m_mapped.end()) {
+      std::pair<char*, Long> mapping(nullptr, 0);
+      int fd = open(FullName.c_str(), O_RDONLY);
+      if(fd >= 0) {
+        struct stat st;
+        if(fstat(fd, &st) == 0 && st.st_size > 0) {
+          void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+          if(p != MAP_FAILED) {
+            mapping = std::make_pair(static_cast<char*>(p), Long(st.st_size));
+          }
+        }
+        close(fd);
+      }
+      it = m_mapped.insert(std::make_pair(FullName, mapping)).first;
+    }
+    char *base = it->second.first;
+    const Long fileSize = it->second.second;
+    if(base == nullptr) {
+      m_dataoffset[fabIndex] = -2;
+      return nullptr;
+    }
+
+    if(m_dataoffset[fabIndex] == -1) {
+      Box fab_box(amrex::grow(m_hdr.m_ba[fabIndex], m_hdr.m_ngrow));
+      Long offset(m_hdr.m_fod[fabIndex].m_head);
+      bool native(false);
+      if(Compressed(m_hdr)) {
+        native = false;
+      } else if(Bricked(m_hdr)) {
+        native = true;
+      } else if(NoFabHeader(m_hdr)) {
+        native = (m_hdr.m_writtenRD == FPC::NativeRealDescriptor());
+      } else if(offset < fileSize) {
+        // ---- parse the fab header in place:  FAB rd box ncomp
+        const Long maxHeader(std::min(Long(4096), fileSize - offset));
+        const char *hbeg = base + offset;
+        const char *hend = static_cast<const char*>(std::memchr(hbeg, '\n', maxHeader));
+        if(hend != nullptr) {
+          std::istringstream is(std::string(hbeg, hend));
+          char f, a, b, c;
+          is >> f >> a >> b >> c;
+          if(f == 'F' && a == 'A' && b == 'B' && c != ':') {    // ---- not the old format
+            is.putback(c);
+            RealDescriptor rd;
+            Box bx;
+            int nvar(-1);
+            is >> rd >> bx >> nvar;
+            native = ! is.fail() && rd == FPC::NativeRealDescriptor()
+                     && bx == fab_box && nvar == m_hdr.m_ncomp;
+            offset += (hend - hbeg) + 1;
+          }
+        }
+      }
+      const Long nbytes(fab_box.numPts() * m_hdr.m_ncomp * sizeof(Real));
+      if(native && offset + nbytes <= fileSize) {
+        m_dataoffset[fabIndex] = offset;
+      } else {
+        m_dataoffset[fabIndex] = -2;
+        return nullptr;
+      }
+    }
+
+    return base + m_dataoffset[fabIndex];
+#endif
+}
+
+
+void
+VisMF::readRegion (int fabIndex, const Box& region, int scomp, int ncomp,
+                   FArrayBox& dest, int dcomp) const
+{
+    BL_PROFILE("VisMF::readRegion()");
+
+    const Box fab_box(amrex::grow(m_hdr.m_ba[fabIndex], m_hdr.m_ngrow));
+    BL_ASSERT(fab_box.contains(region) && dest.box().contains(region));
+    BL_ASSERT(scomp >= 0 && scomp + ncomp <= m_hdr.m_ncomp);
+    BL_ASSERT(dcomp >= 0 && dcomp + ncomp <= dest.nComp());
+
+    if(region.isEmpty() || ncomp <= 0) {
+      return;
+    }
+
+    const char *data = useMMap ? mappedData(fabIndex) : nullptr;
+
+    if(Bricked(m_hdr)) {
+      // ---- only the bricks that intersect region are read
+      const Long compBytes(fab_box.numPts() * sizeof(Real));
+      const Vector<Box> bricks = MakeBricks(fab_box, m_hdr.m_bricksize);
+      std::string FullName(VisMF::DirName(m_fafabname) + m_hdr.m_fod[fabIndex].m_name);
+      // ---- an unbuffered stream, so that a small brick does not read a whole io buffer
+      std::ifstream ifs;
+      if(data == nullptr) {
+        ifs.rdbuf()->pubsetbuf(nullptr, 0);
+        ifs.open(FullName.c_str(), std::ios::in | std::ios::binary);
+        if( ! ifs.good()) {
+          amrex::FileOpenFailed(FullName);
+        }
+      }
+      Vector<char> buf;
+      Long offset(0);
+      for(auto const& brick : bricks) {
+        const Box isect = brick & region;
+        const Long brickBytes(brick.numPts() * sizeof(Real));
+        if(isect.ok()) {
+          for(int n(0); n < ncomp; ++n) {
+            const Long pos(offset + (scomp+n) * compBytes);
+            const char *src;
+            if(data != nullptr) {
+              src = data + pos;
+            } else {
+              buf.resize(brickBytes);
+              ifs.seekg(m_hdr.m_fod[fabIndex].m_head + pos, std::ios::beg);
+              ifs.read(buf.data(), brickBytes);
+              if(ifs.gcount() != brickBytes) {
+                amrex::Error("VisMF::readRegion:  read failed");
+              }
+              src = buf.data();
+            }
+            copy_runs(src, brick, reinterpret_cast<char*>(dest.dataPtr(dcomp+n)),
+                      dest.box(), isect);
+          }
+        }
+        offset += brickBytes;
+      }
+      return;
+    }
+
+    if(data == nullptr) {
+      for(int n(0); n < ncomp; ++n) {
+        std::unique_ptr<FArrayBox> fab(readFAB(fabIndex, m_fafabname, m_hdr, scomp+n));
+        dest.copy<RunOn::Host>(*fab, region, 0, region, dcomp+n, 1);
+      }
+      return;
+    }
+
+    // ---- copy contiguous runs in x so that only the pages holding region are touched
+    const Long compBytes(fab_box.numPts() * sizeof(Real));
+    for(int n(0); n < ncomp; ++n) {
+      copy_runs(data + (scomp+n) * compBytes, fab_box,
+                reinterpret_cast<char*>(dest.dataPtr(dcomp+n)), dest.box(), region);
+    }
 }
 
 
@@ -1417,7 +2098,23 @@ VisMF::readFAB (int                  idx,
     std::ifstream *infs = VisMF::OpenStream(FullName);
     infs->seekg(hdr.m_fod[idx].m_head, std::ios::beg);
 
-    if(hdr.m_vers == Header::Version_v1) {
+    if(Compressed(hdr)) {
+      if(whichComp == -1) {    // ---- read all components
+        ReadCompressed(*infs, hdr, idx, *fab, 0, 0, hdr.m_ncomp);
+      } else {
+        ReadCompressed(*infs, hdr, idx, *fab, whichComp, 0, 1);
+      }
+    } else if(Bricked(hdr)) {
+      Vector<char> buf(fab->nBytes());
+      if(whichComp != -1) {
+        infs->seekg(fab->nBytes() * whichComp, std::ios::cur);
+      }
+      infs->read(buf.data(), buf.size());
+      if(infs->gcount() != static_cast<std::streamsize>(buf.size())) {
+        amrex::Error("VisMF::readFAB:  read failed");
+      }
+      UnBrickFab(buf.data(), hdr.m_bricksize, *fab, 0, fab->nComp());
+    } else if(hdr.m_vers == Header::Version_v1) {
       if(whichComp == -1) {    // ---- read all components
         fab->readFrom(*infs);
       } else {
@@ -1467,7 +2164,16 @@ VisMF::readFAB (FabArray<FArrayBox> &mf,
     std::ifstream *infs = VisMF::OpenStream(FullName);
     infs->seekg(hdr.m_fod[idx].m_head, std::ios::beg);
 
-    if(NoFabHeader(hdr)) {
+    if(Compressed(hdr)) {
+      ReadCompressed(*infs, hdr, idx, fab, 0, 0, hdr.m_ncomp);
+    } else if(Bricked(hdr)) {
+      Vector<char> buf(fab.nBytes());
+      infs->read(buf.data(), buf.size());
+      if(infs->gcount() != static_cast<std::streamsize>(buf.size())) {
+        amrex::Error("VisMF::readFAB:  read failed");
+      }
+      UnBrickFab(buf.data(), hdr.m_bricksize, fab, 0, fab.nComp());
+    } else if(NoFabHeader(hdr)) {
       if(hdr.m_writtenRD == FPC::NativeRealDescriptor()) {
         infs->read((char *) fab.dataPtr(), fab.nBytes());
       } else {
@@ -2093,6 +2799,16 @@ VisMF::clear ()
 }
 
 
+bool VisMF::Compressed(const VisMF::Header &hdr) {
+  return hdr.m_vers == VisMF::Header::Compressed_v1;
+}
+
+
+bool VisMF::Bricked(const VisMF::Header &hdr) {
+  return hdr.m_vers == VisMF::Header::Bricked_v1;
+}
+
+
 bool VisMF::NoFabHeader(const VisMF::Header &hdr) {
   if(hdr.m_vers == VisMF::Header::NoFabHeader_v1       ||
     hdr.m_vers == VisMF::Header::NoFabHeaderMinMax_v1 ||
@@ -2209,9 +2925,22 @@ VisMF::AsyncWrite (FabArray<FArrayBox>&& mf, const std::string& mf_name, bool va
     }
 }
 
+void
+VisMF::AsyncWrite (const std::shared_ptr<FabArraySnapshot<FArrayBox> >& snapshot,
+                   const std::string& mf_name, bool valid_cells_only)
+{
+    if (AsyncOut::UseAsyncOut()) {
+        AsyncWriteDoit(snapshot->fabArray(), mf_name, false, valid_cells_only, snapshot);
+    } else {
+        AsyncWrite(snapshot->fabArray(), mf_name, valid_cells_only);
+        snapshot->finish();
+    }
+}
+
 void
 VisMF::AsyncWriteDoit (const FabArray<FArrayBox>& mf, const std::string& mf_name,
-                       bool is_rvalue, bool valid_cells_only)
+                       bool is_rvalue, bool valid_cells_only,
+                       const std::shared_ptr<FabArraySnapshot<FArrayBox> >& snapshot)
 {
     BL_PROFILE("VisMF::AsyncWrite()");
 
@@ -2227,7 +2956,22 @@ VisMF::AsyncWriteDoit (const FabArray<FArrayBox>& mf, const std::string& mf_name
 
     RealDescriptor const& whichRD = FPC::NativeRealDescriptor();
 
-    auto hdr = std::make_shared<VisMF::Header>(mf, VisMF::NFiles, VisMF::Header::Version_v1, false);
+    // ---- Compression runs in the job, which then gathers the compressed
+    // ---- sizes for the header on AsyncOut::JobCommunicator().  With more
+    // ---- than one process and without MPI_THREAD_MULTIPLE there is no such
+    // ---- communicator, and the data are compressed here instead.
+    const bool compress = UseCompression();
+    const bool compress_in_job = compress and
+        (nprocs == 1 or AsyncOut::JobCommunicator() != MPI_COMM_NULL);
+    const bool bricked = not compress and currentVersion == VisMF::Header::Bricked_v1;
+    const IntVect bricksize = brickSize;
+
+    auto hdr = std::make_shared<VisMF::Header>(mf, VisMF::NFiles,
+                                               compress ? VisMF::Header::Compressed_v1
+                                             : (bricked ? VisMF::Header::Bricked_v1
+                                                        : VisMF::Header::Version_v1), false);
+    if (compress) SetHeaderCompression(*hdr);
+    if (bricked) hdr->m_bricksize = bricksize;
 
     constexpr int sizeof_int64_over_real = sizeof(int64_t) / sizeof(Real);
     const int n_local_fabs = mf.local_size();
@@ -2245,6 +2989,15 @@ VisMF::AsyncWriteDoit (const FabArray<FArrayBox>& mf, const std::string& mf_name
     bool run_on_device = Gpu::inLaunchRegion() and data_on_device;
 
     bool strip_ghost = valid_cells_only and mf.nGrowVect() != 0;
+    if (strip_ghost) hdr->m_ngrow = IntVect(0);
+    const IntVect ngrow = mf.nGrowVect();
+
+    // ---- The background thread can only read the snapshot if the data are
+    // ---- on the host and are still to be written or compressed.
+    bool use_snapshot = snapshot and (compress_in_job or not compress);
+#ifdef AMREX_USE_GPU
+    use_snapshot = use_snapshot and not data_on_device;
+#endif
 
     int64_t total_bytes = 0;
     auto pld = (char*)(&(localdata[1]));
@@ -2257,12 +3010,16 @@ VisMF::AsyncWriteDoit (const FabArray<FArrayBox>& mf, const std::string& mf_name
         const FArrayBox& fab = mf[mfi];
         const Box& bx = mfi.validbox();
 
-        std::stringstream hss;
-        FArrayBox valid_fab(bx, ncomp, false);
-        FArrayBox const& header_fab = (strip_ghost) ? valid_fab : fab;
-        fio.write_header(hss, header_fab, ncomp);
-        total_bytes += static_cast<std::streamoff>(hss.tellp());
-        total_bytes += header_fab.size() * whichRD.numBytes();
+        if (bricked) {
+            total_bytes += (strip_ghost ? bx : mfi.fabbox()).numPts() * ncomp * sizeof(Real);
+        } else if (not compress) {  // ---- compressed sizes are known after the compression
+            std::stringstream hss;
+            FArrayBox valid_fab(bx, ncomp, false);
+            FArrayBox const& header_fab = (strip_ghost) ? valid_fab : fab;
+            fio.write_header(hss, header_fab, ncomp);
+            total_bytes += static_cast<std::streamoff>(hss.tellp());
+            total_bytes += header_fab.size() * whichRD.numBytes();
+        }
 
         // compute min and max
         Real cmin, cmax;
@@ -2283,6 +3040,16 @@ VisMF::AsyncWriteDoit (const FabArray<FArrayBox>& mf, const std::string& mf_name
     }
     localdata[0] = total_bytes;
 
+    // ---- With staging, each process drains its data to its own part of the
+    // ---- file, so it needs the numbers of bytes of the processes before it.
+    // ---- Those of compressed data are gathered after the compression.
+    const bool staging = AsyncOut::UseStaging();
+    auto rank_bytes = std::make_shared<Vector<int64_t> >(nprocs, total_bytes);
+    if (staging and not compress and nprocs > 1) {
+        ParallelAllGather::AllGather(total_bytes, rank_bytes->data(),
+                                     ParallelDescriptor::Communicator());
+    }
+
     auto globaldata = std::make_shared<Vector<int64_t> >();
     if (nprocs == 1) {
         *globaldata = std::move(localdata);
@@ -2312,7 +3079,7 @@ VisMF::AsyncWriteDoit (const FabArray<FArrayBox>& mf, const std::string& mf_name
 #endif
 
     auto myfabs = std::make_shared<Vector<FArrayBox> >();
-    for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
+    for (MFIter mfi(mf); mfi.isValid() and not use_snapshot; ++mfi) {
         Box bx = strip_ghost ? mfi.validbox() : mfi.fabbox();
 #ifdef AMREX_USE_GPU
         if (data_on_device) {
@@ -2336,10 +3103,85 @@ VisMF::AsyncWriteDoit (const FabArray<FArrayBox>& mf, const std::string& mf_name
         }
     }
 
+    if (snapshot and not use_snapshot) snapshot->finish();  // ---- copied above
+
+    // ---- Compress the local fabs into compressed, then gather the number of
+    // ---- bytes of each process to all of them, and the compressed sizes of
+    // ---- the components of all the fabs, process by process, to io_proc.
+    auto compressed = std::make_shared<Vector<char> >();
+    auto compsizes = std::make_shared<Vector<int64_t> >();
+    auto compress_data = [=] (MPI_Comm comm)
+    {
+        Vector<int64_t> mysizes(n_local_fabs*ncomp);
+        Vector<Long> compsize(ncomp);
+        auto compress_fab = [&] (const FArrayBox& fab, int li)
+        {
+            CompressFab(fab, *hdr, *compressed, compsize.data());
+            std::copy(compsize.begin(), compsize.end(), mysizes.begin() + li*ncomp);
+        };
+        if (use_snapshot) {
+            for (int li = 0; li < n_local_fabs; ++li) {
+                const FArrayBox& fab = snapshot->acquire(li);
+                if (strip_ghost) {
+                    FArrayBox valid_fab(amrex::grow(fab.box(),-ngrow), ncomp, The_Cpu_Arena());
+                    valid_fab.copy<RunOn::Host>(fab, valid_fab.box());
+                    snapshot->release(li);
+                    compress_fab(valid_fab, li);
+                } else {
+                    compress_fab(fab, li);
+                    snapshot->release(li);
+                }
+            }
+        } else {
+            for (int li = 0; li < n_local_fabs; ++li) {
+                compress_fab((*myfabs)[li], li);
+            }
+            myfabs->clear();  // ---- only the compressed data are written
+        }
+
+        const int64_t mybytes = compressed->size();
+        if (nprocs == 1) {
+            (*rank_bytes)[0] = mybytes;
+            *compsizes = std::move(mysizes);
+        }
+#ifdef BL_USE_MPI
+        else {
+            ParallelAllGather::AllGather(mybytes, rank_bytes->data(), comm);
+            Vector<int> rcnt, rdsp;
+            if (myproc == io_proc) {
+                compsizes->resize(n_global_fabs*ncomp);
+                rcnt.resize(nprocs,0);
+                rdsp.resize(nprocs,0);
+                for (int k = 0; k < n_global_fabs; ++k) {
+                    rcnt[dm[k]] += ncomp;
+                }
+                std::partial_sum(rcnt.begin(), rcnt.end()-1, rdsp.begin()+1);
+            } else {
+                compsizes->resize(1,0);
+                rcnt.resize(1,0);
+                rdsp.resize(1,0);
+            }
+            BL_MPI_REQUIRE(MPI_Gatherv(mysizes.data(), mysizes.size(), MPI_INT64_T,
+                                       compsizes->data(), rcnt.data(), rdsp.data(), MPI_INT64_T,
+                                       io_proc, comm));
+        }
+#else
+        amrex::ignore_unused(comm);
+#endif
+    };
+
+    if (compress and not compress_in_job) {
+        compress_data(ParallelDescriptor::Communicator());
+    }
+
     std::shared_ptr<FABio> fabio(new FABio_binary(FPC::NativeRealDescriptor().clone()));
 
     AsyncOut::Submit([=] ()
     {
+        if (compress_in_job) {
+            compress_data(AsyncOut::JobCommunicator());
+        }
+
         if (myproc == io_proc)
         {
             hdr->m_fod.resize(n_global_fabs);
@@ -2351,6 +3193,7 @@ VisMF::AsyncWriteDoit (const FabArray<FArrayBox>& mf, const std::string& mf_name
             hdr->m_famax.resize(ncomp,std::numeric_limits<Real>::lowest());
 
             Vector<int64_t> nbytes_on_rank(nprocs,-1L);
+            Vector<int64_t> next_head(nprocs,0);
             Vector<Vector<int> > gidx(nprocs);
             for (int k = 0; k < n_global_fabs; ++k) {
                 int rank = dm[k];
@@ -2385,6 +3228,16 @@ VisMF::AsyncWriteDoit (const FabArray<FArrayBox>& mf, const std::string& mf_name
                     std::memcpy(&nbytes, pgd, sizeof(int64_t));
                     pgd += sizeof(int64_t);
 
+                    if (compress) {
+                        // ---- the fabs of a process follow each other
+                        nbytes = next_head[rank];
+                        hdr->m_compsize[k].assign(compsizes->begin() +  j   *ncomp,
+                                                  compsizes->begin() + (j+1)*ncomp);
+                        next_head[rank] += std::accumulate(compsizes->begin() +  j   *ncomp,
+                                                           compsizes->begin() + (j+1)*ncomp,
+                                                           int64_t(0));
+                    }
+
                     for (int icomp = 0; icomp < ncomp; ++icomp) {
                         Real cmin, cmax;
                         std::memcpy(&cmin, pgd             , sizeof(Real));
@@ -2403,6 +3256,8 @@ VisMF::AsyncWriteDoit (const FabArray<FArrayBox>& mf, const std::string& mf_name
                 }
             }
 
+            if (compress) nbytes_on_rank = *rank_bytes;
+
             Vector<int64_t> offset(nprocs);
             for (int ip = 0; ip < nprocs; ++ip) {
                 auto info = AsyncOut::GetWriteInfo(ip);
@@ -2422,19 +3277,79 @@ VisMF::AsyncWriteDoit (const FabArray<FArrayBox>& mf, const std::string& mf_name
 
         VisMF::IO_Buffer io_buffer(ioBufferSize);
 
-        AsyncOut::Wait();  // Wait for my turn
+        auto write_fab = [&] (std::ostream& ofs, const FArrayBox& fab)
+        {
+            if (bricked) {
+                Vector<char> bricks(fab.nBytes());
+                VisMF::BrickFab(fab, bricksize, bricks.dataPtr());
+                ofs.write(bricks.dataPtr(), bricks.size());
+            } else {
+                fabio->write_header(ofs, fab, fab.nComp());
+                fabio->write(ofs, fab, 0, fab.nComp());
+            }
+        };
+
+        auto write_data = [&] (std::ostream& ofs)
+        {
+            if (compress) {
+                ofs.write(compressed->dataPtr(), compressed->size());
+                return;
+            }
+            if (use_snapshot) {
+                for (int li = 0; li < n_local_fabs; ++li) {
+                    const FArrayBox& fab = snapshot->acquire(li);
+                    if (strip_ghost) {
+                        FArrayBox valid_fab(amrex::grow(fab.box(),-ngrow), ncomp, The_Cpu_Arena());
+                        valid_fab.copy<RunOn::Host>(fab, valid_fab.box());
+                        snapshot->release(li);
+                        write_fab(ofs, valid_fab);
+                    } else {
+                        write_fab(ofs, fab);
+                        snapshot->release(li);
+                    }
+                }
+            }
+            for (auto const& fab : *myfabs) {
+                write_fab(ofs, fab);
+            }
+        };
 
         auto info = AsyncOut::GetWriteInfo(myproc);
         std::string file_name = amrex::Concatenate(mf_name + FabFileSuffix, info.ifile, 5);
+
+        if (staging)
+        {
+            const int first = myproc - info.ispot;
+            const int64_t stage_offset = std::accumulate(rank_bytes->begin() + first,
+                                                         rank_bytes->begin() + myproc,
+                                                         int64_t(0));
+            int64_t stage_file_size = -1;
+            if (info.ispot == 0) {  // ---- sets the size of the file
+                stage_file_size = std::accumulate(rank_bytes->begin() + first,
+                                                  rank_bytes->begin() + first + info.nspots,
+                                                  int64_t(0));
+            }
+            std::string stage_name = AsyncOut::StageFileName();
+            std::ofstream ofs;
+            ofs.rdbuf()->pubsetbuf(io_buffer.dataPtr(), io_buffer.size());
+            ofs.open(stage_name.c_str(), std::ios::binary | std::ios::trunc);
+            if (!ofs.good()) amrex::FileOpenFailed(stage_name);
+            write_data(ofs);
+            ofs.close();
+            if (!ofs.good()) amrex::Abort("VisMF::AsyncWrite: failed to write " + stage_name);
+            myfabs->clear();  // ---- the data are on the stage now
+            AsyncOut::Drain(stage_name, file_name, stage_offset, stage_file_size);
+            return;
+        }
+
+        AsyncOut::Wait();  // Wait for my turn
+
         std::ofstream ofs;
         ofs.rdbuf()->pubsetbuf(io_buffer.dataPtr(), io_buffer.size());
         ofs.open(file_name.c_str(), (info.ispot == 0) ? (std::ios::binary | std::ios::trunc)
                                                       : (std::ios::binary | std::ios::app));
         if (!ofs.good()) amrex::FileOpenFailed(file_name);
-        for (auto const& fab : *myfabs) {
-            fabio->write_header(ofs, fab, fab.nComp());
-            fabio->write(ofs, fab, 0, fab.nComp());
-        }
+        write_data(ofs);
         ofs.flush();
         ofs.close();
 
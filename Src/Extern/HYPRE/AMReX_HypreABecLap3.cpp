@@ -45,6 +45,7 @@ HypreABecLap3::solve (MultiFab& soln, const MultiFab& rhs, Real rel_tol, Real ab
 
     if (solver == NULL || m_bndry != &bndry || m_maxorder != max_bndry_order)
     {
+        BL_PROFILE_REGION("MLMG::setup");
         m_bndry = &bndry;
         m_maxorder = max_bndry_order;
         m_factory = &(rhs.Factory());
@@ -53,6 +54,14 @@ HypreABecLap3::solve (MultiFab& soln, const MultiFab& rhs, Real rel_tol, Real ab
     else
     {
         m_factory = &(rhs.Factory());
+        if (m_coeffs_changed)
+        {
+            BL_PROFILE_REGION("MLMG::setup");
+            HYPRE_IJMatrixInitialize(A);
+            fillMatrix();
+            HYPRE_BoomerAMGDestroy(solver);
+            setupAMG();
+        }
     }
     
     HYPRE_IJVectorInitialize(b);
@@ -190,13 +199,6 @@ HypreABecLap3::prepareSolver ()
 #ifdef AMREX_USE_EB
     auto ebfactory = dynamic_cast<EBFArrayBoxFactory const*>(m_factory);
     const FabArray<EBCellFlagFab>* flags = (ebfactory) ? &(ebfactory->getMultiEBCellFlagFab()) : nullptr;
-    const MultiFab* vfrac = (ebfactory) ? &(ebfactory->getVolFrac()) : nullptr;
-    auto area = (ebfactory) ? ebfactory->getAreaFrac()
-        : Array<const MultiCutFab*,AMREX_SPACEDIM>{AMREX_D_DECL(nullptr,nullptr,nullptr)};
-    auto fcent = (ebfactory) ? ebfactory->getFaceCent()
-        : Array<const MultiCutFab*,AMREX_SPACEDIM>{AMREX_D_DECL(nullptr,nullptr,nullptr)};
-    auto barea = (ebfactory) ? &(ebfactory->getBndryArea()) : nullptr;
-    auto bcent = (ebfactory) ? &(ebfactory->getBndryCent()) : nullptr;
 #endif
 
     HYPRE_Int ncells_proc = 0;
@@ -248,19 +250,16 @@ HypreABecLap3::prepareSolver ()
     for (int i = 0; i < myid; ++i) {
         proc_begin += ncells_allprocs[i];
     }
-
-#ifdef AMREX_DEBUG
-    HYPRE_Int ncells_total = 0;
+    ncells_total = 0;
     for (auto n : ncells_allprocs) {
         ncells_total += n;
     }
-#endif
 
-    LayoutData<HYPRE_Int> offset(ba,dm);
+    cell_offset.define(ba,dm);
     HYPRE_Int proc_end = proc_begin;
     for (MFIter mfi(ncells_grid); mfi.isValid(); ++mfi)
     {
-        offset[mfi] = proc_end;
+        cell_offset[mfi] = proc_end;
         proc_end += ncells_grid[mfi];
     }
     AMREX_ALWAYS_ASSERT_WITH_MESSAGE(proc_end == proc_begin+ncells_proc,
@@ -271,7 +270,7 @@ HypreABecLap3::prepareSolver ()
 #endif
     for (MFIter mfi(cell_id,true); mfi.isValid(); ++mfi)
     {
-        cell_id[mfi].plus<RunOn::Host>(offset[mfi], mfi.tilebox());
+        cell_id[mfi].plus<RunOn::Host>(cell_offset[mfi], mfi.tilebox());
     }    
 
     cell_id.FillBoundary(geom.periodicity());
@@ -291,6 +290,27 @@ HypreABecLap3::prepareSolver ()
     HYPRE_IJVectorCreate(comm, ilower, iupper, &x);
     HYPRE_IJVectorSetObjectType(x, HYPRE_PARCSR);
     
+    fillMatrix();
+    setupAMG();
+}
+
+void
+HypreABecLap3::fillMatrix ()
+{
+    BL_PROFILE("HypreABecLap3::fillMatrix()");
+
+#ifdef AMREX_USE_EB
+    auto ebfactory = dynamic_cast<EBFArrayBoxFactory const*>(m_factory);
+    const FabArray<EBCellFlagFab>* flags = (ebfactory) ? &(ebfactory->getMultiEBCellFlagFab()) : nullptr;
+    const MultiFab* vfrac = (ebfactory) ? &(ebfactory->getVolFrac()) : nullptr;
+    auto area = (ebfactory) ? ebfactory->getAreaFrac()
+        : Array<const MultiCutFab*,AMREX_SPACEDIM>{AMREX_D_DECL(nullptr,nullptr,nullptr)};
+    auto fcent = (ebfactory) ? ebfactory->getFaceCent()
+        : Array<const MultiCutFab*,AMREX_SPACEDIM>{AMREX_D_DECL(nullptr,nullptr,nullptr)};
+    auto barea = (ebfactory) ? &(ebfactory->getBndryArea()) : nullptr;
+    auto bcent = (ebfactory) ? &(ebfactory->getBndryCent()) : nullptr;
+#endif
+
     // A.SetValues() & A.assemble()
 
     const Real* dx = geom.CellSize();
@@ -334,7 +354,7 @@ HypreABecLap3::prepareSolver ()
                                  cell_id_vec[mfi].dataPtr(), 
                                  colsg.dataPtr(), matg.dataPtr(),
                                  cell_id[mfi], 
-                                 offset[mfi],
+                                 cell_offset[mfi],
                                  diaginv[mfi],
                                  acoefs[mfi],
                                  bcoefs[0][mfi],
@@ -358,7 +378,7 @@ HypreABecLap3::prepareSolver ()
                                     cell_id_vec[mfi].dataPtr(),
                                     colsg.dataPtr(), matg.dataPtr(),
                                     cell_id[mfi],
-                                    offset[mfi], diaginv[mfi],
+                                    cell_offset[mfi], diaginv[mfi],
                                     acoefs[mfi], bcoefs[0][mfi],
                                     bcoefs[1][mfi], 
 #if (AMREX_SPACEDIM == 3)
@@ -403,7 +423,14 @@ HypreABecLap3::prepareSolver ()
     }
     HYPRE_IJMatrixAssemble(A);
 
-    // Create solver
+    m_coeffs_changed = false;
+}
+
+void
+HypreABecLap3::setupAMG ()
+{
+    BL_PROFILE("HypreABecLap3::setupAMG()");
+
     HYPRE_BoomerAMGCreate(&solver);
 
     if (old_default) HYPRE_BoomerAMGSetOldDefault(solver); // Falgout coarsening with modified classical interpolation
@@ -10,9 +10,10 @@ MLABecLaplacian::MLABecLaplacian (const Vector<Geometry>& a_geom,
                                   const Vector<BoxArray>& a_grids,
                                   const Vector<DistributionMapping>& a_dmap,
                                   const LPInfo& a_info,
-                                  const Vector<FabFactory<FArrayBox> const*>& a_factory)
+                                  const Vector<FabFactory<FArrayBox> const*>& a_factory,
+                                  const int a_ncomp)
 {
-    define(a_geom, a_grids, a_dmap, a_info, a_factory);
+    define(a_geom, a_grids, a_dmap, a_info, a_factory, a_ncomp);
 }
 
 MLABecLaplacian::MLABecLaplacian (const Vector<Geometry>& a_geom,
@@ -30,10 +31,13 @@ MLABecLaplacian::define (const Vector<Geometry>& a_geom,
                          const Vector<BoxArray>& a_grids,
                          const Vector<DistributionMapping>& a_dmap,
                          const LPInfo& a_info,
-                         const Vector<FabFactory<FArrayBox> const*>& a_factory)
+                         const Vector<FabFactory<FArrayBox> const*>& a_factory,
+                         const int a_ncomp)
 {
     BL_PROFILE("MLABecLaplacian::define()");
 
+    m_ncomp = a_ncomp;
+
     MLCellABecLap::define(a_geom, a_grids, a_dmap, a_info, a_factory);
 
     const int ncomp = getNComp();
@@ -51,14 +55,25 @@ MLABecLaplacian::define (const Vector<Geometry>& a_geom,
             m_a_coeffs[amrlev][mglev].define(m_grids[amrlev][mglev],
                                              m_dmap[amrlev][mglev],
                                              1, 0, MFInfo(), *m_factory[amrlev][mglev]);
-            for (int idim = 0; idim < AMREX_SPACEDIM; ++idim)
-            {
-                const BoxArray& ba = amrex::convert(m_grids[amrlev][mglev],
-                                                    IntVect::TheDimensionVector(idim));
-                m_b_coeffs[amrlev][mglev][idim].define(ba,
-                                                       m_dmap[amrlev][mglev],
-                                                       ncomp, 0, MFInfo(), *m_factory[amrlev][mglev]);
-            }
+        }
+        defineBCoeffs(amrlev, ncomp);
+    }
+}
+
+void
+MLABecLaplacian::defineBCoeffs (int amrlev, int nbcomp)
+{
+    if (m_b_coeffs[amrlev][0][0].nComp() == nbcomp) return;
+
+    for (int mglev = 0; mglev < m_num_mg_levels[amrlev]; ++mglev)
+    {
+        for (int idim = 0; idim < AMREX_SPACEDIM; ++idim)
+        {
+            const BoxArray& ba = amrex::convert(m_grids[amrlev][mglev],
+                                                IntVect::TheDimensionVector(idim));
+            m_b_coeffs[amrlev][mglev][idim].define(ba,
+                                                   m_dmap[amrlev][mglev],
+                                                   nbcomp, 0, MFInfo(), *m_factory[amrlev][mglev]);
         }
     }
 }
@@ -185,25 +200,20 @@ MLABecLaplacian::setBCoeffs (int amrlev,
                              const Array<MultiFab const*,AMREX_SPACEDIM>& beta)
 {
     const int ncomp = getNComp();
-    AMREX_ALWAYS_ASSERT(beta[0]->nComp() == 1 or beta[0]->nComp() == ncomp);
-    if (beta[0]->nComp() == ncomp)
-        for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
-            for (int icomp = 0; icomp < ncomp; ++icomp) {
-                MultiFab::Copy(m_b_coeffs[amrlev][0][idim], *beta[idim], icomp, icomp, 1, 0);
-            }
-        }
-    else 
-        for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
-            for (int icomp = 0; icomp < ncomp; ++icomp) {
-                MultiFab::Copy(m_b_coeffs[amrlev][0][idim], *beta[idim], 0, icomp, 1, 0);
-            }
-        }
+    const int nbcomp = beta[0]->nComp();
+    AMREX_ALWAYS_ASSERT(nbcomp == 1 or nbcomp == ncomp);
+    // A b with one component is used by all the components of the solution.
+    defineBCoeffs(amrlev, nbcomp);
+    for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+        MultiFab::Copy(m_b_coeffs[amrlev][0][idim], *beta[idim], 0, 0, nbcomp, 0);
+    }
     m_needs_update = true;
 }
 
 void
 MLABecLaplacian::setBCoeffs (int amrlev, Real beta)
 {
+    defineBCoeffs(amrlev, 1);
     for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
         m_b_coeffs[amrlev][0][idim].setVal(beta);
     }
@@ -214,9 +224,10 @@ void
 MLABecLaplacian::setBCoeffs (int amrlev, Vector<Real> const& beta)
 {
     const int ncomp = getNComp();
+    defineBCoeffs(amrlev, ncomp);
     for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
         for (int icomp = 0; icomp < ncomp; ++icomp) {
-            m_b_coeffs[amrlev][0][idim].setVal(beta[icomp]);
+            m_b_coeffs[amrlev][0][idim].setVal(beta[icomp], icomp, 1);
         }
     }
     m_needs_update = true;
@@ -272,7 +283,7 @@ MLABecLaplacian::averageDownCoeffsSameAmrLevel (int amrlev, Vector<MultiFab>& a,
         if (m_overset_mask[amrlev][mglev]) {
             const Real fac = static_cast<Real>(1 << mglev); // 2**mglev
             const Real osfac = 2.0*fac/(fac+1.0);
-            const int ncomp = getNComp();
+            const int nbcomp = b[mglev][0].nComp();
 #ifdef _OPENMP
 #pragma omp parallel if (Gpu::notInLaunchRegion())
 #endif
@@ -288,15 +299,15 @@ MLABecLaplacian::averageDownCoeffsSameAmrLevel (int amrlev, Vector<MultiFab>& a,
                 AMREX_LAUNCH_HOST_DEVICE_LAMBDA_DIM
                     (xbx, t_xbx,
                      {
-                         overset_rescale_bcoef_x(t_xbx, bx, osm, ncomp, osfac);
+                         overset_rescale_bcoef_x(t_xbx, bx, osm, nbcomp, osfac);
                      },
                      ybx, t_ybx,
                      {
-                         overset_rescale_bcoef_y(t_ybx, by, osm, ncomp, osfac);
+                         overset_rescale_bcoef_y(t_ybx, by, osm, nbcomp, osfac);
                      },
                      zbx, t_zbx,
                      {
-                         overset_rescale_bcoef_z(t_zbx, bz, osm, ncomp, osfac);
+                         overset_rescale_bcoef_z(t_zbx, bz, osm, nbcomp, osfac);
                      });
             }
         }
@@ -310,6 +321,8 @@ MLABecLaplacian::averageDownCoeffsToCoarseAmrLevel (int flev)
     auto& fine_b_coeffs = m_b_coeffs[flev  ].back();
     auto& crse_a_coeffs = m_a_coeffs[flev-1].front();
     auto& crse_b_coeffs = m_b_coeffs[flev-1].front();
+    AMREX_ALWAYS_ASSERT_WITH_MESSAGE(fine_b_coeffs[0].nComp() == crse_b_coeffs[0].nComp(),
+                                     "MLABecLaplacian: b must have the same number of components on all AMR levels");
 
     if (m_a_scalar != 0.0) {
         // We coarsen from the back of flev to the front of flev-1.
@@ -464,6 +477,13 @@ MLABecLaplacian::normalize (int amrlev, int mglev, MultiFab& mf) const
 
 void
 MLABecLaplacian::Fsmooth (int amrlev, int mglev, MultiFab& sol, const MultiFab& rhs, int redblack) const
+{
+    Fsmooth(amrlev, mglev, sol, rhs, redblack, 0, getNComp());
+}
+
+void
+MLABecLaplacian::Fsmooth (int amrlev, int mglev, MultiFab& sol, const MultiFab& rhs, int redblack,
+                          int scomp, int ncomp) const
 {
     BL_PROFILE("MLABecLaplacian::Fsmooth()");
 
@@ -503,7 +523,7 @@ MLABecLaplacian::Fsmooth (int amrlev, int mglev, MultiFab& sol, const MultiFab&
 #endif
 #endif
 
-    const int nc = getNComp();
+    const int nc = ncomp;
     const Real* h = m_geom[amrlev][mglev].CellSize();
     AMREX_D_TERM(const Real dhx = m_b_scalar/(h[0]*h[0]);,
                  const Real dhy = m_b_scalar/(h[1]*h[1]);,
@@ -531,22 +551,27 @@ MLABecLaplacian::Fsmooth (int amrlev, int mglev, MultiFab& sol, const MultiFab&
 
 	const Box& tbx = mfi.tilebox();
         const Box& vbx = mfi.validbox();
-        const auto& solnfab = sol.array(mfi);
-        const auto& rhsfab  = rhs.array(mfi);
+        // ---- The arrays start at component scomp.  A b with one component
+        // ---- is shared by all of them.
+        const Array4<Real> solnfab(sol.array(mfi), scomp);
+        const Array4<Real const> rhsfab(rhs.const_array(mfi), scomp);
         const auto& afab    = acoef.array(mfi);
 
-        AMREX_D_TERM(const auto& bxfab = bxcoef.array(mfi);,
-                     const auto& byfab = bycoef.array(mfi);,
-                     const auto& bzfab = bzcoef.array(mfi););
+        auto bcomp = [scomp] (Array4<Real const> const& b) {
+            return (b.nComp() == 1) ? b : Array4<Real const>(b, scomp);
+        };
+        AMREX_D_TERM(const auto& bxfab = bcomp(bxcoef.const_array(mfi));,
+                     const auto& byfab = bcomp(bycoef.const_array(mfi));,
+                     const auto& bzfab = bcomp(bzcoef.const_array(mfi)););
 
-        const auto& f0fab = f0.array(mfi);
-        const auto& f1fab = f1.array(mfi);
+        const Array4<Real const> f0fab(f0.array(mfi), scomp);
+        const Array4<Real const> f1fab(f1.array(mfi), scomp);
 #if (AMREX_SPACEDIM > 1)
-        const auto& f2fab = f2.array(mfi);
-        const auto& f3fab = f3.array(mfi);
+        const Array4<Real const> f2fab(f2.array(mfi), scomp);
+        const Array4<Real const> f3fab(f3.array(mfi), scomp);
 #if (AMREX_SPACEDIM > 2)
-        const auto& f4fab = f4.array(mfi);
-        const auto& f5fab = f5.array(mfi);
+        const Array4<Real const> f4fab(f4.array(mfi), scomp);
+        const Array4<Real const> f5fab(f5.array(mfi), scomp);
 #endif
 #endif
 
@@ -651,6 +676,71 @@ MLABecLaplacian::Fsmooth (int amrlev, int mglev, MultiFab& sol, const MultiFab&
     }
 }
 
+void
+MLABecLaplacian::smooth (int amrlev, int mglev, MultiFab& sol, const MultiFab& rhs,
+                         bool skip_fillboundary) const
+{
+    const int ncomp = getNComp();
+    const int nblock = smoothCompBlock(amrlev, mglev);
+    const bool all_active = m_active_comps.empty()
+        || std::all_of(m_active_comps.begin(), m_active_comps.end(), [] (int a) { return a != 0; });
+    if (nblock >= ncomp && all_active) {
+        MLCellLinOp::smooth(amrlev, mglev, sol, rhs, skip_fillboundary);
+        return;
+    }
+
+    BL_PROFILE("MLABecLaplacian::smooth()");
+
+    // ---- The red and black passes over all the components would not stay
+    // ---- in cache, so they are done on one group of components at a time.
+    // ---- A group is a run of at most nblock active components.  It does not
+    // ---- touch the ghost cells of the others, so a skipped FillBoundary
+    // ---- holds for the first pass of every group.
+    auto active = [&] (int n) { return all_active || m_active_comps[n] != 0; };
+    int scomp = 0;
+    while (scomp < ncomp)
+    {
+        if (!active(scomp)) {
+            ++scomp;
+            continue;
+        }
+        int nc = 1;
+        while (nc < nblock && scomp+nc < ncomp && active(scomp+nc)) ++nc;
+
+        bool skip = skip_fillboundary;
+        for (int redblack = 0; redblack < 2; ++redblack)
+        {
+            applyBC(amrlev, mglev, sol, BCMode::Homogeneous, StateMode::Solution,
+                    nullptr, skip, scomp, nc);
+#ifdef AMREX_SOFT_PERF_COUNTERS
+            perf_counters.smooth(sol);
+#endif
+            Fsmooth(amrlev, mglev, sol, rhs, redblack, scomp, nc);
+            skip = false;
+        }
+        scomp += nc;
+    }
+}
+
+int
+MLABecLaplacian::smoothCompBlock (int amrlev, int mglev) const
+{
+    // ---- The bytes per component of sol, with one ghost cell, and rhs on
+    // ---- the most loaded process.  All the processes have the same BoxArray
+    // ---- and DistributionMapping, so they choose the same groups.
+    const BoxArray& ba = m_grids[amrlev][mglev];
+    const auto& pmap = m_dmap[amrlev][mglev].ProcessorMap();
+    Vector<Long> npts(*std::max_element(pmap.begin(), pmap.end()) + 1, 0);
+    Long maxpts = 1;
+    for (int i = 0, N = ba.size(); i < N; ++i) {
+        const Box& bx = ba[i];
+        npts[pmap[i]] += amrex::grow(bx,1).numPts() + bx.numPts();
+        maxpts = std::max(maxpts, npts[pmap[i]]);
+    }
+    const Long nblock = m_smooth_block_bytes / (maxpts * static_cast<Long>(sizeof(Real)));
+    return static_cast<int>(amrex::max(Long(1), amrex::min(Long(getNComp()), nblock)));
+}
+
 void
 MLABecLaplacian::FFlux (int amrlev, const MFIter& mfi,
                         const Array<FArrayBox*,AMREX_SPACEDIM>& flux,
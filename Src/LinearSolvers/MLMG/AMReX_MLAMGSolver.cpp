@@ -0,0 +1,1076 @@
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <numeric>
+
+#include <AMReX_MLAMGSolver.H>
+#include <AMReX_ParallelDescriptor.H>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace amrex {
+
+namespace {
+
+using CSR = MLAMGSolver::CSR;
+
+//! y = A x
+void spmv (const CSR& A, const Vector<Real>& x, Vector<Real>& y)
+{
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for (Long i = 0; i < A.nrows; ++i) {
+        Real s = 0.0;
+        for (Long k = A.row_ptr[i]; k < A.row_ptr[i+1]; ++k) {
+            s += A.val[k] * x[A.col[k]];
+        }
+        y[i] = s;
+    }
+}
+
+//! r = b - A x
+void residual (const CSR& A, const Vector<Real>& x, const Vector<Real>& b, Vector<Real>& r)
+{
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for (Long i = 0; i < A.nrows; ++i) {
+        Real s = b[i];
+        for (Long k = A.row_ptr[i]; k < A.row_ptr[i+1]; ++k) {
+            s -= A.val[k] * x[A.col[k]];
+        }
+        r[i] = s;
+    }
+}
+
+Real norm_inf (const Vector<Real>& v)
+{
+    Real r = 0.0;
+    const Long n = v.size();
+#ifdef _OPENMP
+#pragma omp parallel for reduction(max:r)
+#endif
+    for (Long i = 0; i < n; ++i) {
+        r = std::max(r, std::abs(v[i]));
+    }
+    return r;
+}
+
+Real dot (const Vector<Real>& u, const Vector<Real>& v)
+{
+    Real r = 0.0;
+    const Long n = u.size();
+#ifdef _OPENMP
+#pragma omp parallel for reduction(+:r)
+#endif
+    for (Long i = 0; i < n; ++i) {
+        r += u[i] * v[i];
+    }
+    return r;
+}
+
+Vector<Real> inverse_diagonal (const CSR& A)
+{
+    Vector<Real> dinv(A.nrows, 0.0);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for (Long i = 0; i < A.nrows; ++i) {
+        Real d = 0.0;
+        for (Long k = A.row_ptr[i]; k < A.row_ptr[i+1]; ++k) {
+            if (A.col[k] == i) d += A.val[k];
+        }
+        dinv[i] = (d != 0.0) ? 1.0/d : 0.0;
+    }
+    return dinv;
+}
+
+/**
+* A Gauss-Seidel sweep, forward or backward.  With OpenMP, the rows are
+* split into one block per thread, and each block uses the values of the
+* other blocks from before the sweep, like the hybrid smoother of hypre.
+*/
+void gauss_seidel (const CSR& A, const Vector<Real>& dinv, Vector<Real>& x,
+                   const Vector<Real>& b, Vector<Real>& xold, bool forward)
+{
+    const Long n = A.nrows;
+#ifdef _OPENMP
+    if (omp_get_max_threads() > 1) {
+        std::copy(x.begin(), x.end(), xold.begin());
+    }
+#pragma omp parallel
+#endif
+    {
+#ifdef _OPENMP
+        const int tid = omp_get_thread_num();
+        const int nthreads = omp_get_num_threads();
+#else
+        const int tid = 0;
+        const int nthreads = 1;
+#endif
+        const Long lo = n*tid/nthreads;
+        const Long hi = n*(tid+1)/nthreads;
+        auto relax = [&] (Long i)
+        {
+            Real s = b[i];
+            for (Long k = A.row_ptr[i]; k < A.row_ptr[i+1]; ++k) {
+                const Long j = A.col[k];
+                s -= A.val[k] * ((j >= lo && j < hi) ? x[j] : xold[j]);
+            }
+            x[i] += s * dinv[i];
+        };
+        if (forward) {
+            for (Long i = lo; i < hi; ++i) relax(i);
+        } else {
+            for (Long i = hi-1; i >= lo; --i) relax(i);
+        }
+    }
+}
+
+//! C = A B, by rows with one pass to count and one to fill.
+CSR multiply (const CSR& A, const CSR& B)
+{
+    CSR C;
+    C.nrows = A.nrows;
+    C.ncols = B.ncols;
+    C.row_ptr.assign(A.nrows+1, 0);
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    {
+        Vector<Long> marker(B.ncols, -1);
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+        for (Long i = 0; i < A.nrows; ++i) {
+            Long count = 0;
+            for (Long ka = A.row_ptr[i]; ka < A.row_ptr[i+1]; ++ka) {
+                const Long j = A.col[ka];
+                for (Long kb = B.row_ptr[j]; kb < B.row_ptr[j+1]; ++kb) {
+                    const Long c = B.col[kb];
+                    if (marker[c] != i) {
+                        marker[c] = i;
+                        ++count;
+                    }
+                }
+            }
+            C.row_ptr[i+1] = count;
+        }
+    }
+
+    std::partial_sum(C.row_ptr.begin(), C.row_ptr.end(), C.row_ptr.begin());
+    C.col.resize(C.row_ptr[A.nrows]);
+    C.val.resize(C.row_ptr[A.nrows]);
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    {
+        // ---- With the static schedule a thread has increasing rows, so the
+        // ---- positions left over from its previous rows are before start.
+        Vector<Long> pos(B.ncols, -1);
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+        for (Long i = 0; i < A.nrows; ++i) {
+            const Long start = C.row_ptr[i];
+            Long end = start;
+            for (Long ka = A.row_ptr[i]; ka < A.row_ptr[i+1]; ++ka) {
+                const Long j = A.col[ka];
+                const Real a = A.val[ka];
+                for (Long kb = B.row_ptr[j]; kb < B.row_ptr[j+1]; ++kb) {
+                    const Long c = B.col[kb];
+                    if (pos[c] < start) {
+                        pos[c] = end;
+                        C.col[end] = c;
+                        C.val[end] = a * B.val[kb];
+                        ++end;
+                    } else {
+                        C.val[pos[c]] += a * B.val[kb];
+                    }
+                }
+            }
+        }
+    }
+
+    return C;
+}
+
+CSR transpose (const CSR& A)
+{
+    CSR T;
+    T.nrows = A.ncols;
+    T.ncols = A.nrows;
+    T.row_ptr.assign(A.ncols+1, 0);
+    for (Long k = 0; k < A.nnz(); ++k) {
+        ++T.row_ptr[A.col[k]+1];
+    }
+    std::partial_sum(T.row_ptr.begin(), T.row_ptr.end(), T.row_ptr.begin());
+
+    Vector<Long> next(T.row_ptr.begin(), T.row_ptr.end()-1);
+    T.col.resize(A.nnz());
+    T.val.resize(A.nnz());
+    for (Long i = 0; i < A.nrows; ++i) {
+        for (Long k = A.row_ptr[i]; k < A.row_ptr[i+1]; ++k) {
+            const Long p = next[A.col[k]]++;
+            T.col[p] = i;
+            T.val[p] = A.val[k];
+        }
+    }
+    return T;
+}
+
+/**
+* Aggregates of strongly connected unknowns, with the three passes of Vanek,
+* Mandel and Brezina.  The unknowns without strong connections are left out
+* of the aggregates, agg is -1 for them, since the smoother takes care of
+* them.  Returns the number of aggregates.
+*/
+Long aggregate (const CSR& A, const Vector<Real>& dinv, Real theta, Vector<Long>& agg)
+{
+    const Long n = A.nrows;
+
+    // ---- The strong connections |a_ij| >= theta sqrt(|a_ii a_jj|).
+    Vector<Long> s_ptr(n+1, 0);
+    Vector<char> strong(A.nnz(), 0);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for (Long i = 0; i < n; ++i) {
+        Long count = 0;
+        for (Long k = A.row_ptr[i]; k < A.row_ptr[i+1]; ++k) {
+            const Long j = A.col[k];
+            if (j != i && dinv[i] != 0.0 && dinv[j] != 0.0 &&
+                std::abs(A.val[k]) >= theta / std::sqrt(std::abs(dinv[i]*dinv[j])))
+            {
+                strong[k] = 1;
+                ++count;
+            }
+        }
+        s_ptr[i+1] = count;
+    }
+
+    agg.assign(n, -1);
+    Long nagg = 0;
+
+    // ---- Pass 1: an unknown whose strong neighbors are all free starts an
+    // ---- aggregate with them.
+    for (Long i = 0; i < n; ++i) {
+        if (agg[i] != -1 || s_ptr[i+1] == 0) continue;
+        bool free = true;
+        for (Long k = A.row_ptr[i]; k < A.row_ptr[i+1] && free; ++k) {
+            if (strong[k] && agg[A.col[k]] != -1) free = false;
+        }
+        if (free) {
+            agg[i] = nagg;
+            for (Long k = A.row_ptr[i]; k < A.row_ptr[i+1]; ++k) {
+                if (strong[k]) agg[A.col[k]] = nagg;
+            }
+            ++nagg;
+        }
+    }
+
+    // ---- Pass 2: the others join the aggregate of their strongest
+    // ---- neighbor from pass 1.
+    const Vector<Long> agg1 = agg;
+    for (Long i = 0; i < n; ++i) {
+        if (agg[i] != -1 || s_ptr[i+1] == 0) continue;
+        Real amax = 0.0;
+        for (Long k = A.row_ptr[i]; k < A.row_ptr[i+1]; ++k) {
+            if (strong[k] && agg1[A.col[k]] != -1 && std::abs(A.val[k]) > amax) {
+                amax = std::abs(A.val[k]);
+                agg[i] = agg1[A.col[k]];
+            }
+        }
+    }
+
+    // ---- Pass 3: the rest make aggregates with their free strong neighbors.
+    for (Long i = 0; i < n; ++i) {
+        if (agg[i] != -1 || s_ptr[i+1] == 0) continue;
+        agg[i] = nagg;
+        for (Long k = A.row_ptr[i]; k < A.row_ptr[i+1]; ++k) {
+            if (strong[k] && agg[A.col[k]] == -1) agg[A.col[k]] = nagg;
+        }
+        ++nagg;
+    }
+
+    return nagg;
+}
+
+/**
+* The smoothed prolongation P = (I - omega D^{-1} A) P0, where the tentative
+* P0 interpolates the constants on each aggregate.  omega = 4/(3 rho), with a
+* Gershgorin bound of the spectral radius rho of D^{-1} A.
+*/
+CSR smoothed_prolongation (const CSR& A, const Vector<Real>& dinv,
+                           const Vector<Long>& agg, Long nagg)
+{
+    const Long n = A.nrows;
+
+    Vector<Long> agg_size(nagg, 0);
+    for (Long i = 0; i < n; ++i) {
+        if (agg[i] >= 0) ++agg_size[agg[i]];
+    }
+
+    CSR P0;
+    P0.nrows = n;
+    P0.ncols = nagg;
+    P0.row_ptr.resize(n+1);
+    P0.row_ptr[0] = 0;
+    for (Long i = 0; i < n; ++i) {
+        P0.row_ptr[i+1] = P0.row_ptr[i];
+        if (agg[i] >= 0) {
+            P0.col.push_back(agg[i]);
+            P0.val.push_back(1.0/std::sqrt(Real(agg_size[agg[i]])));
+            ++P0.row_ptr[i+1];
+        }
+    }
+
+    Real rho = 0.0;
+#ifdef _OPENMP
+#pragma omp parallel for reduction(max:rho)
+#endif
+    for (Long i = 0; i < n; ++i) {
+        Real s = 0.0;
+        for (Long k = A.row_ptr[i]; k < A.row_ptr[i+1]; ++k) {
+            s += std::abs(A.val[k]);
+        }
+        rho = std::max(rho, s*std::abs(dinv[i]));
+    }
+    const Real omega = (rho > 0.0) ? 4.0/(3.0*rho) : 0.0;
+
+    CSR S = A;
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for (Long i = 0; i < n; ++i) {
+        for (Long k = S.row_ptr[i]; k < S.row_ptr[i+1]; ++k) {
+            S.val[k] = ((S.col[k] == i) ? 1.0 : 0.0) - omega * dinv[i] * S.val[k];
+        }
+    }
+
+    return multiply(S, P0);
+}
+
+}
+
+MLAMGSolver::MLAMGSolver (MLLinOp& a_lp)
+    : Lp(a_lp),
+      mglev(a_lp.NMGLevels(0) - 1)
+{
+#ifdef AMREX_USE_GPU
+    amrex::Abort("MLAMGSolver: not supported on GPU builds");
+#endif
+}
+
+Real
+MLAMGSolver::getOperatorComplexity () const noexcept
+{
+    if (m_A.empty()) return 0.0;
+    Long nnz = 0;
+    for (const auto& A : m_A) nnz += A.nnz();
+    return Real(nnz) / Real(m_A[0].nnz());
+}
+
+int
+MLAMGSolver::solve (MultiFab& soln, const MultiFab& rhs, Real eps_rel, Real eps_abs)
+{
+    BL_PROFILE("MLAMGSolver::solve()");
+
+    AMREX_ALWAYS_ASSERT_WITH_MESSAGE(soln.nComp() == 1, "MLAMGSolver doesn't work with ncomp > 1");
+
+    if (!m_setup_done) {
+        BL_PROFILE_REGION("MLMG::setup");
+        setup(rhs);
+        m_setup_done = true;
+    }
+
+    Vector<Real> x, b;
+    gather(soln, x);
+    gather(rhs, b);
+
+    int ret = 0;
+    iter = 0;
+    Real rnorm0 = 0.0;
+    Real rnorm = 0.0;
+
+    if (m_root)
+    {
+        Vector<Real> r(m_A[0].nrows);
+        residual(m_A[0], x, b, r);
+        rnorm0 = norm_inf(r);
+        rnorm = rnorm0;
+
+        if ( verbose > 0 )
+        {
+            amrex::AllPrint() << "MLAMGSolver: Initial error (error0) = " << rnorm0 << '\n';
+        }
+
+        if (rnorm0 > 0.0 && rnorm0 >= eps_abs)
+        {
+            ret = m_symmetric ? solve_pcg(x, r, rnorm0, rnorm, eps_rel, eps_abs)
+                              : solve_pbicgstab(x, r, rnorm0, rnorm, eps_rel, eps_abs);
+            if (ret == 8 && verbose > 0) {
+                amrex::Warning("MLAMGSolver: failed to converge!");
+            }
+        }
+
+        if ( verbose > 0 )
+        {
+            amrex::AllPrint() << "MLAMGSolver: Final: Iteration "
+                              << std::setw(4) << iter
+                              << " rel. err. "
+                              << ((rnorm0 > 0.0) ? rnorm/rnorm0 : 0.0) << '\n';
+        }
+    }
+
+#ifdef BL_USE_MPI
+    {
+        int status[2] = {ret, iter};
+        BL_MPI_REQUIRE( MPI_Bcast(status, 2, MPI_INT, 0, Lp.BottomCommunicator()) );
+        ret = status[0];
+        iter = status[1];
+    }
+#endif
+
+    scatter(x, soln);
+
+    return ret;
+}
+
+int
+MLAMGSolver::solve_pcg (Vector<Real>& x, Vector<Real>& r, Real rnorm0, Real& rnorm,
+                        Real eps_rel, Real eps_abs)
+{
+    const CSR& A = m_A[0];
+    const Long n = A.nrows;
+    Vector<Real> z(n), p(n), q(n);
+
+    precondition(r, z);
+    std::copy(z.begin(), z.end(), p.begin());
+    Real rz = dot(r, z);
+
+    for (iter = 1; iter <= maxiter; ++iter)
+    {
+        spmv(A, p, q);
+        const Real pq = dot(p, q);
+        if (pq == 0.0) return 1;
+        const Real alpha = rz / pq;
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for (Long i = 0; i < n; ++i) {
+            x[i] += alpha * p[i];
+            r[i] -= alpha * q[i];
+        }
+
+        rnorm = norm_inf(r);
+        if ( verbose > 2 )
+        {
+            amrex::AllPrint() << "MLAMGSolver_PCG: Iteration "
+                              << std::setw(4) << iter
+                              << " rel. err. "
+                              << rnorm/rnorm0 << '\n';
+        }
+        if (rnorm < eps_rel*rnorm0 || rnorm < eps_abs) return 0;
+
+        precondition(r, z);
+        const Real rz_new = dot(r, z);
+        const Real beta = rz_new / rz;
+        rz = rz_new;
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for (Long i = 0; i < n; ++i) {
+            p[i] = z[i] + beta * p[i];
+        }
+    }
+
+    iter = maxiter;
+    return 8;
+}
+
+int
+MLAMGSolver::solve_pbicgstab (Vector<Real>& x, Vector<Real>& r, Real rnorm0, Real& rnorm,
+                              Real eps_rel, Real eps_abs)
+{
+    const CSR& A = m_A[0];
+    const Long n = A.nrows;
+    Vector<Real> rh(r.begin(), r.end());
+    Vector<Real> p(n, 0.0), v(n, 0.0), ph(n), sh(n), t(n);
+    Real rho = 1.0, alpha = 1.0, omega = 1.0;
+
+    for (iter = 1; iter <= maxiter; ++iter)
+    {
+        const Real rho_new = dot(rh, r);
+        if (rho_new == 0.0) return 1;
+        const Real beta = (rho_new/rho) * (alpha/omega);
+        rho = rho_new;
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for (Long i = 0; i < n; ++i) {
+            p[i] = r[i] + beta * (p[i] - omega * v[i]);
+        }
+
+        precondition(p, ph);
+        spmv(A, ph, v);
+        const Real rhv = dot(rh, v);
+        if (rhv == 0.0) return 2;
+        alpha = rho / rhv;
+        // ---- r becomes s = r - alpha v
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for (Long i = 0; i < n; ++i) {
+            x[i] += alpha * ph[i];
+            r[i] -= alpha * v[i];
+        }
+
+        rnorm = norm_inf(r);
+        if (rnorm < eps_rel*rnorm0 || rnorm < eps_abs) return 0;
+
+        precondition(r, sh);
+        spmv(A, sh, t);
+        const Real tt = dot(t, t);
+        if (tt == 0.0) return 3;
+        omega = dot(t, r) / tt;
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for (Long i = 0; i < n; ++i) {
+            x[i] += omega * sh[i];
+            r[i] -= omega * t[i];
+        }
+
+        rnorm = norm_inf(r);
+        if ( verbose > 2 )
+        {
+            amrex::AllPrint() << "MLAMGSolver_BiCGStab: Iteration "
+                              << std::setw(4) << iter
+                              << " rel. err. "
+                              << rnorm/rnorm0 << '\n';
+        }
+        if (rnorm < eps_rel*rnorm0 || rnorm < eps_abs) return 0;
+        if (omega == 0.0) return 4;
+    }
+
+    iter = maxiter;
+    return 8;
+}
+
+void
+MLAMGSolver::precondition (const Vector<Real>& r, Vector<Real>& z)
+{
+    std::fill(z.begin(), z.end(), 0.0);
+    vcycle(0, z, r);
+}
+
+void
+MLAMGSolver::numberUnknowns (const MultiFab& rhs)
+{
+    BL_PROFILE("MLAMGSolver::numberUnknowns()");
+
+    const BoxArray& ba = rhs.boxArray();
+    const DistributionMapping& dm = rhs.DistributionMap();
+    const Geometry& geom = Lp.Geom(amrlev, mglev);
+
+    // ---- Number the unknowns, process by process, in the order of MFIter.
+    m_owner.define(ba, dm, 1, 0);
+    Lp.fillBottomDofMask(m_owner);
+
+    m_nowned = 0;
+    for (MFIter mfi(m_owner); mfi.isValid(); ++mfi) {
+        const auto& o = m_owner.const_array(mfi);
+        amrex::LoopOnCpu(mfi.validbox(), [&] (int i, int j, int k)
+        {
+            if (o(i,j,k)) ++m_nowned;
+        });
+    }
+
+    int nprocs = 1;
+    int myproc = 0;
+    Vector<Long> nowned_all(1, m_nowned);
+#ifdef BL_USE_MPI
+    MPI_Comm comm = Lp.BottomCommunicator();
+    BL_MPI_REQUIRE( MPI_Comm_size(comm, &nprocs) );
+    BL_MPI_REQUIRE( MPI_Comm_rank(comm, &myproc) );
+    nowned_all.resize(nprocs);
+    const MPI_Datatype long_type = ParallelDescriptor::Mpi_typemap<Long>::type();
+    BL_MPI_REQUIRE( MPI_Allgather(&m_nowned, 1, long_type, nowned_all.data(), 1, long_type, comm) );
+#endif
+    m_ntotal = std::accumulate(nowned_all.begin(), nowned_all.end(), Long(0));
+    if (m_ntotal > max_bottom_size || m_ntotal >= std::numeric_limits<int>::max()) {
+        amrex::Abort("MLAMGSolver: the bottom problem has " + std::to_string(m_ntotal)
+                     + " unknowns, more than the " + std::to_string(max_bottom_size)
+                     + " allowed on one process.  Coarsen or agglomerate the bottom level"
+                     + " further, use the hypre bottom solver, or raise the limit with"
+                     + " MLMG::setAMGMaxBottomSize.");
+    }
+    m_root = (myproc == 0);
+    m_gid_begin = std::accumulate(nowned_all.begin(), nowned_all.begin()+myproc, Long(0));
+    m_counts.resize(nprocs);
+    m_displs.resize(nprocs);
+    for (int p = 0; p < nprocs; ++p) {
+        m_counts[p] = nowned_all[p];
+        m_displs[p] = (p == 0) ? 0 : m_displs[p-1] + m_counts[p-1];
+    }
+
+    // ---- The ids are stored plus one, so that OverrideSync copies the id of
+    // ---- the owner of a shared node to the others, and 0 means no unknown.
+    m_gid.define(ba, dm, 1, 1);
+    m_gid.setVal(0);
+    {
+        Long id = m_gid_begin;
+        for (MFIter mfi(m_gid); mfi.isValid(); ++mfi) {
+            const auto& o = m_owner.const_array(mfi);
+            const auto& g = m_gid.array(mfi);
+            amrex::LoopOnCpu(mfi.validbox(), [&] (int i, int j, int k)
+            {
+                if (o(i,j,k)) g(i,j,k) = ++id;
+            });
+        }
+    }
+    if (!Lp.isCellCentered()) {
+        amrex::OverrideSync(m_gid, m_owner, geom.periodicity());
+    }
+    m_gid.FillBoundary(geom.periodicity());
+    m_gid.plus(-1, 0, 1, 1);
+}
+
+void
+MLAMGSolver::setup (const MultiFab& rhs)
+{
+    BL_PROFILE("MLAMGSolver::setup()");
+
+    if (m_counts.empty()) {
+        numberUnknowns(rhs);
+    }
+
+    const Long ntotal = m_ntotal;
+#ifdef BL_USE_MPI
+    MPI_Comm comm = Lp.BottomCommunicator();
+    const int nprocs = m_counts.size();
+    const MPI_Datatype long_type = ParallelDescriptor::Mpi_typemap<Long>::type();
+#endif
+
+    // ---- Assemble the local rows, and gather the whole matrix on the root.
+    CSR Aloc;
+    assemble(rhs, Aloc);
+
+    CSR A;
+    A.nrows = ntotal;
+    A.ncols = ntotal;
+    {
+        Vector<Long> row_len(m_nowned);
+        for (Long i = 0; i < m_nowned; ++i) {
+            row_len[i] = Aloc.row_ptr[i+1] - Aloc.row_ptr[i];
+        }
+        Vector<Long> all_len(m_root ? ntotal : 0);
+#ifdef BL_USE_MPI
+        Long nnz_loc = Aloc.nnz();
+        BL_MPI_REQUIRE( MPI_Gatherv(row_len.data(), m_nowned, long_type,
+                                    all_len.data(), m_counts.data(), m_displs.data(),
+                                    long_type, 0, comm) );
+        Vector<Long> nnz_all(m_root ? nprocs : 0);
+        BL_MPI_REQUIRE( MPI_Gather(&nnz_loc, 1, long_type, nnz_all.data(), 1, long_type, 0, comm) );
+        Vector<int> nnz_counts(nnz_all.size()), nnz_displs(nnz_all.size());
+        for (int p = 0, N = nnz_all.size(); p < N; ++p) {
+            nnz_counts[p] = nnz_all[p];
+            nnz_displs[p] = (p == 0) ? 0 : nnz_displs[p-1] + nnz_counts[p-1];
+        }
+#else
+        all_len = row_len;
+#endif
+        if (m_root) {
+            A.row_ptr.resize(ntotal+1);
+            A.row_ptr[0] = 0;
+            std::partial_sum(all_len.begin(), all_len.end(), A.row_ptr.begin()+1);
+            AMREX_ALWAYS_ASSERT_WITH_MESSAGE(A.row_ptr[ntotal] < std::numeric_limits<int>::max(),
+                                             "MLAMGSolver: the bottom problem is too large");
+        }
+#ifdef BL_USE_MPI
+        A.col.resize(m_root ? A.row_ptr[ntotal] : 0);
+        A.val.resize(m_root ? A.row_ptr[ntotal] : 0);
+        BL_MPI_REQUIRE( MPI_Gatherv(Aloc.col.data(), nnz_loc, long_type,
+                                    A.col.data(), nnz_counts.data(), nnz_displs.data(),
+                                    long_type, 0, comm) );
+        const MPI_Datatype real_type = ParallelDescriptor::Mpi_typemap<Real>::type();
+        BL_MPI_REQUIRE( MPI_Gatherv(Aloc.val.data(), nnz_loc, real_type,
+                                    A.val.data(), nnz_counts.data(), nnz_displs.data(),
+                                    real_type, 0, comm) );
+#else
+        A.col = std::move(Aloc.col);
+        A.val = std::move(Aloc.val);
+#endif
+    }
+
+    m_A.clear();
+    m_P.clear();
+    m_R.clear();
+    m_dinv.clear();
+    if (!m_root) return;
+
+    // ---- Build the hierarchy.
+    m_A.push_back(std::move(A));
+    const int max_levels = 25;
+    while (true)
+    {
+        const CSR& Af = m_A.back();
+        m_dinv.push_back(inverse_diagonal(Af));
+        if (Af.nrows <= max_coarse_size || m_A.size() == max_levels) break;
+
+        Vector<Long> agg;
+        // ---- The coarse operators have wider stencils, so the threshold is
+        // ---- halved on each level, as Vanek, Mandel and Brezina do.
+        const Real theta = strong_threshold * std::pow(0.5, m_A.size()-1);
+        const Long nagg = aggregate(Af, m_dinv.back(), theta, agg);
+        if (nagg == 0 || nagg >= Af.nrows) break;
+
+        CSR P = smoothed_prolongation(Af, m_dinv.back(), agg, nagg);
+        CSR R = transpose(P);
+        CSR Ac = multiply(R, multiply(Af, P));
+        m_P.push_back(std::move(P));
+        m_R.push_back(std::move(R));
+        m_A.push_back(std::move(Ac));
+    }
+
+    // ---- Test the symmetry with u.(A v) = v.(A u) for two vectors.
+    {
+        const CSR& A0 = m_A[0];
+        const Long n = A0.nrows;
+        Vector<Real> u(n), v(n), Au(n), Av(n);
+        for (Long i = 0; i < n; ++i) {
+            u[i] = std::sin(Real(i+1));
+            v[i] = std::cos(Real(3*i+1));
+        }
+        spmv(A0, u, Au);
+        spmv(A0, v, Av);
+        const Real uAv = dot(u, Av);
+        const Real vAu = dot(v, Au);
+        m_symmetric = std::abs(uAv-vAu) <= 1.e-10 * std::sqrt(dot(Au,Au)*dot(v,v));
+    }
+
+    const int nlevs = m_A.size();
+    m_x.resize(nlevs);
+    m_b.resize(nlevs);
+    m_r.resize(nlevs);
+    m_tmp.resize(nlevs);
+    for (int lev = 0; lev < nlevs; ++lev) {
+        m_x[lev].resize(m_A[lev].nrows);
+        m_b[lev].resize(m_A[lev].nrows);
+        m_r[lev].resize(m_A[lev].nrows);
+        m_tmp[lev].resize(m_A[lev].nrows);
+    }
+
+    // ---- LU factorization of the coarsest matrix.  A pivot that vanishes,
+    // ---- as for a singular problem, sets its unknown to zero.
+    m_lu.clear();
+    m_piv.clear();
+    m_null_pivot.clear();
+    const CSR& Ac = m_A.back();
+    const Long n = Ac.nrows;
+    if (n <= 4*max_coarse_size)
+    {
+        m_lu.assign(n*n, 0.0);
+        m_piv.resize(n);
+        m_null_pivot.assign(n, 0);
+        Real amax = 0.0;
+        for (Long i = 0; i < n; ++i) {
+            for (Long k = Ac.row_ptr[i]; k < Ac.row_ptr[i+1]; ++k) {
+                m_lu[i*n+Ac.col[k]] += Ac.val[k];
+                amax = std::max(amax, std::abs(Ac.val[k]));
+            }
+        }
+        const Real tol = 1.e-10 * amax;
+        for (Long k = 0; k < n; ++k) {
+            Long p = k;
+            for (Long i = k+1; i < n; ++i) {
+                if (std::abs(m_lu[i*n+k]) > std::abs(m_lu[p*n+k])) p = i;
+            }
+            m_piv[k] = p;
+            if (p != k) {
+                std::swap_ranges(m_lu.begin()+k*n, m_lu.begin()+(k+1)*n, m_lu.begin()+p*n);
+            }
+            if (std::abs(m_lu[k*n+k]) <= tol) {
+                m_null_pivot[k] = 1;
+                for (Long i = k+1; i < n; ++i) m_lu[i*n+k] = 0.0;
+                continue;
+            }
+            for (Long i = k+1; i < n; ++i) {
+                const Real l = m_lu[i*n+k] / m_lu[k*n+k];
+                m_lu[i*n+k] = l;
+                if (l != 0.0) {
+                    for (Long j = k+1; j < n; ++j) m_lu[i*n+j] -= l * m_lu[k*n+j];
+                }
+            }
+        }
+    }
+
+    if ( verbose > 0 )
+    {
+        amrex::AllPrint() << "MLAMGSolver: " << nlevs << " levels, " << m_A[0].nrows
+                          << " unknowns, operator complexity " << getOperatorComplexity()
+                          << (m_symmetric ? ", symmetric" : ", nonsymmetric") << '\n';
+        if ( verbose > 1 )
+        {
+            for (int lev = 0; lev < nlevs; ++lev) {
+                amrex::AllPrint() << "    Level " << lev << ": " << m_A[lev].nrows << " rows, "
+                                  << m_A[lev].nnz() << " nonzeros\n";
+            }
+        }
+    }
+}
+
+void
+MLAMGSolver::assemble (const MultiFab& rhs, CSR& A)
+{
+    BL_PROFILE("MLAMGSolver::assemble()");
+
+    // ---- The operator is applied to vectors that are one on the unknowns
+    // ---- of one color and zero elsewhere.  No two unknowns of a color are
+    // ---- within one cell of each other, so the value of the result at an
+    // ---- unknown is its coefficient for the unique neighbor of that color.
+    // ---- In a periodic direction, the last n%3 cells have colors of their
+    // ---- own, so that the colors do not clash across the boundary.
+    const Geometry& geom = Lp.Geom(amrlev, mglev);
+    const Box& domain = geom.Domain();
+    IntVect ncolors(1);
+    for (int d = 0; d < AMREX_SPACEDIM; ++d) {
+        const int n = domain.length(d);
+        ncolors[d] = geom.isPeriodic(d) ? ((n < 3) ? n : 3 + n%3) : 3;
+    }
+    auto color = [&] (const IntVect& iv) -> IntVect
+    {
+        IntVect c;
+        for (int d = 0; d < AMREX_SPACEDIM; ++d) {
+            const int n = domain.length(d);
+            int i = iv[d] - domain.smallEnd(d);
+            if (geom.isPeriodic(d)) {
+                i = ((i % n) + n) % n;
+                const int n3 = 3*(n/3);
+                c[d] = (n < 3) ? i : ((i < n3) ? i%3 : 3 + i - n3);
+            } else {
+                c[d] = ((i % 3) + 3) % 3;
+            }
+        }
+        return c;
+    };
+
+    const BoxArray& ba = rhs.boxArray();
+    const DistributionMapping& dm = rhs.DistributionMap();
+    MultiFab v (ba, dm, 1, 1, MFInfo(), *Lp.Factory(amrlev, mglev));
+    MultiFab Av(ba, dm, 1, 1, MFInfo(), *Lp.Factory(amrlev, mglev));
+
+    Vector<Long> trow, tcol;
+    Vector<Real> tval;
+
+    const Box color_box(IntVect(0), ncolors - 1);
+    for (IntVect c = color_box.smallEnd(); c <= color_box.bigEnd(); color_box.next(c))
+    {
+        v.setVal(0.0);
+        for (MFIter mfi(v); mfi.isValid(); ++mfi) {
+            const auto& g = m_gid.const_array(mfi);
+            const auto& a = v.array(mfi);
+            amrex::LoopOnCpu(mfi.validbox(), [&] (int i, int j, int k)
+            {
+                amrex::ignore_unused(j,k);
+                const IntVect iv(AMREX_D_DECL(i,j,k));
+                if (g(iv) >= 0 && color(iv) == c) a(iv) = 1.0;
+            });
+        }
+
+        Lp.apply(amrlev, mglev, Av, v, MLLinOp::BCMode::Homogeneous, MLLinOp::StateMode::Correction);
+
+        for (MFIter mfi(Av); mfi.isValid(); ++mfi) {
+            const auto& g = m_gid.const_array(mfi);
+            const auto& o = m_owner.const_array(mfi);
+            const auto& a = Av.const_array(mfi);
+            amrex::LoopOnCpu(mfi.validbox(), [&] (int i, int j, int k)
+            {
+                amrex::ignore_unused(j,k);
+                const IntVect iv(AMREX_D_DECL(i,j,k));
+                if (!o(iv)) return;
+                IntVect nb = iv;
+                for (int d = 0; d < AMREX_SPACEDIM; ++d) {
+                    bool found = false;
+                    for (int off = -1; off <= 1 && !found; ++off) {
+                        IntVect jv = iv;
+                        jv[d] += off;
+                        if (color(jv)[d] == c[d]) {
+                            nb[d] = jv[d];
+                            found = true;
+                        }
+                    }
+                    if (!found) return;
+                }
+                const Long col = g(nb);
+                const Long row = g(iv);
+                if (col >= 0 && (a(iv) != 0.0 || col == row)) {
+                    trow.push_back(row - m_gid_begin);
+                    tcol.push_back(col);
+                    tval.push_back(a(iv));
+                }
+            });
+        }
+    }
+
+    // ---- Sort the entries by rows.
+    A.nrows = m_nowned;
+    A.row_ptr.assign(m_nowned+1, 0);
+    for (Long r : trow) ++A.row_ptr[r+1];
+    std::partial_sum(A.row_ptr.begin(), A.row_ptr.end(), A.row_ptr.begin());
+    Vector<Long> next(A.row_ptr.begin(), A.row_ptr.end()-1);
+    A.col.resize(trow.size());
+    A.val.resize(trow.size());
+    for (Long k = 0, N = trow.size(); k < N; ++k) {
+        const Long p = next[trow[k]]++;
+        A.col[p] = tcol[k];
+        A.val[p] = tval[k];
+    }
+
+    // ---- The rows of the unknowns the operator does not see, such as the
+    // ---- covered cells of EB, become identities.
+    for (Long i = 0; i < m_nowned; ++i) {
+        bool zero = true;
+        for (Long k = A.row_ptr[i]; k < A.row_ptr[i+1]; ++k) {
+            if (A.val[k] != 0.0) zero = false;
+        }
+        if (zero) {
+            for (Long k = A.row_ptr[i]; k < A.row_ptr[i+1]; ++k) {
+                if (A.col[k] == i + m_gid_begin) A.val[k] = 1.0;
+            }
+        }
+    }
+}
+
+void
+MLAMGSolver::gather (const MultiFab& mf, Vector<Real>& v) const
+{
+    Vector<Real> local;
+    local.reserve(m_nowned);
+    for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
+        const auto& o = m_owner.const_array(mfi);
+        const auto& a = mf.const_array(mfi);
+        amrex::LoopOnCpu(mfi.validbox(), [&] (int i, int j, int k)
+        {
+            if (o(i,j,k)) local.push_back(a(i,j,k));
+        });
+    }
+
+#ifdef BL_USE_MPI
+    v.resize(m_root ? m_ntotal : 0);
+    const MPI_Datatype real_type = ParallelDescriptor::Mpi_typemap<Real>::type();
+    BL_MPI_REQUIRE( MPI_Gatherv(local.data(), m_nowned, real_type,
+                                v.data(), m_counts.data(), m_displs.data(),
+                                real_type, 0, Lp.BottomCommunicator()) );
+#else
+    v = std::move(local);
+#endif
+}
+
+void
+MLAMGSolver::scatter (const Vector<Real>& v, MultiFab& mf) const
+{
+#ifdef BL_USE_MPI
+    Vector<Real> local(m_nowned);
+    const MPI_Datatype real_type = ParallelDescriptor::Mpi_typemap<Real>::type();
+    BL_MPI_REQUIRE( MPI_Scatterv(v.data(), m_counts.data(), m_displs.data(), real_type,
+                                 local.data(), m_nowned, real_type,
+                                 0, Lp.BottomCommunicator()) );
+#else
+    const Vector<Real>& local = v;
+#endif
+
+    Long id = 0;
+    for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
+        const auto& o = m_owner.const_array(mfi);
+        const auto& a = mf.array(mfi);
+        amrex::LoopOnCpu(mfi.validbox(), [&] (int i, int j, int k)
+        {
+            a(i,j,k) = o(i,j,k) ? local[id++] : 0.0;
+        });
+    }
+
+    // ---- The nodes shared by several boxes take the value of their owner.
+    if (!Lp.isCellCentered()) {
+        amrex::OverrideSync(mf, m_owner, Lp.Geom(amrlev, mglev).periodicity());
+    }
+}
+
+void
+MLAMGSolver::vcycle (int lev, Vector<Real>& x, const Vector<Real>& b)
+{
+    if (lev == static_cast<int>(m_A.size())-1) {
+        coarsestSolve(x, b);
+        return;
+    }
+
+    const CSR& A = m_A[lev];
+    for (int s = 0; s < num_sweeps; ++s) {
+        gauss_seidel(A, m_dinv[lev], x, b, m_tmp[lev], true);
+    }
+
+    residual(A, x, b, m_r[lev]);
+    spmv(m_R[lev], m_r[lev], m_b[lev+1]);
+    std::fill(m_x[lev+1].begin(), m_x[lev+1].end(), 0.0);
+    vcycle(lev+1, m_x[lev+1], m_b[lev+1]);
+
+    Vector<Real>& cor = m_tmp[lev];
+    spmv(m_P[lev], m_x[lev+1], cor);
+    const Long n = A.nrows;
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for (Long i = 0; i < n; ++i) {
+        x[i] += cor[i];
+    }
+
+    for (int s = 0; s < num_sweeps; ++s) {
+        gauss_seidel(A, m_dinv[lev], x, b, m_tmp[lev], false);
+    }
+}
+
+void
+MLAMGSolver::coarsestSolve (Vector<Real>& x, const Vector<Real>& b)
+{
+    const int lev = m_A.size()-1;
+    const Long n = m_A[lev].nrows;
+
+    if (m_lu.empty())
+    {
+        // ---- Coarsening stalled on a large level.
+        for (int s = 0; s < 10; ++s) {
+            gauss_seidel(m_A[lev], m_dinv[lev], x, b, m_tmp[lev], true);
+            gauss_seidel(m_A[lev], m_dinv[lev], x, b, m_tmp[lev], false);
+        }
+        return;
+    }
+
+    std::copy(b.begin(), b.end(), x.begin());
+    for (Long k = 0; k < n; ++k) {
+        if (m_piv[k] != k) std::swap(x[k], x[m_piv[k]]);
+    }
+    for (Long i = 0; i < n; ++i) {
+        Real s = x[i];
+        for (Long j = 0; j < i; ++j) s -= m_lu[i*n+j] * x[j];
+        x[i] = s;
+    }
+    for (Long i = n-1; i >= 0; --i) {
+        if (m_null_pivot[i]) {
+            x[i] = 0.0;
+            continue;
+        }
+        Real s = x[i];
+        for (Long j = i+1; j < n; ++j) s -= m_lu[i*n+j] * x[j];
+        x[i] = s / m_lu[i*n+i];
+    }
+}
+
+}
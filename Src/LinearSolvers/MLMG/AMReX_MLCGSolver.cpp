@@ -48,6 +48,39 @@ sxay (MultiFab&       ss,
     sxay(ss,xx,a,yy,0,nghost);
 }
 
+//! Sum reductions and a max reduction over comm that proceed in the
+//! background between start() and wait().
+class NonBlockingReduce
+{
+public:
+    void start (Real* sums, int nsums, Real* max_val, MPI_Comm comm)
+    {
+#ifdef BL_USE_MPI
+        BL_PROFILE("MLCGSolver::ParallelAllReduce");
+        MPI_Datatype real_type = ParallelDescriptor::Mpi_typemap<Real>::type();
+        BL_MPI_REQUIRE( MPI_Iallreduce(MPI_IN_PLACE, sums, nsums, real_type, MPI_SUM,
+                                       comm, &m_req[0]) );
+        BL_MPI_REQUIRE( MPI_Iallreduce(MPI_IN_PLACE, max_val, 1, real_type, MPI_MAX,
+                                       comm, &m_req[1]) );
+#else
+        amrex::ignore_unused(sums, nsums, max_val, comm);
+#endif
+    }
+
+    void wait ()
+    {
+#ifdef BL_USE_MPI
+        BL_PROFILE("MLCGSolver::ParallelAllReduce");
+        BL_MPI_REQUIRE( MPI_Waitall(2, m_req, MPI_STATUSES_IGNORE) );
+#endif
+    }
+
+private:
+#ifdef BL_USE_MPI
+    MPI_Request m_req[2];
+#endif
+};
+
 }
 
 MLCGSolver::MLCGSolver (MLMG* a_mlmg, MLLinOp& _lp, Type _typ)
@@ -72,6 +105,10 @@ MLCGSolver::solve (MultiFab&       sol,
 {
     if (solver_type == Type::BiCGStab) {
         return solve_bicgstab(sol,rhs,eps_rel,eps_abs);
+    } else if (solver_type == Type::PipeCG) {
+        return solve_pipecg(sol,rhs,eps_rel,eps_abs);
+    } else if (solver_type == Type::PipeBiCGStab) {
+        return solve_pipebicgstab(sol,rhs,eps_rel,eps_abs);
     } else {
         return solve_cg(sol,rhs,eps_rel,eps_abs);
     }
@@ -395,6 +432,350 @@ MLCGSolver::solve_cg (MultiFab&       sol,
     return ret;
 }
 
+int
+MLCGSolver::solve_pipecg (MultiFab&       sol,
+                          const MultiFab& rhs,
+                          Real            eps_rel,
+                          Real            eps_abs)
+{
+    BL_PROFILE("MLCGSolver::pipecg");
+
+    const int ncomp = sol.nComp();
+
+    const BoxArray& ba = sol.boxArray();
+    const DistributionMapping& dm = sol.DistributionMap();
+    const auto& factory = sol.Factory();
+
+    // r and w are the inputs of apply and need its ghost cells.
+    MultiFab r(ba, dm, ncomp, sol.nGrow(), MFInfo(), factory);
+    MultiFab w(ba, dm, ncomp, sol.nGrow(), MFInfo(), factory);
+    r.setVal(0.0);
+    w.setVal(0.0);
+
+    MultiFab sorig(ba, dm, ncomp, nghost, MFInfo(), factory);
+    MultiFab p    (ba, dm, ncomp, nghost, MFInfo(), factory);
+    MultiFab s    (ba, dm, ncomp, nghost, MFInfo(), factory);
+    MultiFab z    (ba, dm, ncomp, nghost, MFInfo(), factory);
+    MultiFab q    (ba, dm, ncomp, nghost, MFInfo(), factory);
+
+    MultiFab::Copy(sorig,sol,0,0,ncomp,nghost);
+
+    Lp.correctionResidual(amrlev, mglev, r, sol, rhs, MLLinOp::BCMode::Homogeneous);
+
+    sol.setVal(0);
+
+    Real       rnorm    = norm_inf(r);
+    const Real rnorm0   = rnorm;
+
+    if ( verbose > 0 )
+    {
+        amrex::Print() << "MLCGSolver_PipeCG: Initial error (error0) :        " << rnorm0 << '\n';
+    }
+
+    int  ret = 0;
+    iter = 1;
+
+    if ( rnorm0 == 0 || rnorm0 < eps_abs )
+    {
+        if ( verbose > 0 ) {
+            amrex::Print() << "MLCGSolver_PipeCG: niter = 0,"
+                           << ", rnorm = " << rnorm
+                           << ", eps_abs = " << eps_abs << std::endl;
+        }
+        return ret;
+    }
+
+    // w = A r, and then q = A w, z = A s and s = A p are kept by recurrences.
+    Lp.apply(amrlev, mglev, w, r, MLLinOp::BCMode::Homogeneous, MLLinOp::StateMode::Correction);
+
+    Real gamma_1 = 0, alpha_1 = 0;
+    NonBlockingReduce reduce;
+
+    for (; iter <= maxiter; ++iter)
+    {
+        // The one global synchronization of the iteration is overlapped with q = A w.
+        Real dots[2] = { dotxy(r,r,true), dotxy(w,r,true) };
+        rnorm = norm_inf(r,true);
+        reduce.start(dots, 2, &rnorm, Lp.BottomCommunicator());
+        Lp.apply(amrlev, mglev, q, w, MLLinOp::BCMode::Homogeneous, MLLinOp::StateMode::Correction);
+        reduce.wait();
+
+        if ( verbose > 2 )
+        {
+            amrex::Print() << "MLCGSolver_PipeCG:   Iteration"
+                           << std::setw(4) << iter-1
+                           << " rel. err. "
+                           << rnorm/(rnorm0) << '\n';
+        }
+
+        if ( iter > 1 && (rnorm < eps_rel*rnorm0 || rnorm < eps_abs) ) {
+            --iter;
+            break;
+        }
+
+        const Real gamma = dots[0];
+        const Real delta = dots[1];
+        Real alpha, beta;
+        if (iter == 1)
+        {
+            beta = 0.0;
+            if ( delta == 0.0_rt ) { ret = 1; break; }
+            alpha = gamma/delta;
+        }
+        else
+        {
+            beta = gamma/gamma_1;
+            const Real denom = delta - beta*gamma/alpha_1;
+            if ( denom == 0.0_rt ) { ret = 1; break; }
+            alpha = gamma/denom;
+        }
+
+        if (iter == 1)
+        {
+            MultiFab::Copy(z,q,0,0,ncomp,nghost);
+            MultiFab::Copy(s,w,0,0,ncomp,nghost);
+            MultiFab::Copy(p,r,0,0,ncomp,nghost);
+        }
+        else
+        {
+            sxay(z, q, beta, z, nghost);
+            sxay(s, w, beta, s, nghost);
+            sxay(p, r, beta, p, nghost);
+        }
+        sxay(sol, sol,  alpha, p, nghost);
+        sxay(  r,   r, -alpha, s, nghost);
+        sxay(  w,   w, -alpha, z, nghost);
+
+        gamma_1 = gamma;
+        alpha_1 = alpha;
+    }
+
+    if (iter > maxiter) {
+        rnorm = norm_inf(r);
+        iter = maxiter;
+    }
+
+    if ( verbose > 0 )
+    {
+        amrex::Print() << "MLCGSolver_PipeCG: Final Iteration"
+                       << std::setw(4) << iter
+                       << " rel. err. "
+                       << rnorm/(rnorm0) << '\n';
+    }
+
+    if ( ret == 0 &&  rnorm > eps_rel*rnorm0 && rnorm > eps_abs )
+    {
+        if ( verbose > 0 && ParallelDescriptor::IOProcessor() )
+            amrex::Warning("MLCGSolver_PipeCG: failed to converge!");
+        ret = 8;
+    }
+
+    if ( ( ret == 0 || ret == 8 ) && (rnorm < rnorm0) )
+    {
+        sol.plus(sorig, 0, ncomp, nghost);
+    }
+    else
+    {
+        sol.setVal(0);
+        sol.plus(sorig, 0, ncomp, nghost);
+    }
+
+    return ret;
+}
+
+int
+MLCGSolver::solve_pipebicgstab (MultiFab&       sol,
+                                const MultiFab& rhs,
+                                Real            eps_rel,
+                                Real            eps_abs)
+{
+    BL_PROFILE("MLCGSolver::pipebicgstab");
+
+    const int ncomp = sol.nComp();
+
+    const BoxArray& ba = sol.boxArray();
+    const DistributionMapping& dm = sol.DistributionMap();
+    const auto& factory = sol.Factory();
+
+    // r, w and z are the inputs of apply and need its ghost cells.
+    MultiFab r(ba, dm, ncomp, sol.nGrow(), MFInfo(), factory);
+    MultiFab w(ba, dm, ncomp, sol.nGrow(), MFInfo(), factory);
+    MultiFab z(ba, dm, ncomp, sol.nGrow(), MFInfo(), factory);
+    r.setVal(0.0);
+    w.setVal(0.0);
+    z.setVal(0.0);
+
+    MultiFab sorig(ba, dm, ncomp, nghost, MFInfo(), factory);
+    MultiFab rh   (ba, dm, ncomp, nghost, MFInfo(), factory);
+    MultiFab p    (ba, dm, ncomp, nghost, MFInfo(), factory);
+    MultiFab s    (ba, dm, ncomp, nghost, MFInfo(), factory);
+    MultiFab t    (ba, dm, ncomp, nghost, MFInfo(), factory);
+    MultiFab q    (ba, dm, ncomp, nghost, MFInfo(), factory);
+    MultiFab y    (ba, dm, ncomp, nghost, MFInfo(), factory);
+    MultiFab v    (ba, dm, ncomp, nghost, MFInfo(), factory);
+    p.setVal(0.0);
+    s.setVal(0.0);
+    v.setVal(0.0);
+
+    Lp.correctionResidual(amrlev, mglev, r, sol, rhs, MLLinOp::BCMode::Homogeneous);
+    Lp.normalize(amrlev, mglev, r);
+
+    MultiFab::Copy(sorig,sol,0,0,ncomp,nghost);
+    MultiFab::Copy(rh,   r,  0,0,ncomp,nghost);
+
+    sol.setVal(0);
+
+    Real rnorm = norm_inf(r);
+    const Real rnorm0   = rnorm;
+
+    if ( verbose > 0 )
+    {
+        amrex::Print() << "MLCGSolver_PipeBiCGStab: Initial error (error0) =        " << rnorm0 << '\n';
+    }
+    int ret = 0;
+    iter = 1;
+
+    if ( rnorm0 == 0 || rnorm0 < eps_abs )
+    {
+        if ( verbose > 0 )
+        {
+            amrex::Print() << "MLCGSolver_PipeBiCGStab: niter = 0,"
+                           << ", rnorm = " << rnorm
+                           << ", eps_abs = " << eps_abs << std::endl;
+        }
+        return ret;
+    }
+
+    // w = A r and t = A w.  The recurrences keep s = A p, z = A s, y = A q and v = A z.
+    Lp.apply(amrlev, mglev, w, r, MLLinOp::BCMode::Homogeneous, MLLinOp::StateMode::Correction);
+    Lp.normalize(amrlev, mglev, w);
+    Lp.apply(amrlev, mglev, t, w, MLLinOp::BCMode::Homogeneous, MLLinOp::StateMode::Correction);
+    Lp.normalize(amrlev, mglev, t);
+
+    Real rho = dotxy(rh,r);
+    Real alpha;
+    {
+        const Real rhTw = dotxy(rh,w);
+        if ( rho == 0 || rhTw == 0.0_rt ) {
+            ret = 1;
+            alpha = 0.0;
+        } else {
+            alpha = rho/rhTw;
+        }
+    }
+    Real beta = 0, omega = 0;
+    NonBlockingReduce reduce;
+
+    for (; ret == 0 && iter <= maxiter; ++iter)
+    {
+        if (iter == 1)
+        {
+            MultiFab::Copy(p,r,0,0,ncomp,nghost);
+            MultiFab::Copy(s,w,0,0,ncomp,nghost);
+            MultiFab::Copy(z,t,0,0,ncomp,nghost);
+        }
+        else
+        {
+            sxay(p, p, -omega, s, nghost);
+            sxay(p, r,   beta, p, nghost);
+            sxay(s, s, -omega, z, nghost);
+            sxay(s, w,   beta, s, nghost);
+            sxay(z, z, -omega, v, nghost);
+            sxay(z, t,   beta, z, nghost);
+        }
+        sxay(q, r, -alpha, s, nghost);
+        sxay(y, w, -alpha, z, nghost);
+
+        // The first synchronization is overlapped with v = A z.
+        Real dots1[2] = { dotxy(q,y,true), dotxy(y,y,true) };
+        Real qnorm = norm_inf(q,true);
+        reduce.start(dots1, 2, &qnorm, Lp.BottomCommunicator());
+        Lp.apply(amrlev, mglev, v, z, MLLinOp::BCMode::Homogeneous, MLLinOp::StateMode::Correction);
+        Lp.normalize(amrlev, mglev, v);
+        reduce.wait();
+
+        if ( verbose > 2 )
+        {
+            amrex::Print() << "MLCGSolver_PipeBiCGStab: Half Iter "
+                           << std::setw(11) << iter
+                           << " rel. err. "
+                           << qnorm/(rnorm0) << '\n';
+        }
+
+        if ( qnorm < eps_rel*rnorm0 || qnorm < eps_abs )
+        {
+            sxay(sol, sol, alpha, p, nghost);
+            rnorm = qnorm;
+            break;
+        }
+
+        if ( dots1[1] == 0.0_rt ) { ret = 3; break; }
+        omega = dots1[0]/dots1[1];
+
+        sxay(sol, sol, alpha, p, nghost);
+        sxay(sol, sol, omega, q, nghost);
+        sxay(r, q, -omega, y, nghost);
+        sxay(t, t, -alpha, v, nghost);
+        sxay(w, y, -omega, t, nghost);
+
+        // The second synchronization is overlapped with t = A w.
+        Real dots2[4] = { dotxy(rh,r,true), dotxy(rh,w,true), dotxy(rh,s,true), dotxy(rh,z,true) };
+        rnorm = norm_inf(r,true);
+        reduce.start(dots2, 4, &rnorm, Lp.BottomCommunicator());
+        Lp.apply(amrlev, mglev, t, w, MLLinOp::BCMode::Homogeneous, MLLinOp::StateMode::Correction);
+        Lp.normalize(amrlev, mglev, t);
+        reduce.wait();
+
+        if ( verbose > 2 )
+        {
+            amrex::Print() << "MLCGSolver_PipeBiCGStab: Iteration "
+                           << std::setw(11) << iter
+                           << " rel. err. "
+                           << rnorm/(rnorm0) << '\n';
+        }
+
+        if ( rnorm < eps_rel*rnorm0 || rnorm < eps_abs ) break;
+
+        if ( omega == 0 ) { ret = 4; break; }
+        if ( rho == 0 ) { ret = 1; break; }
+        const Real rho_1 = rho;
+        rho = dots2[0];
+        beta = (alpha/omega)*(rho/rho_1);
+        const Real rhTs = dots2[1] + beta*dots2[2] - beta*omega*dots2[3];
+        if ( rhTs == 0.0_rt ) { ret = 2; break; }
+        alpha = rho/rhTs;
+    }
+
+    if (iter > maxiter) iter = maxiter;
+
+    if ( verbose > 0 )
+    {
+        amrex::Print() << "MLCGSolver_PipeBiCGStab: Final: Iteration "
+                       << std::setw(4) << iter
+                       << " rel. err. "
+                       << rnorm/(rnorm0) << '\n';
+    }
+
+    if ( ret == 0 && rnorm > eps_rel*rnorm0 && rnorm > eps_abs)
+    {
+        if ( verbose > 0 && ParallelDescriptor::IOProcessor() )
+            amrex::Warning("MLCGSolver_PipeBiCGStab:: failed to converge!");
+        ret = 8;
+    }
+
+    if ( ( ret == 0 || ret == 8 ) && (rnorm < rnorm0) )
+    {
+        sol.plus(sorig, 0, ncomp, nghost);
+    }
+    else
+    {
+        sol.setVal(0);
+        sol.plus(sorig, 0, ncomp, nghost);
+    }
+
+    return ret;
+}
+
 Real
 MLCGSolver::dotxy (const MultiFab& r, const MultiFab& z, bool local)
 {
@@ -234,30 +234,41 @@ MLCellABecLap::makeHypre (Hypre::Interface hypre_interface) const
     const BoxArray& ba = m_grids[0].back();
     const DistributionMapping& dm = m_dmap[0].back();
     const Geometry& geom = m_geom[0].back();
-    const auto& factory = *(m_factory[0].back());
     MPI_Comm comm = BottomCommunicator();
 
     auto hypre_solver = amrex::makeHypre(ba, dm, geom, comm, hypre_interface);
 
-    hypre_solver->setScalars(getAScalar(), getBScalar());
+    setHypreCoeffs(*hypre_solver);
+
+    return hypre_solver;
+}
+
+void
+MLCellABecLap::setHypreCoeffs (Hypre& hypre_solver) const
+{
+    const BoxArray& ba = m_grids[0].back();
+    const DistributionMapping& dm = m_dmap[0].back();
+    const auto& factory = *(m_factory[0].back());
+
+    hypre_solver.setScalars(getAScalar(), getBScalar());
 
     const int mglev = NMGLevels(0)-1;
     auto ac = getACoeffs(0, mglev);
     if (ac)
     {
-        hypre_solver->setACoeffs(*ac);
+        hypre_solver.setACoeffs(*ac);
     }
     else
     {
         MultiFab alpha(ba,dm,1,0,MFInfo(),factory);
         alpha.setVal(0.0);
-        hypre_solver->setACoeffs(alpha);
+        hypre_solver.setACoeffs(alpha);
     }
 
     auto bc = getBCoeffs(0, mglev);
     if (bc[0])
     {
-        hypre_solver->setBCoeffs(bc);
+        hypre_solver.setBCoeffs(bc);
     }
     else
     {
@@ -268,10 +279,8 @@ MLCellABecLap::makeHypre (Hypre::Interface hypre_interface) const
                               dm, 1, 0, MFInfo(), factory);
             beta[idim].setVal(1.0);
         }
-        hypre_solver->setBCoeffs(amrex::GetArrOfConstPtrs(beta));
+        hypre_solver.setBCoeffs(amrex::GetArrOfConstPtrs(beta));
     }
-
-    return hypre_solver;
 }
 #endif
 
@@ -440,19 +440,25 @@ MLCellLinOp::correctionResidual (int amrlev, int mglev, MultiFab& resid, MultiFa
 }
 
 void
-MLCellLinOp::applyBC (int amrlev, int mglev, MultiFab& in, BCMode bc_mode, StateMode,
+MLCellLinOp::applyBC (int amrlev, int mglev, MultiFab& in, BCMode bc_mode, StateMode s_mode,
                       const MLMGBndry* bndry, bool skip_fillboundary) const
+{
+    applyBC(amrlev, mglev, in, bc_mode, s_mode, bndry, skip_fillboundary, 0, getNComp());
+}
+
+void
+MLCellLinOp::applyBC (int amrlev, int mglev, MultiFab& in, BCMode bc_mode, StateMode,
+                      const MLMGBndry* bndry, bool skip_fillboundary, int scomp, int ncomp) const
 {
     BL_PROFILE("MLCellLinOp::applyBC()");
     // No coarsened boundary values, cannot apply inhomog at mglev>0.
     BL_ASSERT(mglev == 0 || bc_mode == BCMode::Homogeneous);
     BL_ASSERT(bndry != nullptr || bc_mode == BCMode::Homogeneous);
 
-    const int ncomp = getNComp();
     const int cross = isCrossStencil();
     const int tensorop = isTensorOp();
     if (!skip_fillboundary) {
-        in.FillBoundary(0, ncomp, m_geom[amrlev][mglev].periodicity(),cross);
+        in.FillBoundary(scomp, ncomp, m_geom[amrlev][mglev].periodicity(),cross);
     }
 
     int flagbc = bc_mode == BCMode::Inhomogeneous;
@@ -466,7 +472,7 @@ MLCellLinOp::applyBC (int amrlev, int mglev, MultiFab& in, BCMode bc_mode, State
     const auto& maskvals = m_maskvals[amrlev][mglev];
     const auto& bcondloc = *m_bcondloc[amrlev][mglev];
 
-    FArrayBox foofab(Box::TheUnitBox(),ncomp);
+    FArrayBox foofab(Box::TheUnitBox(),getNComp());
     const auto& foo = foofab.array();
 
     MFItInfo mfi_info;
@@ -499,7 +505,7 @@ MLCellLinOp::applyBC (int amrlev, int mglev, MultiFab& in, BCMode bc_mode, State
                 const auto& mhi = maskvals[ohi].array(mfi);
                 const auto& bvlo = (bndry != nullptr) ? bndry->bndryValues(olo).array(mfi) : foo;
                 const auto& bvhi = (bndry != nullptr) ? bndry->bndryValues(ohi).array(mfi) : foo;
-                for (int icomp = 0; icomp < ncomp; ++icomp) {
+                for (int icomp = scomp; icomp < scomp+ncomp; ++icomp) {
                     const BoundCond bctlo = bdcv[icomp][olo];
                     const BoundCond bcthi = bdcv[icomp][ohi];
                     const Real bcllo = bdlv[icomp][olo];
@@ -547,6 +553,7 @@ MLCellLinOp::applyBC (int amrlev, int mglev, MultiFab& in, BCMode bc_mode, State
         else
         {
 #ifndef BL_NO_FORT
+            AMREX_ASSERT(scomp == 0 && ncomp == getNComp());
             const RealTuple & bdl = bdlv[0];
             const BCTuple   & bdc = bdcv[0];
 
@@ -53,6 +53,7 @@ MLMG::solve (const Vector<MultiFab*>& a_sol, const Vector<MultiFab const*>& a_rh
              Real a_tol_rel, Real a_tol_abs, const char* checkpoint_file)
 {
     BL_PROFILE("MLMG::solve()");
+    BL_PROFILE_REGION("MLMG::solve");
 
     if (checkpoint_file != nullptr) {
         checkPoint(a_sol, a_rhs, a_tol_rel, a_tol_abs, checkpoint_file);
@@ -62,7 +63,7 @@ MLMG::solve (const Vector<MultiFab*>& a_sol, const Vector<MultiFab const*>& a_rh
         bottom_solver = linop.getDefaultBottomSolver();
     }
 
-    if (bottom_solver == BottomSolver::hypre) {
+    if (bottom_solver == BottomSolver::hypre || bottom_solver == BottomSolver::amg) {
         int mo = linop.getMaxOrder();
         linop.setMaxOrder(std::min(3,mo));  // maxorder = 4 not supported
     }
@@ -76,7 +77,12 @@ MLMG::solve (const Vector<MultiFab*>& a_sol, const Vector<MultiFab const*>& a_rh
     m_niters_cg.clear();
     m_iter_fine_resnorm0.clear();
 
-    prepareForSolve(a_sol, a_rhs);
+    {
+        BL_PROFILE_REGION("MLMG::setup");
+        Real setup_start_time = amrex::second();
+        prepareForSolve(a_sol, a_rhs);
+        timer[setup_time] = amrex::second() - setup_start_time;
+    }
 
     computeMLResidual(finest_amr_lev);
 
@@ -109,7 +115,46 @@ MLMG::solve (const Vector<MultiFab*>& a_sol, const Vector<MultiFab const*>& a_rh
     }
     const Real res_target = std::max(a_tol_abs, std::max(a_tol_rel,1.e-16_rt)*max_norm);
 
-    if (!is_nsolve && resnorm0 <= res_target) {
+    // In a batched solve each component has its own target, relative to its
+    // own rhs or initial residual, and the solve stops when all have met it.
+    const bool per_comp = m_per_comp_convergence && !is_nsolve;
+    Vector<Real> res_target_comp;
+    auto all_converged = [&] (Vector<Real> const& norms) -> bool {
+        for (int n = 0; n < ncomp; ++n) {
+            if (norms[n] > res_target_comp[n]) return false;
+        }
+        return true;
+    };
+    if (per_comp) {
+        const Vector<Real> resnorm0_comp = MLResNormInfComps(finest_amr_lev);
+        const Vector<Real> rhsnorm0_comp = MLRhsNormInfComps();
+        res_target_comp.resize(ncomp);
+        m_niters_comp.assign(ncomp, -1);
+        for (int n = 0; n < ncomp; ++n) {
+            const Real max_norm_comp = (always_use_bnorm or rhsnorm0_comp[n] >= resnorm0_comp[n])
+                ? rhsnorm0_comp[n] : resnorm0_comp[n];
+            res_target_comp[n] = std::max(a_tol_abs, std::max(a_tol_rel,1.e-16_rt)*max_norm_comp);
+            if (resnorm0_comp[n] <= res_target_comp[n]) m_niters_comp[n] = 0;
+        }
+        m_final_resnorm_comp = resnorm0_comp;
+    }
+
+    // With one AMR level, a component that has converged is left alone, as
+    // in a sequential solve.  Its residual is set to zero, so its correction
+    // is zero, and the smoother skips it.
+    const bool freeze_comps = per_comp && namrlevs == 1;
+    auto freeze_converged = [&] () {
+        Vector<int> active(ncomp, 1);
+        for (int n = 0; n < ncomp; ++n) {
+            if (m_niters_comp[n] >= 0) {
+                active[n] = 0;
+                res[finest_amr_lev][0].setVal(0.0, n, 1, 0);
+            }
+        }
+        linop.setActiveComps(active);
+    };
+
+    if (!is_nsolve && (per_comp ? all_converged(m_final_resnorm_comp) : resnorm0 <= res_target)) {
         composite_norminf = resnorm0;
         if (verbose >= 1) {
             amrex::Print() << "MLMG: No iterations needed\n";
@@ -118,6 +163,8 @@ MLMG::solve (const Vector<MultiFab*>& a_sol, const Vector<MultiFab const*>& a_rh
         Real iter_start_time = amrex::second();
         bool converged = false;
 
+        if (freeze_comps) freeze_converged();
+
         const int niters = do_fixed_number_of_iters ? do_fixed_number_of_iters : max_iters;
         for (int iter = 0; iter < niters; ++iter)
         {
@@ -130,27 +177,58 @@ MLMG::solve (const Vector<MultiFab*>& a_sol, const Vector<MultiFab const*>& a_rh
 
             if (is_nsolve) continue;
 
-            Real fine_norminf = ResNormInf(finest_amr_lev);
+            Real fine_norminf;
+            bool fine_converged;
+            int nconverged = 0;
+            if (per_comp) {
+                m_final_resnorm_comp = ResNormInfComps(finest_amr_lev);
+                fine_norminf = *std::max_element(m_final_resnorm_comp.begin(),
+                                                 m_final_resnorm_comp.end());
+                for (int n = 0; n < ncomp; ++n) {
+                    if (m_final_resnorm_comp[n] <= res_target_comp[n]) {
+                        if (m_niters_comp[n] < 0) m_niters_comp[n] = iter+1;
+                        ++nconverged;
+                    }
+                }
+                fine_converged = (nconverged == ncomp);
+                if (freeze_comps && !fine_converged) freeze_converged();
+            } else {
+                fine_norminf = ResNormInf(finest_amr_lev);
+                fine_converged = (fine_norminf <= res_target);
+            }
             m_iter_fine_resnorm0.push_back(fine_norminf);
             composite_norminf = fine_norminf;
             if (verbose >= 2) {
                 amrex::Print() << "MLMG: Iteration " << std::setw(3) << iter+1 << " Fine resid/"
-                               << norm_name << " = " << fine_norminf/max_norm << "\n";
+                               << norm_name << " = " << fine_norminf/max_norm;
+                if (per_comp) {
+                    amrex::Print() << ", " << nconverged << " of " << ncomp << " converged";
+                }
+                amrex::Print() << "\n";
             }
-            bool fine_converged = (fine_norminf <= res_target);
 
             if (namrlevs == 1 and fine_converged) {
                 converged = true;
             } else if (fine_converged) {
                 // finest level is converged, but we still need to test the coarse levels
                 computeMLResidual(finest_amr_lev-1);
-                Real crse_norminf = MLResNormInf(finest_amr_lev-1);
+                Real crse_norminf;
+                if (per_comp) {
+                    const Vector<Real> crse_norms = MLResNormInfComps(finest_amr_lev-1);
+                    crse_norminf = *std::max_element(crse_norms.begin(), crse_norms.end());
+                    for (int n = 0; n < ncomp; ++n) {
+                        m_final_resnorm_comp[n] = std::max(m_final_resnorm_comp[n], crse_norms[n]);
+                    }
+                    converged = all_converged(crse_norms);
+                } else {
+                    crse_norminf = MLResNormInf(finest_amr_lev-1);
+                    converged = (crse_norminf <= res_target);
+                }
                 if (verbose >= 2) {
                     amrex::Print() << "MLMG: Iteration " << std::setw(3) << iter+1
                                    << " Crse resid/" << norm_name << " = "
                                    << crse_norminf/max_norm << "\n";
                 }
-                converged = (crse_norminf <= res_target);
                 composite_norminf = std::max(fine_norminf, crse_norminf);
             } else {
                 converged = false;
@@ -187,6 +265,7 @@ MLMG::solve (const Vector<MultiFab*>& a_sol, const Vector<MultiFab const*>& a_rh
             }
             amrex::Abort("MLMG failed");
         }
+        if (freeze_comps) linop.setActiveComps(Vector<int>());
         timer[iter_time] = amrex::second() - iter_start_time;
     }
 
@@ -206,6 +285,7 @@ MLMG::solve (const Vector<MultiFab*>& a_sol, const Vector<MultiFab const*>& a_rh
         if (ParallelContext::MyProcSub() == 0)
         {
             amrex::AllPrint() << "MLMG: Timers: Solve = " << timer[solve_time]
+                              << " Setup = " << timer[setup_time]
                               << " Iter = " << timer[iter_time]
                               << " Bottom = " << timer[bottom_time] << "\n";
         }
@@ -943,12 +1023,27 @@ MLMG::actualBottomSolve ()
         {
             bottomSolveWithPETSc(x, *bottom_b);
         }
+        else if (bottom_solver == BottomSolver::amg)
+        {
+            int ret = bottomSolveWithAMG(x, *bottom_b);
+            if (ret != 0) {
+                cor[amrlev][mglev]->setVal(0.0);
+            }
+            const int n = (ret==0) ? nub : nuf;
+            for (int i = 0; i < n; ++i) {
+                linop.smooth(amrlev, mglev, x, b);
+            }
+        }
         else
         {
             MLCGSolver::Type cg_type;
             if (bottom_solver == BottomSolver::cg ||
                 bottom_solver == BottomSolver::cgbicg) {
                 cg_type = MLCGSolver::Type::CG;
+            } else if (bottom_solver == BottomSolver::pipecg) {
+                cg_type = MLCGSolver::Type::PipeCG;
+            } else if (bottom_solver == BottomSolver::pipebicgstab) {
+                cg_type = MLCGSolver::Type::PipeBiCGStab;
             } else {
                 cg_type = MLCGSolver::Type::BiCGStab;
             }
@@ -1004,14 +1099,53 @@ MLMG::bottomSolveWithCG (MultiFab& x, const MultiFab& b, MLCGSolver::Type type)
     return ret;
 }
 
+int
+MLMG::bottomSolveWithAMG (MultiFab& x, const MultiFab& b)
+{
+    if (amg_solver == nullptr)  // The hierarchy is reused until the operator changes
+    {
+        amg_solver.reset(new MLAMGSolver(linop));
+        amg_solver->setNumSweeps(amg_num_sweeps);
+        amg_solver->setStrongThreshold(amg_strong_threshold);
+        amg_solver->setMaxCoarseSize(amg_max_coarse_size);
+        amg_solver->setMaxBottomSize(amg_max_bottom_size);
+    }
+    amg_solver->setVerbose(bottom_verbose);
+    amg_solver->setMaxIter(bottom_maxiter);
+
+    int ret = amg_solver->solve(x, b, bottom_reltol, bottom_abstol);
+    if (ret != 0 && verbose > 1) {
+        amrex::Print() << "MLMG: Bottom solve failed.\n";
+    }
+    m_niters_cg.push_back(amg_solver->getNumIters());
+
+    // For singular problems the correction is only defined up to a constant
+    if (linop.isBottomSingular())
+    {
+        const int amrlev = 0;
+        const int mglev  = linop.NMGLevels(amrlev) - 1;
+        makeSolvable(amrlev, mglev, x);
+    }
+    return ret;
+}
+
 // Compute single-level masked inf-norm of Residual (res).
 Real
 MLMG::ResNormInf (int alev, bool local)
+{
+    const Vector<Real> norms = ResNormInfComps(alev, true);
+    Real norm = *std::max_element(norms.begin(), norms.end());
+    if (!local) ParallelAllReduce::Max(norm, ParallelContext::CommunicatorSub());
+    return norm;
+}
+
+Vector<Real>
+MLMG::ResNormInfComps (int alev, bool local)
 {
     BL_PROFILE("MLMG::ResNormInf()");
     const int ncomp = linop.getNComp();
     const int mglev = 0;
-    Real norm = 0.0;
+    Vector<Real> norms(ncomp, 0.0);
     MultiFab* pmf = &(res[alev][mglev]);
 #ifdef AMREX_USE_EB
     if (linop.isCellCentered() && scratch[alev]) {
@@ -1030,39 +1164,59 @@ MLMG::ResNormInf (int alev, bool local)
 #endif
     for (int n = 0; n < ncomp; n++)
     {
-	Real newnorm = 0.0;
 	if (fine_mask[alev]) {
-            newnorm = pmf->norm0(*fine_mask[alev],n,0,true);
+            norms[n] = pmf->norm0(*fine_mask[alev],n,0,true);
 	} else {
-            newnorm = pmf->norm0(n,0,true);
+            norms[n] = pmf->norm0(n,0,true);
 	}
-        norm = std::max(norm, newnorm);
     }
-    if (!local) ParallelAllReduce::Max(norm, ParallelContext::CommunicatorSub());
-    return norm;
+    if (!local) ParallelAllReduce::Max(norms.data(), ncomp, ParallelContext::CommunicatorSub());
+    return norms;
 }
 
 // Computes multi-level masked inf-norm of Residual (res).
 Real
 MLMG::MLResNormInf (int alevmax, bool local)
+{
+    const Vector<Real> norms = MLResNormInfComps(alevmax, true);
+    Real r = *std::max_element(norms.begin(), norms.end());
+    if (!local) ParallelAllReduce::Max(r, ParallelContext::CommunicatorSub());
+    return r;
+}
+
+Vector<Real>
+MLMG::MLResNormInfComps (int alevmax, bool local)
 {
     BL_PROFILE("MLMG::MLResNormInf()");
-    Real r = 0.0;
+    const int ncomp = linop.getNComp();
+    Vector<Real> r(ncomp, 0.0);
     for (int alev = 0; alev <= alevmax; ++alev)
     {
-        r = std::max(r, ResNormInf(alev,true));
+        const Vector<Real> norms = ResNormInfComps(alev,true);
+        for (int n = 0; n < ncomp; ++n) {
+            r[n] = std::max(r[n], norms[n]);
+        }
     }
-    if (!local) ParallelAllReduce::Max(r, ParallelContext::CommunicatorSub());
+    if (!local) ParallelAllReduce::Max(r.data(), ncomp, ParallelContext::CommunicatorSub());
     return r;
 }
 
 // Compute multi-level masked inf-norm of RHS (rhs).
 Real
 MLMG::MLRhsNormInf (bool local)
+{
+    const Vector<Real> norms = MLRhsNormInfComps(true);
+    Real r = *std::max_element(norms.begin(), norms.end());
+    if (!local) ParallelAllReduce::Max(r, ParallelContext::CommunicatorSub());
+    return r;
+}
+
+Vector<Real>
+MLMG::MLRhsNormInfComps (bool local)
 {
     BL_PROFILE("MLMG::MLRhsNormInf()");
     const int ncomp = linop.getNComp();
-    Real r = 0.0;
+    Vector<Real> r(ncomp, 0.0);
     for (int alev = 0; alev <= finest_amr_lev; ++alev)
     {
         MultiFab* pmf = &(rhs[alev]);
@@ -1084,13 +1238,13 @@ MLMG::MLRhsNormInf (bool local)
         for (int n=0; n<ncomp; ++n)
         {
             if (alev < finest_amr_lev) {
-                r = std::max(r, pmf->norm0(*fine_mask[alev],n,0,true));
+                r[n] = std::max(r[n], pmf->norm0(*fine_mask[alev],n,0,true));
             } else {
-                r = std::max(r, pmf->norm0(n,0,true));
+                r[n] = std::max(r[n], pmf->norm0(n,0,true));
             }
         }
     }
-    if (!local) ParallelAllReduce::Max(r, ParallelContext::CommunicatorSub());
+    if (!local) ParallelAllReduce::Max(r.data(), ncomp, ParallelContext::CommunicatorSub());
     return r;
 }
 
@@ -1137,11 +1291,18 @@ MLMG::prepareForSolve (const Vector<MultiFab*>& a_sol, const Vector<MultiFab con
         linop.prepareForSolve();
         linop_prepared = true;
     } else if (linop.needsUpdate()) {
+        // Only the coefficients have changed.  The hierarchy and the
+        // boundary objects of the operator are kept, and so is the setup of
+        // the bottom solvers that can take new coefficients.
         linop.update();
 
 #ifdef AMREX_USE_HYPRE
-        hypre_solver.reset();
-        hypre_bndry.reset();
+        if (hypre_solver && hypre_solver->canUpdateCoeffs()) {
+            linop.setHypreCoeffs(*hypre_solver);
+        } else {
+            hypre_solver.reset();
+            hypre_bndry.reset();
+        }
         hypre_node_solver.reset();
 #endif
 
@@ -1149,6 +1310,8 @@ MLMG::prepareForSolve (const Vector<MultiFab*>& a_sol, const Vector<MultiFab con
         petsc_solver.reset(); 
         petsc_bndry.reset(); 
 #endif
+
+        if (amg_solver) amg_solver->updateOperator();
     }
 
     sol.resize(namrlevs);
@@ -1343,6 +1506,21 @@ MLMG::prepareForNSolve ()
     ns_mlmg->setBottomSolver(BottomSolver::smoother);
 }
 
+Real
+MLMG::solveBatched (const Vector<MultiFab*>& a_sol, const Vector<MultiFab const*>& a_rhs,
+                    Real a_tol_rel, Real a_tol_abs)
+{
+    BL_PROFILE("MLMG::solveBatched()");
+
+    AMREX_ALWAYS_ASSERT_WITH_MESSAGE(a_rhs[0]->nComp() == linop.getNComp(),
+                                     "MLMG::solveBatched: the number of components of rhs and of the operator differ");
+
+    m_per_comp_convergence = true;
+    Real r = solve(a_sol, a_rhs, a_tol_rel, a_tol_abs);
+    m_per_comp_convergence = false;
+    return r;
+}
+
 void
 MLMG::getGradSolution (const Vector<Array<MultiFab*,AMREX_SPACEDIM> >& a_grad_sol,
                        Location a_loc)
@@ -338,6 +338,29 @@ MLNodeLinOp::setDirichletMask (int amrlev, const iMultiFab& a_dmask)
     m_overset_dirichlet_mask = true;
 }
 
+void
+MLNodeLinOp::fillBottomDofMask (iMultiFab& mask) const
+{
+    // The nodes shared by several boxes are owned by one of them, and the
+    // Dirichlet nodes are not unknowns.
+    const iMultiFab& omask = *m_owner_mask[0].back();
+    const iMultiFab& dmask = *m_dirichlet_mask[0].back();
+#ifdef _OPENMP
+#pragma omp parallel if (Gpu::notInLaunchRegion())
+#endif
+    for (MFIter mfi(mask,TilingIfNotGPU()); mfi.isValid(); ++mfi)
+    {
+        const Box& bx = mfi.tilebox();
+        Array4<int> const& m = mask.array(mfi);
+        Array4<int const> const& o = omask.const_array(mfi);
+        Array4<int const> const& d = dmask.const_array(mfi);
+        AMREX_HOST_DEVICE_PARALLEL_FOR_3D (bx, i, j, k,
+        {
+            m(i,j,k) = (o(i,j,k) && !d(i,j,k)) ? 1 : 0;
+        });
+    }
+}
+
 void
 MLNodeLinOp::applyBC (int amrlev, int mglev, MultiFab& phi, BCMode/* bc_mode*/, StateMode,
                       bool skip_fillboundary) const
@@ -93,16 +93,29 @@ MLTensorOp::define (const Vector<Geometry>& a_geom,
     }
 }
 
+// The b coefficients keep a component for each velocity component, because
+// prepareForSolve adds the bulk viscosity to one of them on each face.
 void
 MLTensorOp::setShearViscosity (int amrlev, const Array<MultiFab const*,AMREX_SPACEDIM>& eta)
 {
-    MLABecLaplacian::setBCoeffs(amrlev, eta);
+    const int ncomp_eta = eta[0]->nComp();
+    AMREX_ALWAYS_ASSERT(ncomp_eta == 1 or ncomp_eta == AMREX_SPACEDIM);
+    for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+        for (int icomp = 0; icomp < AMREX_SPACEDIM; ++icomp) {
+            MultiFab::Copy(m_b_coeffs[amrlev][0][idim], *eta[idim],
+                           (ncomp_eta == 1) ? 0 : icomp, icomp, 1, 0);
+        }
+    }
+    m_needs_update = true;
 }
 
 void
 MLTensorOp::setShearViscosity (int amrlev, Real eta)
 {
-    MLABecLaplacian::setBCoeffs(amrlev, eta);
+    for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+        m_b_coeffs[amrlev][0][idim].setVal(eta);
+    }
+    m_needs_update = true;
 }
 
 void
@@ -166,6 +166,18 @@ NodalProjector::setOptions ()
     {
         m_mlmg->setBottomSolver(MLMG::BottomSolver::cgbicg);
     }
+    else if (bottom_solver == "pipecg")
+    {
+        m_mlmg->setBottomSolver(MLMG::BottomSolver::pipecg);
+    }
+    else if (bottom_solver == "pipebicg")
+    {
+        m_mlmg->setBottomSolver(MLMG::BottomSolver::pipebicgstab);
+    }
+    else if (bottom_solver == "amg")
+    {
+        m_mlmg->setBottomSolver(MLMG::BottomSolver::amg);
+    }
 #ifdef AMREX_USE_HYPRE
     else if (bottom_solver == "hypre")
     {
@@ -0,0 +1,301 @@
+
+#include <algorithm>
+#include <fstream>
+#include <numeric>
+#include <sstream>
+
+#include <AMReX_ColumnarParticleIO.H>
+#include <AMReX_ParallelDescriptor.H>
+#include <AMReX_Utility.H>
+#include <AMReX_VisMF.H>
+
+namespace amrex {
+namespace ColumnarParticleIO {
+
+namespace {
+    constexpr Long chunk_size = 256*1024*1024;
+}
+
+const std::string&
+ColumnarVersion ()
+{
+    static const std::string version("Version_Columnar_One_Dot_Zero");
+    return version;
+}
+
+WriterGroup
+MakeWriterGroup (int ranks_per_writer)
+{
+    WriterGroup group;
+#ifdef BL_USE_MPI
+    const int myproc = ParallelDescriptor::MyProc();
+    if (ranks_per_writer > 0) {
+        BL_MPI_REQUIRE( MPI_Comm_split(ParallelDescriptor::Communicator(),
+                                       myproc / ranks_per_writer, myproc, &group.comm) );
+    } else {
+        BL_MPI_REQUIRE( MPI_Comm_split_type(ParallelDescriptor::Communicator(),
+                                            MPI_COMM_TYPE_SHARED, myproc,
+                                            MPI_INFO_NULL, &group.comm) );
+    }
+    BL_MPI_REQUIRE( MPI_Comm_rank(group.comm, &group.rank) );
+    BL_MPI_REQUIRE( MPI_Comm_size(group.comm, &group.size) );
+    group.writer = myproc;
+    BL_MPI_REQUIRE( MPI_Bcast(&group.writer, 1, MPI_INT, 0, group.comm) );
+#else
+    amrex::ignore_unused(ranks_per_writer);
+    group.comm = 0;
+#endif
+    return group;
+}
+
+void
+FreeWriterGroup (WriterGroup& group)
+{
+#ifdef BL_USE_MPI
+    BL_MPI_REQUIRE( MPI_Comm_free(&group.comm) );
+#else
+    amrex::ignore_unused(group);
+#endif
+}
+
+Long
+WriteAggregated (const WriterGroup& group, const char* data, Long nbytes,
+                 const std::string& file_name)
+{
+    Long offset = 0;
+    Vector<Long> nbytes_in_group(group.size, nbytes);
+#ifdef BL_USE_MPI
+    if (group.size > 1) {
+        const MPI_Datatype long_type = ParallelDescriptor::Mpi_typemap<Long>::type();
+        BL_MPI_REQUIRE( MPI_Gather(&nbytes, 1, long_type, nbytes_in_group.data(), 1, long_type,
+                                   0, group.comm) );
+        BL_MPI_REQUIRE( MPI_Exscan(&nbytes, &offset, 1, long_type, MPI_SUM, group.comm) );
+        if (group.rank == 0) offset = 0;
+    }
+#endif
+
+    if (group.rank == 0)
+    {
+        const Long total = std::accumulate(nbytes_in_group.begin(), nbytes_in_group.end(), Long(0));
+        if (total == 0) return offset;
+
+        VisMF::IO_Buffer io_buffer(VisMF::GetIOBufferSize());
+        std::ofstream ofs;
+        ofs.rdbuf()->pubsetbuf(io_buffer.dataPtr(), io_buffer.size());
+        ofs.open(file_name.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+        if (!ofs.good()) amrex::FileOpenFailed(file_name);
+
+        ofs.write(data, nbytes);
+#ifdef BL_USE_MPI
+        // ---- Receive the data of the others one chunk at a time.
+        Vector<char> buf;
+        for (int r = 1; r < group.size; ++r) {
+            for (Long left = nbytes_in_group[r]; left > 0; ) {
+                const Long n = std::min(left, chunk_size);
+                buf.resize(n);
+                BL_MPI_REQUIRE( MPI_Recv(buf.data(), n, MPI_CHAR, r, 0, group.comm,
+                                         MPI_STATUS_IGNORE) );
+                ofs.write(buf.data(), n);
+                left -= n;
+            }
+        }
+#endif
+        ofs.close();
+        if (!ofs.good()) amrex::Abort("ColumnarParticleIO: failed to write " + file_name);
+    }
+#ifdef BL_USE_MPI
+    else
+    {
+        for (Long pos = 0; pos < nbytes; pos += chunk_size) {
+            const Long n = std::min(nbytes-pos, chunk_size);
+            BL_MPI_REQUIRE( MPI_Send(const_cast<char*>(data+pos), n, MPI_CHAR, 0, 0, group.comm) );
+        }
+    }
+#endif
+
+    return offset;
+}
+
+}
+
+namespace {
+    int CompIndex (const Vector<std::string>& names, const std::string& name)
+    {
+        auto it = std::find(names.begin(), names.end(), name);
+        if (it == names.end()) {
+            amrex::Abort("ColumnarParticleReader: unknown component " + name);
+        }
+        return it - names.begin();
+    }
+}
+
+ColumnarParticleReader::ColumnarParticleReader (const std::string& dir)
+    : m_dir(dir)
+{
+    if (!m_dir.empty() && m_dir[m_dir.size()-1] == '/') m_dir.pop_back();
+
+    std::string HdrFileName = m_dir + "/Header";
+    std::ifstream HdrFile(HdrFileName.c_str());
+    if (!HdrFile.good()) amrex::FileOpenFailed(HdrFileName);
+
+    std::string version;
+    HdrFile >> version;
+    if (version.find(ColumnarParticleIO::ColumnarVersion()) == std::string::npos) {
+        amrex::Abort("ColumnarParticleReader: " + HdrFileName + " is not in the columnar format");
+    }
+    m_single = version.find("_single") != std::string::npos;
+
+    int dm;
+    HdrFile >> dm;
+    if (dm != AMREX_SPACEDIM) {
+        amrex::Abort("ColumnarParticleReader: dm != AMREX_SPACEDIM");
+    }
+
+    int nr;
+    HdrFile >> nr;
+    m_real_names.resize(nr);
+    for (auto& name : m_real_names) HdrFile >> name;
+
+    int ni;
+    HdrFile >> ni;
+    m_int_names.resize(ni+2);
+    m_int_names[0] = "id";
+    m_int_names[1] = "cpu";
+    for (int i = 0; i < ni; ++i) HdrFile >> m_int_names[i+2];
+
+    bool checkpoint;
+    int maxnextid, finest_level;
+    HdrFile >> checkpoint >> m_nparticles >> maxnextid >> finest_level;
+
+    Vector<int> ngrids(finest_level+1);
+    for (auto& n : ngrids) HdrFile >> n;
+
+    m_which.resize(finest_level+1);
+    m_count.resize(finest_level+1);
+    m_where.resize(finest_level+1);
+    m_grid_box.resize(finest_level+1);
+    for (int lev = 0; lev <= finest_level; ++lev) {
+        m_which[lev].resize(ngrids[lev]);
+        m_count[lev].resize(ngrids[lev]);
+        m_where[lev].resize(ngrids[lev]);
+        m_grid_box[lev].resize(ngrids[lev]);
+        for (int k = 0; k < ngrids[lev]; ++k) {
+            Real lo[AMREX_SPACEDIM], hi[AMREX_SPACEDIM];
+            HdrFile >> m_which[lev][k] >> m_count[lev][k] >> m_where[lev][k];
+            for (int d = 0; d < AMREX_SPACEDIM; ++d) HdrFile >> lo[d];
+            for (int d = 0; d < AMREX_SPACEDIM; ++d) HdrFile >> hi[d];
+            m_grid_box[lev][k] = RealBox(lo, hi);
+        }
+    }
+
+    if (!HdrFile.good()) {
+        amrex::Abort("ColumnarParticleReader: problem reading " + HdrFileName);
+    }
+}
+
+void
+ColumnarParticleReader::read (int lev, const RealBox& region,
+                              const Vector<std::string>& real_comps,
+                              const Vector<std::string>& int_comps, Data& data) const
+{
+    for (int grid = 0; grid < numGrids(lev); ++grid) {
+        readGrid(lev, grid, &region, real_comps, int_comps, data);
+    }
+}
+
+void
+ColumnarParticleReader::read (int lev, const Vector<std::string>& real_comps,
+                              const Vector<std::string>& int_comps, Data& data) const
+{
+    for (int grid = 0; grid < numGrids(lev); ++grid) {
+        readGrid(lev, grid, nullptr, real_comps, int_comps, data);
+    }
+}
+
+void
+ColumnarParticleReader::readGrid (int lev, int grid, const RealBox* region,
+                                  const Vector<std::string>& real_comps,
+                                  const Vector<std::string>& int_comps, Data& data) const
+{
+    data.pos.resize(AMREX_SPACEDIM);
+    data.real.resize(real_comps.size());
+    data.ints.resize(int_comps.size());
+
+    const Long n = m_count[lev][grid];
+    if (n == 0) return;
+    if (region != nullptr && !region->intersects(m_grid_box[lev][grid])) return;
+
+    std::string file_name = amrex::Concatenate(m_dir + "/Level_", lev, 1);
+    file_name = amrex::Concatenate(file_name + "/DATA_", m_which[lev][grid], 5);
+    std::ifstream ifs(file_name.c_str(), std::ios::in | std::ios::binary);
+    if (!ifs.good()) amrex::FileOpenFailed(file_name);
+
+    const Long real_size = m_single ? sizeof(float) : sizeof(double);
+    const Long real_start = m_where[lev][grid] + m_int_names.size() * n * sizeof(int);
+
+    auto read_ints = [&] (int col, Vector<int>& v)
+    {
+        v.resize(n);
+        ifs.seekg(m_where[lev][grid] + col * n * sizeof(int), std::ios::beg);
+        ifs.read(reinterpret_cast<char*>(v.data()), n * sizeof(int));
+    };
+
+    auto read_reals = [&] (int col, Vector<ParticleReal>& v)
+    {
+        v.resize(n);
+        ifs.seekg(real_start + col * n * real_size, std::ios::beg);
+        if (m_single) {
+            Vector<float> tmp(n);
+            ifs.read(reinterpret_cast<char*>(tmp.data()), n * real_size);
+            std::copy(tmp.begin(), tmp.end(), v.begin());
+        } else {
+            Vector<double> tmp(n);
+            ifs.read(reinterpret_cast<char*>(tmp.data()), n * real_size);
+            std::copy(tmp.begin(), tmp.end(), v.begin());
+        }
+    };
+
+    // ---- The positions are always read, to select the particles in the region.
+    Vector<Vector<ParticleReal> > pos(AMREX_SPACEDIM);
+    for (int d = 0; d < AMREX_SPACEDIM; ++d) {
+        read_reals(d, pos[d]);
+    }
+
+    Vector<char> keep(n, 1);
+    if (region != nullptr) {
+        for (Long i = 0; i < n; ++i) {
+            Real p[AMREX_SPACEDIM];
+            for (int d = 0; d < AMREX_SPACEDIM; ++d) p[d] = pos[d][i];
+            keep[i] = region->contains(p);
+        }
+    }
+
+    auto append = [&] (const auto& col, auto& dst)
+    {
+        for (Long i = 0; i < n; ++i) {
+            if (keep[i]) dst.push_back(col[i]);
+        }
+    };
+
+    for (int d = 0; d < AMREX_SPACEDIM; ++d) {
+        append(pos[d], data.pos[d]);
+    }
+
+    Vector<ParticleReal> rcol;
+    for (int i = 0, N = real_comps.size(); i < N; ++i) {
+        read_reals(AMREX_SPACEDIM + CompIndex(m_real_names, real_comps[i]), rcol);
+        append(rcol, data.real[i]);
+    }
+
+    Vector<int> icol;
+    for (int i = 0, N = int_comps.size(); i < N; ++i) {
+        read_ints(CompIndex(m_int_names, int_comps[i]), icol);
+        append(icol, data.ints[i]);
+    }
+
+    if (!ifs.good()) {
+        amrex::Abort("ColumnarParticleReader: problem reading " + file_name);
+    }
+}
+
+}
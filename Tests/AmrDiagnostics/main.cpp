@@ -0,0 +1,162 @@
+
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+#include <AMReX.H>
+#include <AMReX_AmrDiagnostics.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_Print.H>
+
+using namespace amrex;
+
+namespace {
+    //! The numbers on the lines of file_name that are not comments.  Words,
+    //! like the variable names of histograms, are skipped.
+    Vector<Vector<Real> > ReadLines (const std::string& file_name)
+    {
+        Vector<Vector<Real> > lines;
+        std::ifstream ifs(file_name.c_str());
+        if (!ifs.good()) amrex::FileOpenFailed(file_name);
+        std::string line;
+        while (std::getline(ifs, line)) {
+            if (line.empty() || line[0] == '#') continue;
+            std::istringstream is(line);
+            std::string word;
+            Vector<Real> values;
+            while (is >> word) {
+                if (word == "nan" || word == "-nan") {
+                    values.push_back(std::numeric_limits<Real>::quiet_NaN());
+                } else if (std::isdigit(word[0]) || word[0] == '-' || word[0] == '.') {
+                    values.push_back(std::stod(word));
+                }
+            }
+            lines.push_back(values);
+        }
+        return lines;
+    }
+
+    void Check (const std::string& what, Real result, Real expected)
+    {
+        if (std::abs(result - expected) > 1.e-12) {
+            amrex::Abort("AmrDiagnostics test: " + what + " is " + std::to_string(result)
+                         + " instead of " + std::to_string(expected));
+        }
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc, argv);
+    {
+        int n_cell = 32;
+        int max_grid_size = 16;
+        {
+            ParmParse pp;
+            pp.query("n_cell", n_cell);
+            pp.query("max_grid_size", max_grid_size);
+        }
+
+        RealBox rb({AMREX_D_DECL(0.,0.,0.)}, {AMREX_D_DECL(1.,1.,1.)});
+        Array<int,AMREX_SPACEDIM> is_periodic{AMREX_D_DECL(0,0,0)};
+        const Box domain0(IntVect(0), IntVect(n_cell-1));
+        const Box covered(IntVect(n_cell/4), IntVect(3*n_cell/4-1));
+
+        Vector<Geometry> geom{Geometry(domain0, rb, 0, is_periodic),
+                              Geometry(amrex::refine(domain0,2), rb, 0, is_periodic)};
+        Vector<BoxArray> grids{BoxArray(domain0), BoxArray(amrex::refine(covered,2))};
+        for (auto& ba : grids) ba.maxSize(max_grid_size);
+        Vector<IntVect> ref_ratio{IntVect(2)};
+
+        // Both variables are x, except that "x_bad" is a NaN and an infinity
+        // in two cells of level 0 that are not covered by level 1.
+        auto data = [&] (int lev) -> MultiFab
+        {
+            MultiFab mf(grids[lev], DistributionMapping(grids[lev]), 2, 0);
+            const auto problo = geom[lev].ProbLoArray();
+            const auto dx = geom[lev].CellSizeArray();
+            const int ihi = geom[lev].Domain().bigEnd(0);
+            for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
+                const auto a = mf.array(mfi);
+                amrex::ParallelFor(mfi.validbox(), [=] AMREX_GPU_DEVICE (int i, int j, int k) noexcept
+                {
+                    const Real x = problo[0] + (i+0.5)*dx[0];
+                    a(i,j,k,0) = x;
+                    a(i,j,k,1) = x;
+                    if (lev == 0 && j == 0 && k == 0) {
+                        if (i == 0) {
+                            a(i,j,k,1) = std::numeric_limits<Real>::quiet_NaN();
+                        } else if (i == ihi) {
+                            a(i,j,k,1) = std::numeric_limits<Real>::infinity();
+                        }
+                    }
+                });
+            }
+            Gpu::streamSynchronize();
+            return mf;
+        };
+
+        const int step = 7;
+        const Real time = 0.5;
+        const Real dv0 = std::pow(1.0/n_cell, AMREX_SPACEDIM);
+
+        AmrDiagnostic integral;
+        integral.name = "integral";
+        integral.type = AmrDiagnostic::VolumeIntegral;
+        integral.vars = {"x", "x_bad"};
+
+        AmrDiagnostic histogram = integral;
+        histogram.name = "histogram";
+        histogram.type = AmrDiagnostic::Histogram;
+        histogram.nbins = 4;
+        histogram.lo = 0.0;
+        histogram.hi = 1.0;
+
+        AmrDiagnostic average = integral;
+        average.name = "average";
+        average.type = AmrDiagnostic::PlanarAverage;
+        average.vars = {"x"};
+        average.dir = 0;
+
+        for (const auto& diag : {integral, histogram, average}) {
+            const std::string file_name = "diag_" + diag.name + ".dat";
+            if (ParallelDescriptor::IOProcessor()) std::remove(file_name.c_str());
+            diag.evaluate(geom, grids, ref_ratio, data, step, time, file_name);
+        }
+
+        if (ParallelDescriptor::IOProcessor())
+        {
+            // ---- step time x x_bad
+            auto lines = ReadLines("diag_integral.dat");
+            AMREX_ALWAYS_ASSERT(lines.size() == 1 && lines[0].size() == 4);
+            Check("step", lines[0][0], step);
+            Check("time", lines[0][1], time);
+            Check("integral of x", lines[0][2], 0.5);
+            AMREX_ALWAYS_ASSERT(std::isnan(lines[0][3]));
+
+            // ---- step time fractions, for x and for x_bad.  The NaN is not
+            // ---- counted, and the infinity is in the overflow bin.
+            lines = ReadLines("diag_histogram.dat");
+            AMREX_ALWAYS_ASSERT(lines.size() == 2 && lines[0].size() == 8);
+            const Vector<Real> expected_x{0.0, 0.25, 0.25, 0.25, 0.25, 0.0};
+            const Vector<Real> expected_bad{0.0, 0.25-dv0, 0.25, 0.25, 0.25-dv0, dv0};
+            for (int b = 0; b < 6; ++b) {
+                Check("histogram of x, bin " + std::to_string(b), lines[0][2+b], expected_x[b]);
+                Check("histogram of x_bad, bin " + std::to_string(b), lines[1][2+b], expected_bad[b]);
+            }
+
+            // ---- step time x-coordinate x
+            lines = ReadLines("diag_average.dat");
+            AMREX_ALWAYS_ASSERT(lines.size() == n_cell);
+            for (const auto& line : lines) {
+                Check("planar average of x", line[3], line[2]);
+            }
+
+            amrex::Print() << "AmrDiagnostics test passed\n";
+        }
+    }
+    amrex::Finalize();
+}
@@ -0,0 +1,102 @@
+#include <AMReX.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_Print.H>
+#include <AMReX_BArena.H>
+#include <AMReX_CArena.H>
+#include <AMReX_TArena.H>
+
+#include <iomanip>
+#include <memory>
+
+using namespace amrex;
+
+//
+// Many OpenMP threads allocating and freeing temporary FABs inside MFIter
+// loops, as kernels often do.  The time per alloc/free pair is compared for
+// BArena (malloc), CArena and TArena.
+//
+void main_main ()
+{
+    int n_cell = 128;
+    int max_grid_size = 64;
+    IntVect tile_size(1024000,8,8);
+    int ncomp = 4;
+    int nsteps = 20;
+    {
+        ParmParse pp;
+        pp.query("n_cell", n_cell);
+        pp.query("max_grid_size", max_grid_size);
+        Vector<int> ts;
+        if (pp.queryarr("tile_size", ts)) {
+            tile_size = IntVect(ts);
+        }
+        pp.query("ncomp", ncomp);
+        pp.query("nsteps", nsteps);
+    }
+
+    BoxArray ba(Box(IntVect(0), IntVect(n_cell-1)));
+    ba.maxSize(max_grid_size);
+    DistributionMapping dm(ba);
+    MultiFab mf(ba, dm, ncomp, 1);
+    mf.setVal(1.0);
+
+    amrex::Print() << "# of threads: " << OpenMP::get_max_threads()
+                   << ", tile size: " << tile_size << "\n\n";
+
+    std::unique_ptr<Arena> barena(new BArena);
+    std::unique_ptr<Arena> carena(new CArena);
+    std::unique_ptr<TArena> tarena(new TArena);
+
+    const std::vector<std::pair<std::string,Arena*> > arenas
+        {{"BArena", barena.get()}, {"CArena", carena.get()}, {"TArena", tarena.get()}};
+
+    amrex::Print() << std::setw(8) << "arena"
+                   << std::setw(22) << "same size (us/pair)"
+                   << std::setw(22) << "mixed sizes (us/pair)" << "\n";
+
+    for (auto const& a : arenas)
+    {
+        Arena* ar = a.second;
+        double t[2];
+        for (int mixed = 0; mixed < 2; ++mixed)
+        {
+            Long npairs = 0;
+            // warm up
+            for (int step = -1; step < nsteps; ++step)
+            {
+                if (step == 0) {
+                    npairs = 0;
+                    t[mixed] = amrex::second();
+                }
+#ifdef _OPENMP
+#pragma omp parallel reduction(+:npairs)
+#endif
+                for (MFIter mfi(mf,tile_size); mfi.isValid(); ++mfi)
+                {
+                    const Box& bx = mfi.growntilebox(1);
+                    const int nc = mixed ? 1 + (mfi.LocalTileIndex() % ncomp) : ncomp;
+                    FArrayBox tmp(bx, nc, ar);
+                    tmp.dataPtr()[0] = mf[mfi].dataPtr()[0];
+                    FArrayBox tmp2(mfi.tilebox(), 1, ar);
+                    tmp2.dataPtr()[0] = tmp.dataPtr()[0];
+                    npairs += 2;
+                }
+            }
+            t[mixed] = (amrex::second() - t[mixed]) / npairs * 1.e6;
+        }
+        amrex::Print() << std::setw(8) << a.first
+                       << std::setw(22) << std::setprecision(4) << t[0]
+                       << std::setw(22) << std::setprecision(4) << t[1] << "\n";
+    }
+
+    amrex::Print() << "\n";
+    tarena->PrintUsage("TArena");
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc, argv);
+    main_main();
+    amrex::Finalize();
+}
@@ -3,6 +3,8 @@
 #include <AMReX_VisMF.H>
 #include <AMReX_ParmParse.H>
 #include <AMReX_BLProfiler.H>
+#include <AMReX_AsyncOut.H>
+#include <AMReX_FabArraySnapshot.H>
 
 #include <thread>
 #include <future>
@@ -173,12 +175,15 @@ void main_main ()
 
 // ***************************************************************
 
-    amrex::Print() << " AsyncOut " << std::endl; 
+    amrex::Print() << " AsyncOut " << (AsyncOut::UseStaging() ? "with staging " : "") << std::endl;
+    Real t_resume = 0.0, t_written = 0.0;
     {
         BL_PROFILE_REGION("vismf-async-overlap");
+        Real t_start = amrex::second();
         for (int m = 0; m < nwrites; ++m) {
             VisMF::AsyncWrite(mfs[m], std::string("vismfdata/file-" + std::to_string(m)));
         }
+        t_resume = amrex::second() - t_start;
         {
             BL_PROFILE_VAR("vismf-async-work", blp2);
             for (int m = 0; m < nwrites; ++m) {
@@ -196,6 +201,105 @@ void main_main ()
             BL_PROFILE_VAR("vismf-async-finish", blp3);
             AsyncOut::Finish();
         }
+        t_written = amrex::second() - t_start;
     }
     ParallelDescriptor::Barrier();
+
+    ParallelDescriptor::ReduceRealMax(t_resume);
+    ParallelDescriptor::ReduceRealMax(t_written);
+    amrex::Print() << "  Time to resume compute = " << t_resume << " s\n"
+                   << "  Time until written     = " << t_written << " s" << std::endl;
+
+    for (int m = 0; m < nwrites; ++m) {
+        MultiFab mf_read(ba, dm, 1, 0);
+        VisMF::Read(mf_read, std::string("vismfdata/file-" + std::to_string(m)));
+        if (mf_read.min(0) != mf_min[m] || mf_read.max(0) != mf_max[m]) {
+            amrex::Print() << "Read back of vismfdata/file-" << m << " failed" << std::endl;
+        }
+    }
+
+// ***************************************************************
+
+    // The work now modifies the data after the same read-only work as above.
+    // With a copy, all the data are copied before AsyncWrite returns.  With a
+    // snapshot, only the FABs modified before they are written are copied.
+
+    amrex::Print() << " AsyncOut with modifying work: copy vs. snapshot " << std::endl;
+    Real t_copy[2], mem_copy[2];
+    for (int use_snapshot = 0; use_snapshot < 2; ++use_snapshot)
+    {
+        const std::string name = use_snapshot ? "snapshot" : "copy";
+        BL_PROFILE_REGION("vismf-async-" + name);
+        Vector<std::shared_ptr<FabArraySnapshot<FArrayBox> > > snapshots(nwrites);
+        Real t_start = amrex::second();
+        for (int m = 0; m < nwrites; ++m) {
+            std::string file_name = "vismfdata/" + name + "-" + std::to_string(m);
+            if (use_snapshot) {
+                snapshots[m] = std::make_shared<FabArraySnapshot<FArrayBox> >(mfs[m]);
+                VisMF::AsyncWrite(snapshots[m], file_name);
+            } else {
+                VisMF::AsyncWrite(mfs[m], file_name);
+            }
+        }
+        Real t_resume = amrex::second() - t_start;
+        {
+            BL_PROFILE_VAR("vismf-async-" + name + "-work", blp2);
+            for (int m = 0; m < nwrites; ++m) {
+                for (int i = 0; i < nwork*2; ++i) {
+                    Real min = mfs[m].min(0);
+                    Real max = mfs[m].max(0);
+                    if (mf_min[m] != min)
+                        { amrex::AllPrint() << "Min failed: " << min << " != " << mf_min[m] << std::endl; }
+                    if (mf_max[m] != max)
+                        { amrex::AllPrint() << "Max failed: " << max << " != " << mf_max[m] << std::endl; }
+                }
+                for (MFIter mfi(mfs[m]); mfi.isValid(); ++mfi) {
+                    if (use_snapshot) snapshots[m]->prepareToModify(mfi);
+                    auto const& a = mfs[m].array(mfi);
+                    amrex::ParallelFor(mfi.validbox(), [=] AMREX_GPU_DEVICE (int i, int j, int k) noexcept
+                    {
+                        a(i,j,k) *= 2.0;
+                    });
+                }
+            }
+        }
+        if (AsyncOut::UseAsyncOut()) {
+            BL_PROFILE_VAR("vismf-async-" + name + "-finish", blp3);
+            AsyncOut::Finish();
+        }
+        Real t_written = amrex::second() - t_start;
+
+        Real mem = 0.0;
+        for (int m = 0; m < nwrites; ++m) {
+            if (use_snapshot) {
+                mem += snapshots[m]->peakBytesCopied();
+            } else {
+                for (MFIter mfi(mfs[m]); mfi.isValid(); ++mfi) {
+                    mem += mfs[m][mfi].nBytes();
+                }
+            }
+            mfs[m].mult(0.5, 0, 1);
+        }
+        mem /= 1024.*1024.;
+        ParallelDescriptor::ReduceRealMax(t_resume);
+        ParallelDescriptor::ReduceRealMax(t_written);
+        ParallelDescriptor::ReduceRealMax(mem);
+        t_copy[use_snapshot] = t_resume;
+        mem_copy[use_snapshot] = mem;
+        amrex::Print() << "  " << name << ":\n"
+                       << "    Time to resume compute = " << t_resume << " s\n"
+                       << "    Time until written     = " << t_written << " s\n"
+                       << "    Memory copied (max)    = " << mem << " MB" << std::endl;
+
+        ParallelDescriptor::Barrier();
+        for (int m = 0; m < nwrites; ++m) {
+            MultiFab mf_read(ba, dm, 1, 0);
+            VisMF::Read(mf_read, "vismfdata/" + name + "-" + std::to_string(m));
+            if (mf_read.min(0) != mf_min[m] || mf_read.max(0) != mf_max[m]) {
+                amrex::Print() << "Read back of vismfdata/" << name << "-" << m << " failed" << std::endl;
+            }
+        }
+    }
+    amrex::Print() << "  Snapshot saves " << t_copy[0] - t_copy[1] << " s before compute resumes and "
+                   << mem_copy[0] - mem_copy[1] << " MB of memory" << std::endl;
 }
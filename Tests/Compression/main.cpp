@@ -0,0 +1,205 @@
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <random>
+
+#include <AMReX.H>
+#include <AMReX_AsyncOut.H>
+#include <AMReX_Compression.H>
+#include <AMReX_FabArraySnapshot.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_Print.H>
+#include <AMReX_VisMF.H>
+
+using namespace amrex;
+
+namespace {
+    //! The codec recorded in the first byte of a block.
+    Compression::Codec BlockCodec (const Vector<char>& block)
+    {
+        return static_cast<Compression::Codec>(block[0]);
+    }
+
+    //! Compress and decompress data.  Returns the codec that was used.
+    Compression::Codec RoundTrip (const std::string& what, const Vector<Real>& data,
+                                  Compression::Codec codec, Real tolerance)
+    {
+        Vector<char> block;
+        const Long nbytes = Compression::Compress(data.data(), data.size(), codec, tolerance, block);
+        AMREX_ALWAYS_ASSERT(nbytes == static_cast<Long>(block.size()));
+
+        Vector<Real> result(data.size());
+        Compression::Decompress(block.data(), block.size(), result.data(), result.size());
+
+        if (BlockCodec(block) == Compression::Lossy) {
+            for (int i = 0; i < data.size(); ++i) {
+                if (!(std::abs(result[i] - data[i]) <= tolerance)) {
+                    amrex::Abort("Compression test: " + what + ": error above the tolerance at "
+                                 + std::to_string(i));
+                }
+            }
+        } else if (std::memcmp(result.data(), data.data(), data.size()*sizeof(Real)) != 0) {
+            amrex::Abort("Compression test: " + what + ": lossless round trip is not bit-exact");
+        }
+        return BlockCodec(block);
+    }
+
+    void CheckCodec (const std::string& what, Compression::Codec result,
+                     Compression::Codec expected)
+    {
+        if (result != expected) {
+            amrex::Abort("Compression test: " + what + " used " + Compression::CodecName(result)
+                         + " instead of " + Compression::CodecName(expected));
+        }
+    }
+
+    //! The largest difference between a and b in component comp, including ghost cells.
+    Real MaxDiff (const MultiFab& a, const MultiFab& b, int comp)
+    {
+        MultiFab diff(a.boxArray(), a.DistributionMap(), 1, a.nGrow());
+        MultiFab::Copy(diff, a, comp, 0, 1, a.nGrow());
+        MultiFab::Subtract(diff, b, comp, 0, 1, a.nGrow());
+        return diff.norminf(0, a.nGrow());
+    }
+
+    //! Read the MultiFab name and compare it with mf.
+    void CheckMultiFab (const std::string& name, const MultiFab& mf, Real tolerance)
+    {
+        MultiFab result(mf.boxArray(), mf.DistributionMap(), mf.nComp(), mf.nGrow());
+        VisMF::Read(result, name);
+        if (MaxDiff(mf, result, 0) != 0.0) {
+            amrex::Abort("Compression test: " + name + ": component 0 differs");
+        }
+        if (MaxDiff(mf, result, 1) > tolerance) {
+            amrex::Abort("Compression test: " + name + ": component 1 is above the tolerance");
+        }
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc, argv);
+    {
+        const Long n = 10000;
+        const Real tol = 1.e-6;
+
+        std::mt19937 gen(42);
+        std::uniform_real_distribution<Real> uniform(-1.0, 1.0);
+        Vector<Real> random(n), constant(n, 3.0), smooth(n), special(n), huge(n);
+        for (Long i = 0; i < n; ++i) {
+            random[i] = uniform(gen);
+            smooth[i] = std::sin(0.001*i);
+            special[i] = smooth[i];
+            huge[i] = 1.e300 * smooth[i];
+        }
+        special[0] = std::numeric_limits<Real>::quiet_NaN();
+        special[1] = std::numeric_limits<Real>::infinity();
+        special[2] = -std::numeric_limits<Real>::infinity();
+        special[3] = -0.0;
+        special[n-1] = std::numeric_limits<Real>::quiet_NaN();
+
+        // ---- lossless round trips are bit-exact
+        for (auto codec : {Compression::NoCompression, Compression::Lossless}) {
+            const std::string name = Compression::CodecName(codec);
+            RoundTrip(name + " random", random, codec, 0.0);
+            RoundTrip(name + " constant", constant, codec, 0.0);
+            RoundTrip(name + " NaN/inf", special, codec, 0.0);
+        }
+        CheckCodec("lossless constant",
+                   RoundTrip("lossless constant", constant, Compression::Lossless, 0.0),
+                   Compression::Lossless);
+
+        // ---- lossy round trips are within the tolerance
+        CheckCodec("lossy smooth", RoundTrip("lossy smooth", smooth, Compression::Lossy, tol),
+                   Compression::Lossy);
+        CheckCodec("lossy constant", RoundTrip("lossy constant", constant, Compression::Lossy, tol),
+                   Compression::Lossy);
+        RoundTrip("lossy random", random, Compression::Lossy, tol);
+
+        // ---- data that cannot be quantized are stored losslessly
+        for (const auto& d : {std::make_pair(std::string("NaN/inf"), special),
+                              std::make_pair(std::string("huge"), huge)}) {
+            const auto codec = RoundTrip("lossy " + d.first, d.second, Compression::Lossy, tol);
+            if (codec != Compression::Lossless && codec != Compression::NoCompression) {
+                amrex::Abort("Compression test: lossy " + d.first + " was not stored losslessly");
+            }
+        }
+        for (const Real t : {0.0, -1.0}) {
+            const auto codec = RoundTrip("lossy with tolerance " + std::to_string(t),
+                                         smooth, Compression::Lossy, t);
+            if (codec == Compression::Lossy) {
+                amrex::Abort("Compression test: lossy with a tolerance <= 0 was not lossless");
+            }
+        }
+
+        // ---- LZ round trip, including runs longer than the length bytes
+        {
+            Vector<char> bytes(100000);
+            for (Long i = 0; i < bytes.size(); ++i) {
+                bytes[i] = (i < 50000) ? 'a' : static_cast<char>(gen() % 7);
+            }
+            Vector<char> lz;
+            Compression::LZCompress(bytes.data(), bytes.size(), lz);
+            Vector<char> result(bytes.size());
+            Compression::LZDecompress(lz.data(), lz.size(), result.data(), result.size());
+            AMREX_ALWAYS_ASSERT(lz.size() < bytes.size() && result == bytes);
+
+            Vector<char> empty;
+            Compression::LZCompress(bytes.data(), 0, empty);
+            Compression::LZDecompress(empty.data(), empty.size(), result.data(), 0);
+        }
+
+        // ---- VisMF round trips of a Compressed_v1 MultiFab, with component 0
+        // ---- lossless and component 1 lossy
+        int n_cell = 32;
+        int max_grid_size = 16;
+        {
+            ParmParse pp;
+            pp.query("n_cell", n_cell);
+            pp.query("max_grid_size", max_grid_size);
+        }
+        BoxArray ba(Box(IntVect(0), IntVect(n_cell-1)));
+        ba.maxSize(max_grid_size);
+        DistributionMapping dm(ba);
+        MultiFab mf(ba, dm, 2, 1);
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
+            const auto a = mf.array(mfi);
+            amrex::ParallelFor(mfi.fabbox(), [=] AMREX_GPU_DEVICE (int i, int j, int k) noexcept
+            {
+                const Real r = AMREX_D_TERM(0.1*i, + 0.01*j, + 0.001*k);
+                a(i,j,k,0) = std::sin(r);
+                a(i,j,k,1) = std::cos(r);
+            });
+        }
+        Gpu::streamSynchronize();
+
+        VisMF::SetCompression({Compression::Lossless, Compression::Lossy}, {0.0, tol});
+
+        VisMF::Write(mf, "compressed_mf");
+        CheckMultiFab("compressed_mf", mf, tol);
+
+        if (AsyncOut::UseAsyncOut()) {
+            VisMF::AsyncWrite(mf, "compressed_async_mf");
+
+            // ---- the snapshot is written as it was, although mf changes
+            MultiFab saved(ba, dm, 2, 1);
+            MultiFab::Copy(saved, mf, 0, 0, 2, 1);
+            auto snapshot = std::make_shared<FabArraySnapshot<FArrayBox> >(mf);
+            VisMF::AsyncWrite(snapshot, "compressed_snapshot_mf");
+            snapshot->prepareToModifyAll();
+            mf.setVal(-1.0);
+
+            AsyncOut::Finish();
+            CheckMultiFab("compressed_async_mf", saved, tol);
+            CheckMultiFab("compressed_snapshot_mf", saved, tol);
+        }
+
+        VisMF::SetCompression(Compression::NoCompression);
+
+        amrex::Print() << "Compression test passed\n";
+    }
+    amrex::Finalize();
+}
@@ -0,0 +1,126 @@
+#include <AMReX.H>
+#include <AMReX_Print.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_BoxArray.H>
+#include <AMReX_DistributionMapping.H>
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+using namespace amrex;
+
+//
+// Compare the distribution mapping strategies on a BoxArray read from a
+// file.  For each strategy, the load balance (max/avg of the number of
+// cells per rank) and the number of bytes of ghost cell data exchanged
+// between ranks and between nodes by a FillBoundary are printed.  Because
+// the strategies distribute over the ranks of the current communicator,
+// this should be run with the number of ranks to be studied.
+//
+int
+main (int argc, char* argv[])
+{
+    amrex::Initialize(argc,argv);
+    {
+        std::string ba_file("ba.max");
+        int max_grid_size = 0;
+        int ngrow = 2;
+        int ncomp = 4;
+        {
+            ParmParse pp;
+            pp.query("ba_file", ba_file);
+            pp.query("max_grid_size", max_grid_size);
+            pp.query("ngrow", ngrow);
+            pp.query("ncomp", ncomp);
+        }
+
+        BoxArray ba;
+        {
+            Vector<char> fileCharPtr;
+            ParallelDescriptor::ReadAndBcastFile(ba_file, fileCharPtr);
+            std::istringstream is(fileCharPtr.dataPtr(), std::istringstream::in);
+            ba.readFrom(is);
+        }
+        if (max_grid_size > 0) {
+            ba.maxSize(max_grid_size);
+        }
+
+        const int nprocs = ParallelDescriptor::NProcs();
+
+        amrex::Print() << "# of boxes: " << ba.size() << ", # of cells: " << ba.numPts()
+                       << ", # of ranks: " << nprocs << ", ngrow: " << ngrow
+                       << ", ncomp: " << ncomp << "\n\n";
+
+        const Long bytes_per_cell = ncomp * sizeof(Real);
+
+        // Ghost cell overlaps between different boxes
+        Vector<std::pair<int,int> > pairs;
+        Vector<Long> npts;
+        {
+            std::vector< std::pair<int,Box> > isects;
+            for (int i = 0, N = ba.size(); i < N; ++i)
+            {
+                ba.intersections(amrex::grow(ba[i],ngrow), isects);
+                for (auto const& is : isects) {
+                    if (is.first != i) {
+                        pairs.push_back(std::make_pair(i,is.first));
+                        npts.push_back(is.second.numPts());
+                    }
+                }
+            }
+        }
+
+        const std::vector<std::pair<std::string,DistributionMapping::Strategy> > strategies
+            {{"ROUNDROBIN", DistributionMapping::ROUNDROBIN},
+             {"KNAPSACK"  , DistributionMapping::KNAPSACK  },
+             {"SFC"       , DistributionMapping::SFC       },
+             {"RRSFC"     , DistributionMapping::RRSFC     },
+             {"SFC_NODE"  , DistributionMapping::SFC_NODE  },
+             {"GRAPH"     , DistributionMapping::GRAPH     }};
+
+        amrex::Print() << std::setw(12) << "strategy"
+                       << std::setw(14) << "max/avg load"
+                       << std::setw(18) << "inter-rank bytes"
+                       << std::setw(18) << "inter-node bytes"
+                       << std::setw(12) << "time (s)" << "\n";
+
+        for (auto const& s : strategies)
+        {
+            DistributionMapping::strategy(s.second);
+
+            ParallelDescriptor::Barrier();
+            double t0 = ParallelDescriptor::second();
+            DistributionMapping dm(ba);
+            double t = ParallelDescriptor::second() - t0;
+            ParallelDescriptor::ReduceRealMax(t);
+
+            Vector<Long> load(nprocs, 0);
+            for (int i = 0, N = ba.size(); i < N; ++i) {
+                load[dm[i]] += ba[i].numPts();
+            }
+            const Long maxload = *std::max_element(load.begin(), load.end());
+            const Real avgload = Real(ba.numPts()) / nprocs;
+
+            Long offrank = 0, offnode = 0;
+            for (int k = 0, N = pairs.size(); k < N; ++k)
+            {
+                const int r0 = dm[pairs[k].first];
+                const int r1 = dm[pairs[k].second];
+                if (r0 != r1) {
+                    offrank += npts[k];
+                    if (DistributionMapping::NodeID(r0) != DistributionMapping::NodeID(r1)) {
+                        offnode += npts[k];
+                    }
+                }
+            }
+
+            amrex::Print() << std::setw(12) << s.first
+                           << std::setw(14) << std::setprecision(4) << maxload/avgload
+                           << std::setw(18) << offrank*bytes_per_cell
+                           << std::setw(18) << offnode*bytes_per_cell
+                           << std::setw(12) << std::setprecision(3) << t << "\n";
+        }
+    }
+    amrex::Finalize();
+}
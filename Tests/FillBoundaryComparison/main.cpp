@@ -130,34 +130,85 @@ main (int argc, char* argv[])
 	pp.query("nrounds", nrounds);
     }
 
+    auto run_rounds = [&] (Real& err) -> Real
+    {
+        ParallelDescriptor::Barrier();
+        Real wt0 = ParallelDescriptor::second();
+
+        for (int iround = 0; iround < nrounds; ++iround) {
+            for (int c=0; c<2; ++c) {
+                for (int lev = 0; lev < nlevels; ++lev) {
+                    mfs[lev]->FillBoundary_nowait();
+                    mfs[lev]->FillBoundary_finish();
+                }
+                for (int lev = nlevels-1; lev >= 0; --lev) {
+                    mfs[lev]->FillBoundary_nowait();
+                    mfs[lev]->FillBoundary_finish();
+                }
+            }
+            Real e = double(iround+ParallelDescriptor::MyProc());
+            ParallelDescriptor::ReduceRealMax(e);
+            err += e;
+        }
+
+        ParallelDescriptor::Barrier();
+        return ParallelDescriptor::second() - wt0;
+    };
+
+    // Check that the persistent plans fill the same ghost cells as the
+    // regular FillBoundary.  The valid cells are distinct and the ghost cells
+    // start at -1.  The persistent FillBoundary is done twice, so the second
+    // reuses the plans made by the first.
+    for (int lev = 0; lev < nlevels; ++lev) {
+        MultiFab regular(bas[lev], dm, 1, 1);
+        MultiFab persistent(bas[lev], dm, 1, 1);
+        for (MFIter mfi(regular); mfi.isValid(); ++mfi) {
+            const auto a = regular.array(mfi);
+            const Box& fbx = mfi.fabbox();
+            const Box& vbx = mfi.validbox();
+            amrex::ParallelFor(fbx, [=] AMREX_GPU_DEVICE (int i, int j, int k) noexcept
+            {
+                a(i,j,k) = vbx.contains(IntVect(AMREX_D_DECL(i,j,k)))
+                    ? 1.0 + AMREX_D_TERM(i, + 4096.0*j, + 4096.0*4096.0*k) : -1.0;
+            });
+        }
+        MultiFab::Copy(persistent, regular, 0, 0, 1, 1);
+
+        FabArrayBase::fb_persistent_comm = false;
+        regular.FillBoundary();
+        FabArrayBase::fb_persistent_comm = true;
+        for (int n = 0; n < 2; ++n) {
+            persistent.setBndry(-1.0);
+            persistent.FillBoundary();
+        }
+
+        MultiFab::Subtract(persistent, regular, 0, 0, 1, 1);
+        const Real diff = persistent.norminf(0, 1);
+        if (diff != 0.0) {
+            amrex::Abort("FillBoundaryComparison: the persistent plans fill different ghost cells on level "
+                         + std::to_string(lev));
+        }
+    }
+    amrex::Print() << "The persistent plans fill the same ghost cells\n";
+
+    // Each round does 4*nlevels FillBoundary calls.
+    const Real ncalls = Real(4*nlevels) * nrounds;
+
     Real err = 0.0;
 
-    ParallelDescriptor::Barrier();
-    Real wt0 = ParallelDescriptor::second();
+    FabArrayBase::fb_persistent_comm = false;
+    const Real t_regular = run_rounds(err);
 
-    for (int iround = 0; iround < nrounds; ++iround) {
-	for (int c=0; c<2; ++c) {
-	    for (int lev = 0; lev < nlevels; ++lev) {
-		mfs[lev]->FillBoundary_nowait();
-		mfs[lev]->FillBoundary_finish();
-	    }
-	    for (int lev = nlevels-1; lev >= 0; --lev) {
-		mfs[lev]->FillBoundary_nowait();
-		mfs[lev]->FillBoundary_finish();
-	    }
-	}
-	Real e = double(iround+ParallelDescriptor::MyProc());
-	ParallelDescriptor::ReduceRealMax(e);
-	err += e;
-    }
-	    
-    ParallelDescriptor::Barrier();
-    Real wt1 = ParallelDescriptor::second();
+    FabArrayBase::fb_persistent_comm = true;
+    const Real t_persistent = run_rounds(err);
 
     if (ParallelDescriptor::IOProcessor()) {
         std::cout << "Using MPI" << std::endl;
 	std::cout << "----------------------------------------------" << std::endl;
-	std::cout << "Fill Boundary Time: " << wt1-wt0 << std::endl;
+	std::cout << "Fill Boundary Time: " << t_regular << std::endl;
+	std::cout << "    per call (us) : " << t_regular/ncalls*1.e6 << std::endl;
+	std::cout << "Fill Boundary Time with persistent plans: " << t_persistent << std::endl;
+	std::cout << "    per call (us) : " << t_persistent/ncalls*1.e6 << std::endl;
 	std::cout << "----------------------------------------------" << std::endl;
 	std::cout << "ignore this line " << err << std::endl;
     }
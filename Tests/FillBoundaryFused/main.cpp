@@ -0,0 +1,97 @@
+//
+// Compare FillBoundary on N MultiFabs called one after another with the
+// fused FillBoundary(Vector<FabArray*>) that sends one message per rank.
+//
+
+#include <AMReX.H>
+#include <AMReX_Geometry.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_Print.H>
+#include <AMReX_Utility.H>
+
+#include <iomanip>
+
+using namespace amrex;
+
+int
+main (int argc, char* argv[])
+{
+    amrex::Initialize(argc,argv);
+    {
+        int n_cell = 128;
+        int max_grid_size = 32;
+        int nghost = 2;
+        int ncomp = 1;
+        int nrounds = 100;
+        int max_fields = 16;
+        {
+            ParmParse pp;
+            pp.query("n_cell", n_cell);
+            pp.query("max_grid_size", max_grid_size);
+            pp.query("nghost", nghost);
+            pp.query("ncomp", ncomp);
+            pp.query("nrounds", nrounds);
+            pp.query("max_fields", max_fields);
+        }
+
+        Box domain(IntVect(0), IntVect(n_cell-1));
+        BoxArray ba(domain);
+        ba.maxSize(max_grid_size);
+        DistributionMapping dm(ba);
+
+        RealBox rb({AMREX_D_DECL(0.,0.,0.)}, {AMREX_D_DECL(1.,1.,1.)});
+        Array<int,AMREX_SPACEDIM> is_periodic{AMREX_D_DECL(1,1,1)};
+        Geometry geom(domain, rb, CoordSys::cartesian, is_periodic);
+
+        Vector<MultiFab> mfs(max_fields);
+        for (auto& mf : mfs) {
+            mf.define(ba, dm, ncomp, nghost);
+            mf.setVal(1.0);
+        }
+
+        amrex::Print() << "num boxes = " << ba.size() << ", nghost = " << nghost
+                       << ", ncomp = " << ncomp << "\n\n"
+                       << "  nfields   sequential (s)   fused (s)   speedup\n";
+
+        for (int nfields = 1; nfields <= max_fields; nfields *= 2)
+        {
+            Vector<MultiFab*> v;
+            for (int i = 0; i < nfields; ++i) {
+                v.push_back(&mfs[i]);
+            }
+
+            // warm up the FB cache
+            for (auto* mf : v) {
+                mf->FillBoundary(geom.periodicity());
+            }
+
+            ParallelDescriptor::Barrier();
+            Real t0 = amrex::second();
+            for (int iround = 0; iround < nrounds; ++iround) {
+                for (auto* mf : v) {
+                    mf->FillBoundary(geom.periodicity());
+                }
+            }
+            ParallelDescriptor::Barrier();
+            Real t_seq = amrex::second() - t0;
+
+            t0 = amrex::second();
+            for (int iround = 0; iround < nrounds; ++iround) {
+                amrex::FillBoundary(v, geom.periodicity());
+            }
+            ParallelDescriptor::Barrier();
+            Real t_fused = amrex::second() - t0;
+
+            ParallelDescriptor::ReduceRealMax(t_seq);
+            ParallelDescriptor::ReduceRealMax(t_fused);
+
+            amrex::Print() << std::setprecision(4)
+                           << std::setw(9)  << nfields
+                           << std::setw(17) << t_seq
+                           << std::setw(12) << t_fused
+                           << std::setw(10) << t_seq/t_fused << "\n";
+        }
+    }
+    amrex::Finalize();
+}
@@ -0,0 +1,133 @@
+//
+// Apply a 7-point (5-point in 2D) stencil repeatedly.  Compare filling
+// ghost cells before the update with overlapping the ghost cell exchange
+// with the update of the interior tiles using MFSplitIter.
+//
+
+#include <AMReX.H>
+#include <AMReX_Geometry.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_Print.H>
+#include <AMReX_Utility.H>
+
+using namespace amrex;
+
+namespace {
+
+void smooth (Box const& bx, Array4<Real> const& phin, Array4<Real const> const& phio)
+{
+    const Real fac = Real(1.0)/Real(2*AMREX_SPACEDIM+1);
+    amrex::LoopConcurrentOnCpu(bx, [=] (int i, int j, int k) noexcept
+    {
+        phin(i,j,k) = fac * (phio(i,j,k)
+                             + phio(i-1,j,k) + phio(i+1,j,k)
+#if (AMREX_SPACEDIM > 1)
+                             + phio(i,j-1,k) + phio(i,j+1,k)
+#endif
+#if (AMREX_SPACEDIM > 2)
+                             + phio(i,j,k-1) + phio(i,j,k+1)
+#endif
+            );
+    });
+}
+
+void init (MultiFab& mf)
+{
+    for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
+        auto const& a = mf.array(mfi);
+        amrex::LoopOnCpu(mfi.validbox(), [=] (int i, int j, int k) noexcept
+        {
+            a(i,j,k) = Real((i*7+j*13+k*29)%17);
+        });
+    }
+}
+
+}
+
+int
+main (int argc, char* argv[])
+{
+    amrex::Initialize(argc,argv);
+    {
+        int n_cell = 256;
+        int max_grid_size = 64;
+        int nsteps = 20;
+        {
+            ParmParse pp;
+            pp.query("n_cell", n_cell);
+            pp.query("max_grid_size", max_grid_size);
+            pp.query("nsteps", nsteps);
+        }
+
+        Box domain(IntVect(0), IntVect(n_cell-1));
+        BoxArray ba(domain);
+        ba.maxSize(max_grid_size);
+        DistributionMapping dm(ba);
+
+        RealBox rb({AMREX_D_DECL(0.,0.,0.)}, {AMREX_D_DECL(1.,1.,1.)});
+        Array<int,AMREX_SPACEDIM> is_periodic{AMREX_D_DECL(1,1,1)};
+        Geometry geom(domain, rb, CoordSys::cartesian, is_periodic);
+
+        const IntVect ng(1);
+        MultiFab phi_a(ba, dm, 1, ng), tmp_a(ba, dm, 1, ng);
+        MultiFab phi_b(ba, dm, 1, ng), tmp_b(ba, dm, 1, ng);
+        init(phi_a);
+        init(phi_b);
+
+        // Blocking FillBoundary followed by the update
+        ParallelDescriptor::Barrier();
+        Real t0 = amrex::second();
+        for (int istep = 0; istep < nsteps; ++istep)
+        {
+            phi_a.FillBoundary(geom.periodicity());
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+            for (MFIter mfi(phi_a,true); mfi.isValid(); ++mfi) {
+                smooth(mfi.tilebox(), tmp_a.array(mfi), phi_a.const_array(mfi));
+            }
+            std::swap(phi_a, tmp_a);
+        }
+        ParallelDescriptor::Barrier();
+        Real t_blocking = amrex::second() - t0;
+
+        // Update interior tiles while the ghost cells are being exchanged
+        ParallelDescriptor::Barrier();
+        t0 = amrex::second();
+        for (int istep = 0; istep < nsteps; ++istep)
+        {
+            phi_b.FillBoundary_nowait(geom.periodicity());
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+            for (MFSplitIter mfi(phi_b, MFSplitIter::Inner, ng); mfi.isValid(); ++mfi) {
+                smooth(mfi.tilebox(), tmp_b.array(mfi), phi_b.const_array(mfi));
+            }
+            phi_b.FillBoundary_finish();
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+            for (MFSplitIter mfi(phi_b, MFSplitIter::Shell, ng); mfi.isValid(); ++mfi) {
+                smooth(mfi.tilebox(), tmp_b.array(mfi), phi_b.const_array(mfi));
+            }
+            std::swap(phi_b, tmp_b);
+        }
+        ParallelDescriptor::Barrier();
+        Real t_overlap = amrex::second() - t0;
+
+        MultiFab::Subtract(phi_b, phi_a, 0, 0, 1, 0);
+        const Real diff = phi_b.norminf();
+
+        ParallelDescriptor::ReduceRealMax(t_blocking);
+        ParallelDescriptor::ReduceRealMax(t_overlap);
+
+        amrex::Print() << "n_cell = " << n_cell << ", max_grid_size = " << max_grid_size
+                       << ", nsteps = " << nsteps << "\n"
+                       << "  blocking FillBoundary time: " << t_blocking << "\n"
+                       << "  overlapped time           : " << t_overlap << "\n"
+                       << "  speedup                   : " << t_blocking/t_overlap << "\n"
+                       << "  max difference            : " << diff << "\n";
+    }
+    amrex::Finalize();
+}
@@ -11,6 +11,8 @@
 #include <AMReX_ParallelDescriptor.H>
 #include <AMReX_Utility.H>
 #include <AMReX_NFiles.H>
+#include <AMReX_Random.H>
+#include <AMReX_Loop.H>
 
 #include <iostream>
 #include <sstream>
@@ -252,6 +254,9 @@ void TestWriteNFiles(int nfiles, int maxgrid, int ncomps, int nboxes,
     case VisMF::Header::NoFabHeaderFAMinMax_v1:
       mfName = "TestMFNoFabHeaderFAMinMax";
     break;
+    case VisMF::Header::Bricked_v1:
+      mfName = "TestMFBricked";
+    break;
     default:
       amrex::Abort("**** Error in TestWriteNFiles:  bad version.");
   }
@@ -446,6 +451,234 @@ void TestReadMF(const std::string &mfName, bool useSyncReads,
 
 
 
+// -------------------------------------------------------------
+namespace {
+  Real RegionTestValue(int i, int j, int k, int n) {
+    return static_cast<Real>(i) + 1.0e+3 * j + 1.0e+6 * k + 1.0e+9 * n;
+  }
+}
+
+
+// -------------------------------------------------------------
+void TestReadRegion(int nfiles, int maxgrid, int ncomps, int nboxes,
+                    const IntVect &brickSize, int regionSize, int nRegions)
+{
+  VisMF::SetNOutFiles(nfiles);
+
+  BoxArray bArray(MakeBoxArray(maxgrid, nboxes));
+  DistributionMapping dmap{bArray};
+  MultiFab mf(bArray, dmap, ncomps, 0);
+  for(MFIter mfi(mf); mfi.isValid(); ++mfi) {
+    Array4<Real> const& a = mf.array(mfi);
+    const Box &bx = mfi.validbox();
+    for(int n(0); n < ncomps; ++n) {
+      amrex::LoopOnCpu(bx, [&] (int i, int j, int k) {
+        a(i,j,k,n) = RegionTestValue(i, j, k, n);
+      });
+    }
+  }
+
+  // ---- each process reads nRegions regions from the fabs it owns
+  amrex::InitRandom(ParallelDescriptor::MyProc() + 1);
+  Vector<int> myFabs;
+  for(int i(0); i < dmap.size(); ++i) {
+    if(dmap[i] == ParallelDescriptor::MyProc()) {
+      myFabs.push_back(i);
+    }
+  }
+  const int rsize(std::max(1, std::min(regionSize, maxgrid)));
+  Vector<int> regionFab, regionComp;
+  Vector<Box> cubes, lines;
+  for(int r(0); r < nRegions && ! myFabs.empty(); ++r) {
+    int idx(myFabs[amrex::Random_int(myFabs.size())]);
+    const Box &fbox = bArray[idx];
+    IntVect lo(fbox.smallEnd());
+    for(int d(0); d < AMREX_SPACEDIM; ++d) {
+      lo[d] += amrex::Random_int(fbox.length(d) - rsize + 1);
+    }
+    regionFab.push_back(idx);
+    regionComp.push_back(amrex::Random_int(ncomps));
+    cubes.push_back(Box(lo, lo + (rsize - 1)));
+    // ---- a line of cells in the slowest varying direction
+    Box line(lo, lo);
+    line.setBig(AMREX_SPACEDIM - 1, fbox.bigEnd(AMREX_SPACEDIM - 1));
+    line.setSmall(AMREX_SPACEDIM - 1, fbox.smallEnd(AMREX_SPACEDIM - 1));
+    lines.push_back(line);
+  }
+
+  VisMF::Header::Version currentVersion(VisMF::GetHeaderVersion());
+  IntVect currentBrickSize(VisMF::GetBrickSize());
+  VisMF::SetBrickSize(brickSize);
+
+  Vector<VisMF::Header::Version> versions{ VisMF::Header::Version_v1,
+                                           VisMF::Header::Bricked_v1 };
+  for(VisMF::Header::Version whichVersion : versions) {
+    std::string mfName(whichVersion == VisMF::Header::Bricked_v1 ?
+                       "TestMFRegionBricked" : "TestMFRegion");
+    VisMF::RemoveFiles(mfName, false);  // ---- not verbose
+    VisMF::SetHeaderVersion(whichVersion);
+
+    ParallelDescriptor::Barrier("TestReadRegion:BeforeWrite");
+    double wallTimeStart(ParallelDescriptor::second());
+    VisMF::Write(mf, mfName);
+    ParallelDescriptor::Barrier("TestReadRegion:AfterWrite");
+    double writeTime(ParallelDescriptor::second() - wallTimeStart);
+    VisMF::CloseAllStreams();
+
+    // ---- the whole multifab
+    MultiFab mfRead(bArray, dmap, ncomps, 0);
+    wallTimeStart = ParallelDescriptor::second();
+    VisMF::Read(mfRead, mfName);
+    double readTime(ParallelDescriptor::second() - wallTimeStart);
+    MultiFab::Subtract(mfRead, mf, 0, 0, ncomps, 0);
+    bool readOk(true);
+    for(int n(0); n < ncomps; ++n) {
+      readOk &= (mfRead.norm0(n) == 0.0);
+    }
+
+    // ---- one component of each fab
+    VisMF vismf(mfName);
+    wallTimeStart = ParallelDescriptor::second();
+    for(int idx : myFabs) {
+      FArrayBox *fab = vismf.readFAB(idx, ncomps - 1);
+      delete fab;
+    }
+    double compTime(ParallelDescriptor::second() - wallTimeStart);
+
+    // ---- small regions of one component
+    long nErrors(0);
+    auto readRegions = [&] (const Vector<Box> &regions) -> double {
+      VisMF vmf(mfName);
+      double tStart(ParallelDescriptor::second());
+      for(int r(0); r < regions.size(); ++r) {
+        FArrayBox fab(regions[r], 1);
+        vmf.readRegion(regionFab[r], regions[r], regionComp[r], 1, fab);
+        Array4<Real const> const& a = fab.const_array();
+        int n(regionComp[r]);
+        amrex::LoopOnCpu(regions[r], [&] (int i, int j, int k) {
+          if(a(i,j,k) != RegionTestValue(i, j, k, n)) {
+            ++nErrors;
+          }
+        });
+      }
+      return ParallelDescriptor::second() - tStart;
+    };
+    double cubeTime(readRegions(cubes));
+    double lineTime(readRegions(lines));
+
+    ParallelDescriptor::ReduceLongSum(nErrors, ParallelDescriptor::IOProcessorNumber());
+    Vector<Real> times{ writeTime, readTime, compTime, cubeTime, lineTime };
+    ParallelDescriptor::ReduceRealMax(times.dataPtr(), times.size(),
+                                      ParallelDescriptor::IOProcessorNumber());
+
+    if(ParallelDescriptor::IOProcessor()) {
+      cout << std::setprecision(5);
+      cout << "------------------------------------------" << endl;
+      cout << "  Region reads with version:  " << whichVersion;
+      if(whichVersion == VisMF::Header::Bricked_v1) {
+        cout << "  bricksize = " << brickSize;
+      }
+      cout << endl;
+      cout << "  Write time                  = " << times[0] << " s." << endl;
+      cout << "  Read all components         = " << times[1] << " s." << endl;
+      cout << "  Read one component          = " << times[2] << " s." << endl;
+      cout << "  Read " << nRegions << " regions of " << rsize << "^" << AMREX_SPACEDIM
+           << " cells = " << times[3] << " s." << endl;
+      cout << "  Read " << nRegions << " lines of " << maxgrid
+           << " cells    = " << times[4] << " s." << endl;
+      if( ! readOk) {
+        cout << "**** Error:  VisMF::Read() multifab is not ok." << endl;
+      }
+      if(nErrors > 0) {
+        cout << "**** Error:  " << nErrors << " cells read incorrectly." << endl;
+      }
+      cout << "------------------------------------------" << endl;
+    }
+  }
+
+  VisMF::SetHeaderVersion(currentVersion);  // ---- set back to previous version
+  VisMF::SetBrickSize(currentBrickSize);
+}
+
+
+
+// -------------------------------------------------------------
+void TestWriteMPIIO(const Vector<int> &nfilesList, int maxgrid, int ncomps, int nboxes,
+                    bool mb2, int nAggregators)
+{
+  if(mb2) {
+    bytesPerMB = pow(2.0, 20);
+  }
+
+  BoxArray bArray(MakeBoxArray(maxgrid, nboxes));
+  DistributionMapping dmap{bArray};
+  MultiFab mf(bArray, dmap, ncomps, 0);
+  for(MFIter mfi(mf); mfi.isValid(); ++mfi) {
+    Array4<Real> const& a = mf.array(mfi);
+    const Box &bx = mfi.validbox();
+    for(int n(0); n < ncomps; ++n) {
+      amrex::LoopOnCpu(bx, [&] (int i, int j, int k) {
+        a(i,j,k,n) = RegionTestValue(i, j, k, n);
+      });
+    }
+  }
+
+  const int currentNFiles(VisMF::GetNOutFiles());
+  const int currentAggregators(VisMF::GetMPIIOAggregators());
+  VisMF::SetMPIIOAggregators(nAggregators);
+
+  // ---- nfiles = 0 is the MPIIO write
+  Vector<int> runs(nfilesList);
+  runs.push_back(0);
+  for(int nfiles : runs) {
+    const bool mpiio(nfiles == 0);
+    const std::string mfName(mpiio ? "TestMFMPIIO" : "TestMFNFiles");
+    VisMF::RemoveFiles(mfName, false);  // ---- not verbose
+    if( ! mpiio) {
+      VisMF::SetNOutFiles(nfiles);
+    }
+
+    ParallelDescriptor::Barrier("TestWriteMPIIO:BeforeWrite");
+    double wallTimeStart(ParallelDescriptor::second());
+    long bytesWritten(VisMF::Write(mf, mfName, mpiio ? VisMF::MPIIO : VisMF::NFiles));
+    ParallelDescriptor::Barrier("TestWriteMPIIO:AfterWrite");
+    double wallTime(ParallelDescriptor::second() - wallTimeStart);
+
+    ParallelDescriptor::ReduceLongSum(bytesWritten, ParallelDescriptor::IOProcessorNumber());
+    ParallelDescriptor::ReduceRealMax(wallTime, ParallelDescriptor::IOProcessorNumber());
+    Real megabytes((static_cast<Real> (bytesWritten)) / bytesPerMB);
+
+    // ---- the data are read back with the usual reader
+    MultiFab mfRead(bArray, dmap, ncomps, 0);
+    VisMF::Read(mfRead, mfName);
+    MultiFab::Subtract(mfRead, mf, 0, 0, ncomps, 0);
+    bool readOk(true);
+    for(int n(0); n < ncomps; ++n) {
+      readOk &= (mfRead.norm0(n) == 0.0);
+    }
+
+    if(ParallelDescriptor::IOProcessor()) {
+      cout << std::setprecision(5);
+      cout << "------------------------------------------" << endl;
+      if(mpiio) {
+        cout << "  MPIIO with " << nAggregators << " aggregators per node" << endl;
+      } else {
+        cout << "  NFiles with " << VisMF::GetNOutFiles() << " files" << endl;
+      }
+      cout << "  Total megabytes       = " << megabytes << endl;
+      cout << "  Write:  Megabytes/sec = " << megabytes/wallTime << endl;
+      cout << "  Wall clock time       = " << wallTime << " s." << endl;
+      if( ! readOk) {
+        cout << "**** Error:  VisMF::Read() multifab is not ok." << endl;
+      }
+      cout << "------------------------------------------" << endl;
+    }
+  }
+
+  VisMF::SetNOutFiles(currentNFiles);
+  VisMF::SetMPIIOAggregators(currentAggregators);
+}
+
 // -------------------------------------------------------------
 void DSSNFileTests(int noutfiles, const std::string &filePrefixIn,
                    bool useIter)
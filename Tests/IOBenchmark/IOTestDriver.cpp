@@ -34,6 +34,10 @@ void TestWriteNFiles(int nfiles, int maxgrid, int ncomps, int nboxes,
 		     const std::string &dirName);
 void TestReadMF(const std::string &mfName, bool useSyncReads,
                      int nMultiFabs, const std::string &dirName);
+void TestReadRegion(int nfiles, int maxgrid, int ncomps, int nboxes,
+                    const IntVect &brickSize, int regionSize, int nRegions);
+void TestWriteMPIIO(const Vector<int> &nfilesList, int maxgrid, int ncomps, int nboxes,
+                    bool mb2, int nAggregators);
 void NFileTests(int nOutFiles, const std::string &filePrefix);
 void DSSNFileTests(int nOutFiles, const std::string &filePrefix,
                    bool useIter);
@@ -63,6 +67,13 @@ static void PrintUsage(const char *progName) {
     cout << "   [testwritenfiles   = versions ]" << '\n';
     cout << "   [testreadmf        = tf       ]" << '\n';
     cout << "   [readFANames       = fanames  ]" << '\n';
+    cout << "   [testreadregion    = tf       ]" << '\n';
+    cout << "   [bricksize         = bsize    ]" << '\n';
+    cout << "   [regionsize        = rsize    ]" << '\n';
+    cout << "   [nregions          = nreg     ]" << '\n';
+    cout << "   [testmpiio         = tf       ]" << '\n';
+    cout << "   [comparenfiles     = nfiles   ]" << '\n';
+    cout << "   [mpiioaggregators  = naggr    ]" << '\n';
     cout << "   [nreadstreams      = nrs      ]" << '\n';
     cout << "   [usesingleread     = tf       ]" << '\n';
     cout << "   [usesinglewrite    = tf       ]" << '\n';
@@ -98,7 +109,7 @@ int main(int argc, char *argv[]) {
   bool groupSets(false), setBuf(true);
   bool nfileitertest(false), dssnfileitertest(false);
   bool filetests(false), dirtests(false);
-  bool testreadmf(false);
+  bool testreadmf(false), testreadregion(false);
   bool useSingleRead(false), useSingleWrite(false);
   bool checkFPositions(false), pIFStreams(false);
   bool checkmf(false);
@@ -107,6 +118,11 @@ int main(int argc, char *argv[]) {
   Vector<std::string> readFANames;
   int nReadStreams(1), nMultiFabs(1);
   std::string dirName("");
+  IntVect brickSize(VisMF::GetBrickSize());
+  int regionSize(8), nRegions(64);
+  bool testmpiio(false);
+  Vector<int> compareNFiles;
+  int mpiioAggregators(VisMF::GetMPIIOAggregators());
 
 
   pp.query("nfiles", nfiles);
@@ -161,6 +177,22 @@ int main(int argc, char *argv[]) {
   pp.query("nreadstreams", nReadStreams);
   nReadStreams = std::max(1, nReadStreams);
   pp.query("dirname", dirName);
+  pp.query("testreadregion", testreadregion);
+  if(pp.countval("bricksize") > 0) {
+    Vector<int> bsize;
+    pp.getarr("bricksize", bsize);
+    for(int d(0); d < AMREX_SPACEDIM; ++d) {
+      brickSize[d] = bsize[std::min(d, static_cast<int>(bsize.size()) - 1)];
+    }
+  }
+  pp.query("regionsize", regionSize);
+  pp.query("nregions", nRegions);
+  pp.query("testmpiio", testmpiio);
+  pp.queryarr("comparenfiles", compareNFiles);
+  if(compareNFiles.empty()) {
+    compareNFiles.push_back(nfiles);
+  }
+  pp.query("mpiioaggregators", mpiioAggregators);
 
 
   if(ParallelDescriptor::IOProcessor()) {
@@ -190,6 +222,15 @@ int main(int argc, char *argv[]) {
       cout << "readFANames[" << i << "]    = " << readFANames[i] << '\n';
     }
     cout << "nreadstreams      = " << nReadStreams << '\n';
+    cout << "testreadregion    = " << testreadregion << '\n';
+    cout << "bricksize         = " << brickSize << '\n';
+    cout << "regionsize        = " << regionSize << '\n';
+    cout << "nregions          = " << nRegions << '\n';
+    cout << "testmpiio         = " << testmpiio << '\n';
+    for(int i(0); i < compareNFiles.size(); ++i) {
+      cout << "compareNFiles[" << i << "]    = " << compareNFiles[i] << '\n';
+    }
+    cout << "mpiioaggregators  = " << mpiioAggregators << '\n';
     cout << "usesingleread     = " << useSingleRead << '\n';
     cout << "usesinglewrite    = " << useSingleWrite << '\n';
     cout << "checkfpositions   = " << checkFPositions << '\n';
@@ -427,6 +468,9 @@ int main(int argc, char *argv[]) {
       case 4:
         hVersion = VisMF::Header::NoFabHeaderFAMinMax_v1;
       break;
+      case 6:
+        hVersion = VisMF::Header::Bricked_v1;
+      break;
       default:
         amrex::Abort("**** Error:  bad hVersion.");
       }
@@ -483,6 +527,46 @@ int main(int argc, char *argv[]) {
 
 
 
+  if(testreadregion) {
+    for(int itimes(0); itimes < ntimes; ++itimes) {
+      if(ParallelDescriptor::IOProcessor()) {
+        cout << endl << "--------------------------------------------------" << endl;
+        cout << "Testing Region Reads" << endl;
+      }
+
+      TestReadRegion(nfiles, maxgrid, ncomps, nboxes, brickSize, regionSize, nRegions);
+
+      ParallelDescriptor::Barrier("TestReadRegion::finished");
+
+      if(ParallelDescriptor::IOProcessor()) {
+        cout << "==================================================" << endl;
+        cout << endl;
+      }
+    }
+  }
+
+
+
+  if(testmpiio) {
+    for(int itimes(0); itimes < ntimes; ++itimes) {
+      if(ParallelDescriptor::IOProcessor()) {
+        cout << endl << "--------------------------------------------------" << endl;
+        cout << "Testing MPIIO Write" << endl;
+      }
+
+      TestWriteMPIIO(compareNFiles, maxgrid, ncomps, nboxes, mb2, mpiioAggregators);
+
+      ParallelDescriptor::Barrier("TestWriteMPIIO::finished");
+
+      if(ParallelDescriptor::IOProcessor()) {
+        cout << "==================================================" << endl;
+        cout << endl;
+      }
+    }
+  }
+
+
+
   amrex::Finalize();
   return 0;
 }
@@ -4,6 +4,9 @@
 #include <AMReX_MultiFabUtil.H>
 #include <AMReX_ParmParse.H>
 
+#include <iomanip>
+#include <numeric>
+
 #include <prob_par.H>
 
 using namespace amrex;
@@ -20,6 +23,24 @@ static int linop_maxorder = 2;
 static bool agglomeration = false;
 static bool consolidation = false;
 static int  use_hypre = 0;
+static std::string bottom_solver = "bicgstab";
+static bool compare_bottom_solvers = false;
+static int  num_coeff_updates = 0;
+
+MLMG::BottomSolver bottom_solver_type (const std::string& name)
+{
+    if (name == "smoother")     return MLMG::BottomSolver::smoother;
+    if (name == "bicgstab")     return MLMG::BottomSolver::bicgstab;
+    if (name == "cg")           return MLMG::BottomSolver::cg;
+    if (name == "bicgcg")       return MLMG::BottomSolver::bicgcg;
+    if (name == "cgbicg")       return MLMG::BottomSolver::cgbicg;
+    if (name == "pipecg")       return MLMG::BottomSolver::pipecg;
+    if (name == "pipebicgstab") return MLMG::BottomSolver::pipebicgstab;
+    if (name == "amg")          return MLMG::BottomSolver::amg;
+    if (name == "hypre")        return MLMG::BottomSolver::hypre;
+    amrex::Abort("Unknown bottom_solver " + name);
+    return MLMG::BottomSolver::Default;
+}
 }
 
 void solve_with_mlmg(const Vector<Geometry>& geom, int ref_ratio,
@@ -44,6 +65,9 @@ void solve_with_mlmg(const Vector<Geometry>& geom, int ref_ratio,
     pp.query("agglomeration", agglomeration);
     pp.query("consolidation", consolidation);
     pp.query("use_hypre", use_hypre);
+    pp.query("bottom_solver", bottom_solver);
+    pp.query("compare_bottom_solvers", compare_bottom_solvers);
+    pp.query("num_coeff_updates", num_coeff_updates);
     pp.query("tol_rel", tol_rel);
     pp.query("tol_abs", tol_abs);
   }
@@ -67,36 +91,136 @@ void solve_with_mlmg(const Vector<Geometry>& geom, int ref_ratio,
       prhs.push_back(&(rhs[ilev]));
     }
 
-    MLABecLaplacian mlabec(geom, grids, dmap, info);
-    mlabec.setMaxOrder(linop_maxorder);
-    // BC
-    mlabec.setDomainBC({prob::bc_type, prob::bc_type, prob::bc_type},
-                       {prob::bc_type, prob::bc_type, prob::bc_type});
+    // The operator and the solver with the b coefficients scaled by bfac.
+    auto set_coeffs = [&] (MLABecLaplacian& op, Real bfac) {
+      for (int ilev = 0; ilev < nlevels; ++ilev) {
+        op.setACoeffs(ilev, alpha[ilev]);
+        std::array<MultiFab, AMREX_SPACEDIM> bcoefs;
+        for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+          const BoxArray& ba = amrex::convert(beta[ilev].boxArray(),
+                                              IntVect::TheDimensionVector(idim));
+          bcoefs[idim].define(ba, beta[ilev].DistributionMap(), 1, 0);
+        }
+        amrex::average_cellcenter_to_face(amrex::GetArrOfPtrs(bcoefs),
+                                          beta[ilev], geom[ilev]);
+        for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+          bcoefs[idim].mult(bfac);
+        }
+        op.setBCoeffs(ilev, amrex::GetArrOfConstPtrs(bcoefs));
+      }
+    };
+    // The ghost cells of soln hold the Dirichlet values, but a solve
+    // overwrites them, so a copy is kept for the operators built later.
+    Vector<MultiFab> bcdata(nlevels);
     for (int ilev = 0; ilev < nlevels; ++ilev) {
-      mlabec.setLevelBC(ilev, psoln[ilev]);
+      bcdata[ilev].define(soln[ilev].boxArray(), soln[ilev].DistributionMap(),
+                          soln[ilev].nComp(), soln[ilev].nGrow());
+      MultiFab::Copy(bcdata[ilev], soln[ilev], 0, 0, soln[ilev].nComp(), soln[ilev].nGrow());
     }
-    mlabec.setScalars(prob::a, prob::b);
-    for (int ilev = 0; ilev < nlevels; ++ilev) {
-      mlabec.setACoeffs(ilev, alpha[ilev]);
-      std::array<MultiFab, AMREX_SPACEDIM> bcoefs;
-      for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
-        const BoxArray& ba = amrex::convert(beta[ilev].boxArray(),
-                                            IntVect::TheDimensionVector(idim));
-        bcoefs[idim].define(ba, beta[ilev].DistributionMap(), 1, 0);
+    auto define_operator = [&] (MLABecLaplacian& op, Real bfac) {
+      op.define(geom, grids, dmap, info);
+      op.setMaxOrder(linop_maxorder);
+      // BC
+      op.setDomainBC({prob::bc_type, prob::bc_type, prob::bc_type},
+                     {prob::bc_type, prob::bc_type, prob::bc_type});
+      for (int ilev = 0; ilev < nlevels; ++ilev) {
+        op.setLevelBC(ilev, &bcdata[ilev]);
       }
-      amrex::average_cellcenter_to_face(amrex::GetArrOfPtrs(bcoefs),
-                                        beta[ilev], geom[ilev]);
-      mlabec.setBCoeffs(ilev, amrex::GetArrOfConstPtrs(bcoefs));
-    }
+      op.setScalars(prob::a, prob::b);
+      set_coeffs(op, bfac);
+    };
+    auto define_solver = [&] (MLMG& solver) {
+      solver.setMaxIter(max_iter);
+      solver.setMaxFmgIter(max_fmg_iter);
+      solver.setBottomSolver(bottom_solver_type(use_hypre ? "hypre" : bottom_solver));
+      solver.setVerbose(verbose);
+      solver.setBottomVerbose(cg_verbose);
+    };
+
+    MLABecLaplacian mlabec;
+    define_operator(mlabec, 1.0);
 
     MLMG mlmg(mlabec);
-    mlmg.setMaxIter(max_iter);
-    mlmg.setMaxFmgIter(max_fmg_iter);
-    if (use_hypre) mlmg.setBottomSolver(MLMG::BottomSolver::hypre);
-    mlmg.setVerbose(verbose);
-    mlmg.setBottomVerbose(cg_verbose);
+    define_solver(mlmg);
+
+    if (compare_bottom_solvers) {
+      // Solve from the same initial guess with each of the Krylov bottom
+      // solvers, and compare the iterations and the time spent in the bottom.
+      Vector<MultiFab> soln0(nlevels);
+      for (int ilev = 0; ilev < nlevels; ++ilev) {
+        soln0[ilev].define(soln[ilev].boxArray(), soln[ilev].DistributionMap(),
+                           soln[ilev].nComp(), soln[ilev].nGrow());
+        MultiFab::Copy(soln0[ilev], soln[ilev], 0, 0, soln[ilev].nComp(), soln[ilev].nGrow());
+      }
+
+      for (const std::string name : {"bicgstab", "pipebicgstab", "cg", "pipecg", "amg"}) {
+        for (int ilev = 0; ilev < nlevels; ++ilev) {
+          MultiFab::Copy(soln[ilev], soln0[ilev], 0, 0, soln[ilev].nComp(), soln[ilev].nGrow());
+        }
+        mlmg.setBottomSolver(bottom_solver_type(name));
+        mlmg.solve(psoln, prhs, tol_rel, tol_abs);
 
-    mlmg.solve(psoln, prhs, tol_rel, tol_abs);
+        const Vector<int>& cg_iters = mlmg.getNumCGIters();
+        Real times[2] = { mlmg.getSolveTime(), mlmg.getBottomSolveTime() };
+        ParallelDescriptor::ReduceRealMax(times, 2);
+        amrex::Print() << std::setw(12) << name << ": MLMG iterations " << mlmg.getNumIters()
+                       << ", bottom iterations "
+                       << std::accumulate(cg_iters.begin(), cg_iters.end(), 0)
+                       << ", final residual " << mlmg.getFinalResidual()
+                       << ", solve time " << times[0]
+                       << ", bottom time " << times[1] << "\n";
+      }
+    } else {
+      mlmg.solve(psoln, prhs, tol_rel, tol_abs);
+
+      // Solve again after changing the coefficients.  The operator and the
+      // solver are reused, so only the coefficients are averaged down and the
+      // bottom solver matrix is refilled.  Every other update restores the
+      // original coefficients, so the last solution can be checked.  Each
+      // update is also solved from the same initial guess by a new operator
+      // and solver, whose solution has to agree with the reused ones.
+      Vector<MultiFab> soln_fresh(nlevels);
+      for (int ilev = 0; ilev < nlevels; ++ilev) {
+        soln_fresh[ilev].define(soln[ilev].boxArray(), soln[ilev].DistributionMap(),
+                                soln[ilev].nComp(), soln[ilev].nGrow());
+      }
+      for (int iupdate = 1; iupdate <= 2*num_coeff_updates; ++iupdate) {
+        const Real bfac = (iupdate % 2 == 1) ? 2.0 : 1.0;
+        for (int ilev = 0; ilev < nlevels; ++ilev) {
+          MultiFab::Copy(soln_fresh[ilev], soln[ilev], 0, 0, soln[ilev].nComp(), soln[ilev].nGrow());
+        }
+
+        set_coeffs(mlabec, bfac);
+        mlmg.solve(psoln, prhs, tol_rel, tol_abs);
+
+        Real times[2] = { mlmg.getSetupTime(), mlmg.getSolveTime() };
+        ParallelDescriptor::ReduceRealMax(times, 2);
+        amrex::Print() << "Coefficient update " << iupdate << ": MLMG iterations "
+                       << mlmg.getNumIters() << ", setup time " << times[0]
+                       << ", solve time " << times[1] << "\n";
+
+        MLABecLaplacian mlabec_fresh;
+        define_operator(mlabec_fresh, bfac);
+        MLMG mlmg_fresh(mlabec_fresh);
+        define_solver(mlmg_fresh);
+        mlmg_fresh.solve(amrex::GetVecOfPtrs(soln_fresh), prhs, tol_rel, tol_abs);
+
+        Real maxdiff = 0.0, maxsoln = 0.0;
+        for (int ilev = 0; ilev < nlevels; ++ilev) {
+          MultiFab::Subtract(soln_fresh[ilev], soln[ilev], 0, 0, 1, 0);
+          maxdiff = std::max(maxdiff, soln_fresh[ilev].norminf());
+          maxsoln = std::max(maxsoln, soln[ilev].norminf());
+        }
+        amrex::Print() << "Coefficient update " << iupdate << ": new solver MLMG iterations "
+                       << mlmg_fresh.getNumIters() << ", setup time " << mlmg_fresh.getSetupTime()
+                       << ", max difference from the reused solver " << maxdiff << "\n";
+        // Both start from the same guess with the same operator, so they
+        // should take the same iterations up to round-off.
+        if (mlmg_fresh.getNumIters() != mlmg.getNumIters() || maxdiff > 1.e-12*maxsoln) {
+          amrex::Abort("Coefficient update: the reused and the new solver disagree");
+        }
+      }
+    }
   } else {
     const int levbegin = (fine_leve_solve_only) ? nlevels-1 : 0;
     for (int ilev = 0; ilev < levbegin; ++ilev) {
@@ -0,0 +1,224 @@
+#include "MyTest.H"
+
+#include <AMReX_ParmParse.H>
+#include <AMReX_MultiFabUtil.H>
+
+using namespace amrex;
+
+MyTest::MyTest ()
+{
+    readParameters();
+    initGrids();
+    initCoeffs();
+}
+
+//
+// For each number of right-hand sides, solve them one at a time with a
+// one-component operator, and all together with MLMG::solveBatched.
+//
+void
+MyTest::run ()
+{
+    for (int n : nrhs)
+    {
+        MultiFab exact(grids, dmap, n, 1);
+        MultiFab rhs(grids, dmap, n, 0);
+        MultiFab phi(grids, dmap, n, 1);
+        initExact(exact);
+
+        auto mlabec = makeOperator(n);
+        MLMG mlmg(*mlabec);
+        mlmg.setVerbose(verbose);
+        mlmg.setBottomVerbose(bottom_verbose);
+
+        // The rhs is the discrete operator applied to the exact solution.
+        mlmg.apply({&rhs}, {&exact});
+
+        Real seq_time = 0.0;
+        int seq_iters = 0;
+        Real seq_err = 0.0;
+        if (do_sequential)
+        {
+            BL_PROFILE_REGION("Sequential");
+            auto mlabec1 = makeOperator(1);
+            MLMG mlmg1(*mlabec1);
+            mlmg1.setVerbose(verbose);
+            mlmg1.setBottomVerbose(bottom_verbose);
+
+            MultiFab rhs1(grids, dmap, 1, 0);
+            MultiFab phi1(grids, dmap, 1, 1);
+            for (int icomp = 0; icomp < n; ++icomp)
+            {
+                MultiFab::Copy(rhs1, rhs, icomp, 0, 1, 0);
+                phi1.setVal(0.0);
+                Real t0 = amrex::second();
+                mlmg1.solve({&phi1}, {&rhs1}, tol_rel, 0.0);
+                seq_time += amrex::second() - t0;
+                seq_iters += mlmg1.getNumIters();
+                seq_err = std::max(seq_err, relError(phi1, 0, exact, icomp));
+            }
+        }
+
+        phi.setVal(0.0);
+        Real batch_time;
+        {
+            BL_PROFILE_REGION("Batched");
+            Real t0 = amrex::second();
+            mlmg.solveBatched({&phi}, {&rhs}, tol_rel, 0.0);
+            batch_time = amrex::second() - t0;
+        }
+
+        Real batch_err = 0.0;
+        for (int icomp = 0; icomp < n; ++icomp) {
+            batch_err = std::max(batch_err, relError(phi, icomp, exact, icomp));
+        }
+
+        const Vector<int>& iters = mlmg.getNumItersPerComp();
+        const int min_iters = *std::min_element(iters.begin(), iters.end());
+
+        Real times[2] = {seq_time, batch_time};
+        ParallelDescriptor::ReduceRealMax(times, 2);
+
+        amrex::Print() << "nrhs = " << std::setw(3) << n;
+        if (do_sequential) {
+            amrex::Print() << ": sequential time " << times[0]
+                           << " (" << seq_iters << " MLMG iterations, max rel. error "
+                           << seq_err << "),";
+        }
+        amrex::Print() << " batched time " << times[1]
+                       << " (" << mlmg.getNumIters() << " MLMG iterations, components converged after "
+                       << min_iters << " to " << mlmg.getNumIters()
+                       << ", max rel. error " << batch_err << ")\n";
+    }
+}
+
+std::unique_ptr<MLABecLaplacian>
+MyTest::makeOperator (int ncomp)
+{
+    LPInfo info;
+    info.setMaxCoarseningLevel(max_coarsening_level);
+
+    std::unique_ptr<MLABecLaplacian> mlabec(new MLABecLaplacian({geom}, {grids}, {dmap},
+                                                                info, {}, ncomp));
+
+    mlabec->setDomainBC({AMREX_D_DECL(LinOpBCType::Dirichlet,
+                                      LinOpBCType::Dirichlet,
+                                      LinOpBCType::Dirichlet)},
+                        {AMREX_D_DECL(LinOpBCType::Dirichlet,
+                                      LinOpBCType::Dirichlet,
+                                      LinOpBCType::Dirichlet)});
+    mlabec->setLevelBC(0, nullptr);
+
+    mlabec->setScalars(ascalar, bscalar);
+    mlabec->setACoeffs(0, acoef);
+    mlabec->setBCoeffs(0, amrex::GetArrOfConstPtrs(face_bcoef));
+
+    return mlabec;
+}
+
+//
+// Component n is a sine mode with an amplitude that spans four orders of
+// magnitude across the components, so the components converge differently.
+//
+void
+MyTest::initExact (MultiFab& exact)
+{
+    const auto prob_lo = geom.ProbLoArray();
+    const auto dx      = geom.CellSizeArray();
+    const int ncomp = exact.nComp();
+    const Real pi = 3.1415926535897932;
+
+    exact.setVal(0.0);
+    for (MFIter mfi(exact); mfi.isValid(); ++mfi)
+    {
+        const Box& bx = mfi.validbox();
+        const auto& phi = exact.array(mfi);
+        amrex::LoopOnCpu(bx, ncomp, [&] (int i, int j, int k, int n)
+        {
+            amrex::ignore_unused(j,k);
+            const Real amp = std::pow(10.0, n%5 - 2);
+            AMREX_D_TERM(const Real x = prob_lo[0] + dx[0]*(i+0.5);,
+                         const Real y = prob_lo[1] + dx[1]*(j+0.5);,
+                         const Real z = prob_lo[2] + dx[2]*(k+0.5););
+            phi(i,j,k,n) = amp AMREX_D_TERM(* std::sin(pi*(1+n%3)*x),
+                                            * std::sin(pi*(1+n%2)*y),
+                                            * std::sin(pi*(1+n%4)*z));
+        });
+    }
+}
+
+Real
+MyTest::relError (const MultiFab& phi, int phicomp, const MultiFab& exact, int excomp)
+{
+    MultiFab err(grids, dmap, 1, 0);
+    MultiFab::Copy(err, phi, phicomp, 0, 1, 0);
+    MultiFab::Subtract(err, exact, excomp, 0, 1, 0);
+    return err.norm0() / exact.norm0(excomp);
+}
+
+void
+MyTest::readParameters ()
+{
+    ParmParse pp;
+    pp.query("n_cell", n_cell);
+    pp.query("max_grid_size", max_grid_size);
+    if (pp.countval("nrhs") > 0) {
+        nrhs.clear();
+        pp.getarr("nrhs", nrhs);
+    }
+    pp.query("do_sequential", do_sequential);
+
+    pp.query("verbose", verbose);
+    pp.query("bottom_verbose", bottom_verbose);
+    pp.query("max_coarsening_level", max_coarsening_level);
+    pp.query("tol_rel", tol_rel);
+}
+
+void
+MyTest::initGrids ()
+{
+    RealBox rb({AMREX_D_DECL(0.,0.,0.)}, {AMREX_D_DECL(1.,1.,1.)});
+    std::array<int,AMREX_SPACEDIM> isperiodic{AMREX_D_DECL(0,0,0)};
+    Geometry::Setup(&rb, 0, isperiodic.data());
+    Box domain(IntVect{AMREX_D_DECL(0,0,0)}, IntVect{AMREX_D_DECL(n_cell-1,n_cell-1,n_cell-1)});
+    geom.define(domain, rb, CoordSys::cartesian, isperiodic);
+
+    grids.define(domain);
+    grids.maxSize(max_grid_size);
+    dmap.define(grids);
+}
+
+//
+// a = 1 and b = 1 + x y z / 2 (in 3D), the same for all the right-hand sides.
+// b has one component, which the batched operator uses for all of them.
+//
+void
+MyTest::initCoeffs ()
+{
+    acoef.define(grids, dmap, 1, 0);
+    acoef.setVal(1.0);
+
+    MultiFab bcoef(grids, dmap, 1, 1);
+    const auto prob_lo = geom.ProbLoArray();
+    const auto dx      = geom.CellSizeArray();
+    for (MFIter mfi(bcoef); mfi.isValid(); ++mfi)
+    {
+        const Box& gbx = mfi.fabbox();
+        const auto& b = bcoef.array(mfi);
+        amrex::LoopOnCpu(gbx, [&] (int i, int j, int k)
+        {
+            amrex::ignore_unused(j,k);
+            AMREX_D_TERM(const Real x = prob_lo[0] + dx[0]*(i+0.5);,
+                         const Real y = prob_lo[1] + dx[1]*(j+0.5);,
+                         const Real z = prob_lo[2] + dx[2]*(k+0.5););
+            b(i,j,k) = 1.0 + 0.5*AMREX_D_TERM(x,*y,*z);
+        });
+    }
+
+    for (int idim = 0; idim < AMREX_SPACEDIM; ++idim)
+    {
+        const BoxArray& ba = amrex::convert(grids, IntVect::TheDimensionVector(idim));
+        face_bcoef[idim].define(ba, dmap, 1, 0);
+    }
+    amrex::average_cellcenter_to_face(GetArrOfPtrs(face_bcoef), bcoef, geom);
+}
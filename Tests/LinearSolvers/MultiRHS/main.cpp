@@ -0,0 +1,14 @@
+#include <AMReX.H>
+#include "MyTest.H"
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc, argv);
+
+    {
+        MyTest mytest;
+        mytest.run();
+    }
+
+    amrex::Finalize();
+}
@@ -0,0 +1,263 @@
+#include <iostream>
+
+#include <AMReX.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_AmrParticles.H>
+#include <AMReX_ColumnarParticleIO.H>
+
+using namespace amrex;
+
+static constexpr int NSR = 1 + AMREX_SPACEDIM;
+static constexpr int NSI = 1;
+static constexpr int NAR = 1;
+static constexpr int NAI = 1;
+
+struct TestParams {
+  int nx;
+  int ny;
+  int nz;
+  int max_grid_size;
+  int nppc;
+  int nlevs;
+};
+
+class MyParticleContainer
+    : public amrex::AmrParticleContainer<NSR, NSI, NAR, NAI>
+{
+
+public:
+
+    MyParticleContainer (const Vector<amrex::Geometry>            & a_geom,
+                         const Vector<amrex::DistributionMapping> & a_dmap,
+                         const Vector<amrex::BoxArray>            & a_ba,
+                         const Vector<int>                        & a_rr)
+        : amrex::AmrParticleContainer<NSR, NSI, NAR, NAI>(a_geom, a_dmap, a_ba, a_rr)
+    {}
+
+    void InitParticles (int nppc)
+    {
+        BL_PROFILE("InitParticles");
+
+        const int lev = 0;  // add particles on level 0; Redistribute moves them to level 1
+        const Real* dx = Geom(lev).CellSize();
+        const Real* plo = Geom(lev).ProbLo();
+
+        for (MFIter mfi = MakeMFIter(lev); mfi.isValid(); ++mfi)
+        {
+            const Box& tile_box = mfi.tilebox();
+
+            Gpu::HostVector<ParticleType> host_particles;
+            Gpu::HostVector<ParticleReal> host_real;
+            Gpu::HostVector<int> host_int;
+
+            for (IntVect iv = tile_box.smallEnd(); iv <= tile_box.bigEnd(); tile_box.next(iv))
+            {
+                for (IntVect ip(0); ip <= IntVect(nppc-1); Box(IntVect(0),IntVect(nppc-1)).next(ip))
+                {
+                    ParticleType p;
+                    p.id()  = ParticleType::NextID();
+                    p.cpu() = ParallelDescriptor::MyProc();
+                    for (int d = 0; d < AMREX_SPACEDIM; ++d) {
+                        p.pos(d) = plo[d] + (iv[d] + (0.5+ip[d])/nppc)*dx[d];
+                    }
+                    for (int i = 0; i < NSR; ++i) p.rdata(i) = p.id();
+                    for (int i = 0; i < NSI; ++i) p.idata(i) = 2*p.id();
+
+                    host_particles.push_back(p);
+                    host_real.push_back(3*p.id());
+                    host_int.push_back(4*p.id());
+                }
+            }
+
+            auto& particle_tile = DefineAndReturnParticleTile(lev, mfi.index(), mfi.LocalTileIndex());
+            auto old_size = particle_tile.GetArrayOfStructs().size();
+            auto new_size = old_size + host_particles.size();
+            particle_tile.resize(new_size);
+
+            Gpu::copy(Gpu::hostToDevice, host_particles.begin(), host_particles.end(),
+                      particle_tile.GetArrayOfStructs().begin() + old_size);
+            auto& soa = particle_tile.GetStructOfArrays();
+            Gpu::copy(Gpu::hostToDevice, host_real.begin(), host_real.end(),
+                      soa.GetRealData(0).begin() + old_size);
+            Gpu::copy(Gpu::hostToDevice, host_int.begin(), host_int.end(),
+                      soa.GetIntData(0).begin() + old_size);
+        }
+
+        Redistribute();
+    }
+
+    //! For each level, the number of particles and the sums of the id and the components.
+    Vector<Real> Checksums () const
+    {
+        Vector<Real> sums;
+        for (int lev = 0; lev <= finestLevel(); ++lev)
+        {
+            Vector<Real> s(6, 0.0);
+            for (const auto& kv : GetParticles(lev))
+            {
+                const auto& aos = kv.second.GetArrayOfStructs();
+                const auto& soa = kv.second.GetStructOfArrays();
+                for (int i = 0; i < aos.numParticles(); ++i)
+                {
+                    const auto& p = aos[i];
+                    if (p.id() <= 0) continue;
+                    s[0] += 1.0;
+                    s[1] += p.id();
+                    s[2] += p.rdata(0);
+                    s[3] += p.idata(0);
+                    s[4] += soa.GetRealData(0)[i];
+                    s[5] += soa.GetIntData(0)[i];
+                }
+            }
+            sums.insert(sums.end(), s.begin(), s.end());
+        }
+        ParallelDescriptor::ReduceRealSum(sums.dataPtr(), sums.size());
+        return sums;
+    }
+
+    Long NumberInRegion (int lev, const RealBox& region) const
+    {
+        Long n = 0;
+        for (const auto& kv : GetParticles(lev))
+        {
+            const auto& aos = kv.second.GetArrayOfStructs();
+            for (int i = 0; i < aos.numParticles(); ++i)
+            {
+                const auto& p = aos[i];
+                Real x[AMREX_SPACEDIM];
+                for (int d = 0; d < AMREX_SPACEDIM; ++d) x[d] = p.pos(d);
+                if (p.id() > 0 and region.contains(x)) ++n;
+            }
+        }
+        ParallelDescriptor::ReduceLongSum(n);
+        return n;
+    }
+};
+
+void test_columnar_io (TestParams& parms)
+{
+    int nlevs = parms.nlevs;
+
+    RealBox real_box;
+    for (int n = 0; n < AMREX_SPACEDIM; n++) {
+        real_box.setLo(n, 0.0);
+        real_box.setHi(n, 1.0);
+    }
+
+    IntVect domain_lo(AMREX_D_DECL(0 , 0, 0));
+    IntVect domain_hi(AMREX_D_DECL(parms.nx - 1, parms.ny - 1, parms.nz-1));
+    const Box domain(domain_lo, domain_hi);
+
+    Vector<int> rr(nlevs-1, 2);
+
+    int is_per[AMREX_SPACEDIM];
+    for (int i = 0; i < AMREX_SPACEDIM; i++) is_per[i] = 1;
+
+    Vector<Geometry> geom(nlevs);
+    geom[0].define(domain, &real_box, CoordSys::cartesian, is_per);
+    for (int lev = 1; lev < nlevs; lev++) {
+        geom[lev].define(amrex::refine(geom[lev-1].Domain(), rr[lev-1]),
+                         &real_box, CoordSys::cartesian, is_per);
+    }
+
+    Vector<BoxArray> ba(nlevs);
+    ba[0].define(domain);
+    if (nlevs > 1) {
+        int n_fine = parms.nx*rr[0];
+        IntVect refined_lo(AMREX_D_DECL(n_fine/4,n_fine/4,n_fine/4));
+        IntVect refined_hi(AMREX_D_DECL(3*n_fine/4-1,3*n_fine/4-1,3*n_fine/4-1));
+        ba[1].define(Box(refined_lo, refined_hi));
+    }
+    for (int lev = 0; lev < nlevs; lev++) {
+        ba[lev].maxSize(parms.max_grid_size);
+    }
+
+    Vector<DistributionMapping> dmap(nlevs);
+    for (int lev = 0; lev < nlevs; lev++) {
+        dmap[lev] = DistributionMapping{ba[lev]};
+    }
+
+    MyParticleContainer myPC(geom, dmap, ba, rr);
+    myPC.InitParticles(parms.nppc);
+
+    const Vector<Real> sums = myPC.Checksums();
+    amrex::Print() << "Number of particles: " << myPC.TotalNumberOfParticles() << "\n";
+
+    ParmParse pp("particles");
+    for (int columnar = 0; columnar < 2; ++columnar)
+    {
+        pp.add("columnar", columnar);
+        ParallelDescriptor::Barrier();
+        Real t0 = amrex::second();
+        myPC.Checkpoint(columnar ? "chk_columnar" : "chk_native", "particle0");
+        Real dt = amrex::second() - t0;
+        ParallelDescriptor::ReduceRealMax(dt);
+        amrex::Print() << (columnar ? "Columnar" : "Native  ") << " checkpoint time: " << dt << " s\n";
+    }
+
+    // Restart with a different distribution of the grids, as if there were
+    // a different number of processes.
+    const int nprocs = ParallelDescriptor::NProcs();
+    Vector<DistributionMapping> dmap2(nlevs);
+    for (int lev = 0; lev < nlevs; lev++) {
+        Vector<int> pmap(ba[lev].size());
+        for (int k = 0; k < pmap.size(); ++k) {
+            pmap[k] = nprocs - 1 - (k*7) % nprocs;
+        }
+        dmap2[lev].define(std::move(pmap));
+    }
+
+    MyParticleContainer restartPC(geom, dmap2, ba, rr);
+    restartPC.Restart("chk_columnar", "particle0");
+    const Vector<Real> restart_sums = restartPC.Checksums();
+    for (int i = 0; i < sums.size(); ++i) {
+        if (sums[i] != restart_sums[i]) {
+            amrex::Abort("Restart from the columnar format failed");
+        }
+    }
+    amrex::Print() << "Restart passed\n";
+
+    // Read a region and some of the components.  Each process reads some grids.
+    ColumnarParticleReader reader("chk_columnar/particle0");
+    RealBox region(AMREX_D_DECL(0.2,0.2,0.2), AMREX_D_DECL(0.5,0.5,0.5));
+    for (int lev = 0; lev <= reader.finestLevel(); ++lev)
+    {
+        ColumnarParticleReader::Data data;
+        for (int grid = ParallelDescriptor::MyProc(); grid < reader.numGrids(lev); grid += nprocs) {
+            reader.readGrid(lev, grid, &region, {"real_comp0", "real_comp" + std::to_string(NSR)},
+                            {"id", "int_comp1"}, data);
+        }
+
+        Long n = data.ints[0].size();
+        for (Long i = 0; i < n; ++i) {
+            const int id = data.ints[0][i];
+            if (data.real[0][i] != id or data.real[1][i] != 3*id or data.ints[1][i] != 4*id) {
+                amrex::Abort("ColumnarParticleReader read wrong values");
+            }
+        }
+        ParallelDescriptor::ReduceLongSum(n);
+        if (n != myPC.NumberInRegion(lev, region)) {
+            amrex::Abort("ColumnarParticleReader read the wrong particles");
+        }
+        amrex::Print() << "Level " << lev << ": read " << n << " particles in the region\n";
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc,argv);
+
+    ParmParse pp;
+
+    TestParams parms;
+    pp.get("nx", parms.nx);
+    pp.get("ny", parms.ny);
+    pp.get("nz", parms.nz);
+    pp.get("max_grid_size", parms.max_grid_size);
+    pp.get("nlevs", parms.nlevs);
+    pp.get("nppc", parms.nppc);
+
+    test_columnar_io(parms);
+
+    amrex::Finalize();
+}
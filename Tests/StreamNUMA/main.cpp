@@ -0,0 +1,185 @@
+#include <AMReX.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_BArena.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_Print.H>
+
+#include <memory>
+
+using namespace amrex;
+
+namespace {
+
+struct StreamParams
+{
+    int nsteps = 10;
+    int nvar = 1;
+    bool serial_init = true;
+    std::string test = "triad";
+};
+
+Real run_stream (const BoxArray& ba, const DistributionMapping& dm,
+                 Arena* arena, const StreamParams& p)
+{
+    const int nvar = p.nvar;
+
+    MultiFab a(ba, dm, nvar, 0, MFInfo().SetArena(arena));
+    MultiFab b(ba, dm, nvar, 0, MFInfo().SetArena(arena));
+    MultiFab c(ba, dm, nvar, 0, MFInfo().SetArena(arena));
+
+    if (p.serial_init) {
+        // One thread writes everything, e.g., when reading a checkpoint.
+        for (MFIter mfi(a); mfi.isValid(); ++mfi) {
+            a[mfi].setVal<RunOn::Host>(0.0);
+            b[mfi].setVal<RunOn::Host>(0.0);
+            c[mfi].setVal<RunOn::Host>(0.0);
+        }
+    }
+
+    a.setVal(0.0);
+    b.setVal(1.0);
+    c.setVal(2.0);
+
+    const Real scal = 3.0;
+    const std::string& test = p.test;
+
+    Real strt_time = ParallelDescriptor::second();
+
+    for (int s = 1; s <= p.nsteps; ++s)
+    {
+#ifdef _OPENMP
+#pragma omp parallel if (Gpu::notInLaunchRegion())
+#endif
+        for (MFIter mfi(a, TilingIfNotGPU()); mfi.isValid(); ++mfi)
+        {
+            const Box& bx = mfi.tilebox();
+
+            auto a_arr = a.array(mfi);
+            auto b_arr = b.array(mfi);
+            auto c_arr = c.array(mfi);
+
+            if (test == "copy") {
+
+                AMREX_PARALLEL_FOR_4D(bx, nvar, i, j, k, n,
+                {
+                    a_arr(i,j,k,n) = b_arr(i,j,k,n);
+                });
+
+            }
+            else if (test == "scale") {
+
+                AMREX_PARALLEL_FOR_4D(bx, nvar, i, j, k, n,
+                {
+                    a_arr(i,j,k,n) = scal * b_arr(i,j,k,n);
+                });
+
+            }
+            else if (test == "sum") {
+
+                AMREX_PARALLEL_FOR_4D(bx, nvar, i, j, k, n,
+                {
+                    a_arr(i,j,k,n) = b_arr(i,j,k,n) + c_arr(i,j,k,n);
+                });
+
+            }
+            else if (test == "triad") {
+
+                AMREX_PARALLEL_FOR_4D(bx, nvar, i, j, k, n,
+                {
+                    a_arr(i,j,k,n) = b_arr(i,j,k,n) + scal * c_arr(i,j,k,n);
+                });
+
+            }
+            else {
+
+                amrex::Abort("Unknown stream test");
+
+            }
+        }
+    }
+
+    Real run_time = ParallelDescriptor::second() - strt_time;
+    ParallelDescriptor::ReduceRealMax(run_time);
+
+    // Check the answer so that the loops are not optimized away.
+    Real expected = (test == "copy") ? 1.0 : (test == "scale") ? scal
+        : (test == "sum") ? 3.0 : 1.0 + scal*2.0;
+    Real err = std::max(std::abs(a.max(0) - expected), std::abs(a.min(0) - expected));
+    if (err > 1.e-12) {
+        amrex::Abort("Stream benchmark got the wrong answer");
+    }
+
+    return run_time;
+}
+
+}
+
+void main_main ()
+{
+    int n_cell, max_grid_size;
+    StreamParams p;
+
+    {
+        ParmParse pp;
+        pp.get("n_cell", n_cell);
+        pp.get("max_grid_size", max_grid_size);
+        pp.query("nsteps", p.nsteps);
+        pp.query("nvar", p.nvar);
+        pp.query("test", p.test);
+        pp.query("serial_init", p.serial_init);
+    }
+
+    int nBytesScale = 3;
+    if (p.test == "copy" || p.test == "scale") {
+        nBytesScale = 2;
+    }
+
+    Box domain(IntVect(0), IntVect(n_cell-1));
+    BoxArray ba(domain);
+    ba.maxSize(max_grid_size);
+    DistributionMapping dm(ba);
+
+    amrex::Print() << "\nStream NUMA benchmark: test = " << p.test
+                   << ", n_cell = " << n_cell
+                   << ", max_grid_size = " << max_grid_size
+                   << ", nvar = " << p.nvar
+                   << ", nsteps = " << p.nsteps
+                   << ", serial_init = " << p.serial_init
+#ifdef _OPENMP
+                   << ", threads = " << omp_get_max_threads()
+#endif
+                   << "\n\n";
+
+    const Real nBytesGB = Real(p.nvar) * domain.numPts() * nBytesScale * sizeof(Real)
+        / Real(1024*1024*1024);
+
+    std::unique_ptr<Arena> plain(new BArena);
+    std::unique_ptr<Arena> huge(new BArena(ArenaInfo().SetCpuMemory().SetHugePages()));
+    std::unique_ptr<Arena> touch(new BArena(ArenaInfo().SetCpuMemory().SetFirstTouch()));
+    std::unique_ptr<Arena> both(new BArena(ArenaInfo().SetCpuMemory().SetHugePages()
+                                                        .SetFirstTouch()));
+
+    std::vector<std::pair<std::string,Arena*> > arenas
+        {{"malloc",                  plain.get()},
+         {"huge pages",              huge.get()},
+         {"first touch",             touch.get()},
+         {"huge pages + first touch",both.get()}};
+
+    for (auto const& kv : arenas) {
+        Real t = run_stream(ba, dm, kv.second, p);
+        amrex::Print() << "  " << std::setw(26) << std::left << kv.first
+                       << " run time = " << std::setw(12) << t << " s,"
+                       << " bandwidth = " << nBytesGB / (t / p.nsteps) << " GB/s\n";
+    }
+    amrex::Print() << std::endl;
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc,argv);
+    {
+        main_main();
+    }
+    amrex::Finalize();
+    return 0;
+}
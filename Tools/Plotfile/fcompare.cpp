@@ -15,6 +15,251 @@ struct ErrZone {
     IntVect cell;
 };
 
+// The histograms of the errors have a bin for 0, one for < 1e-16, one for
+// each decade from 1e-16 to 1 and one for >= 1.
+constexpr int hist_lo_exp = -16;
+constexpr int nhist = 3 - hist_lo_exp;
+
+int HistBin (Real e)
+{
+    if (e == 0.0) return 0;
+    if (!std::isfinite(e)) return nhist-1;
+    const int l = static_cast<int>(std::floor(std::log10(e)));
+    if (l < hist_lo_exp) return 1;
+    if (l >= 0) return nhist-1;
+    return 2 + l - hist_lo_exp;
+}
+
+std::string HistLabel (int bin)
+{
+    if (bin == 0) return "0";
+    if (bin == 1) return "<1e" + std::to_string(hist_lo_exp);
+    if (bin == nhist-1) return ">=1";
+    return "1e" + std::to_string(bin - 2 + hist_lo_exp);
+}
+
+// The errors of a component accumulated over the grids compared so far.
+struct StreamStats {
+    Real max_err = 0.0;
+    Real sum_err = 0.0;
+    Real sum_err2 = 0.0;
+    Real max_a = 0.0;
+    Real sum_a = 0.0;
+    Real sum_a2 = 0.0;
+    int nan_a = false;
+    int nan_b = false;
+    int max_grid = -1;
+    IntVect max_cell;
+    Vector<Long> hist = Vector<Long>(nhist, 0);
+};
+
+// Compare level ilev grid by grid.  Each process reads and compares its
+// grids one at a time, so only one grid of each plotfile is in memory.  The
+// cells of a grid are compared in parallel with OpenMP.  With early_exit,
+// the processes stop after the first grid on which an error larger than the
+// tolerance is found, and the function returns true.  An error is known to
+// be too large as soon as it is found if rtol is 0, or if the norm is 0 and
+// the VisMF header of plotfile 1 has the max of the variable.
+bool StreamLevel (PlotFileData& pf_a, PlotFileData& pf_b, int ilev, bool grids_match,
+                  const Vector<int>& ivar_b, int norm, Real rtol, bool early_exit,
+                  int save_var_a, MultiFab* mf_diff, Vector<StreamStats>& stats)
+{
+    BL_PROFILE("fcompare::StreamLevel()");
+
+    const int ncomp = ivar_b.size();
+    const BoxArray& ba = pf_a.boxArray(ilev);
+    const DistributionMapping& dm = pf_a.DistributionMap(ilev);
+
+    // ||A||_inf of each variable from the header, if it is there.
+    Vector<Real> hmax(ncomp, -1.0);
+    for (int c = 0; c < ncomp; ++c) {
+        if (pf_a.min(ilev,c) <= pf_a.max(ilev,c)) {
+            hmax[c] = std::max(std::abs(pf_a.min(ilev,c)), std::abs(pf_a.max(ilev,c)));
+        }
+    }
+
+    auto violated = [&] (int c) -> bool
+    {
+        const auto& st = stats[c];
+        if (st.nan_a or st.nan_b) return true;
+        if (rtol == 0.0) return st.max_err > 0.0;
+        if (norm == 0 and hmax[c] >= 0.0) return st.max_err > rtol*hmax[c];
+        return false;
+    };
+
+    // The difference between the min or max of a grid in the two headers
+    // is a lower bound of the max error in the grid, so some differences are
+    // found without reading the data.
+    if (early_exit and grids_match and (rtol == 0.0 or norm == 0))
+    {
+        for (int gid = 0; gid < ba.size(); ++gid) {
+            for (int c = 0; c < ncomp; ++c) {
+                if (ivar_b[c] < 0) continue;
+                const Real mina = pf_a.min(ilev,gid,c), maxa = pf_a.max(ilev,gid,c);
+                const Real minb = pf_b.min(ilev,gid,ivar_b[c]), maxb = pf_b.max(ilev,gid,ivar_b[c]);
+                if (mina > maxa or minb > maxb) continue; // not in the headers
+                const Real lb = std::max(std::abs(mina-minb), std::abs(maxa-maxb));
+                stats[c].max_err = std::max(stats[c].max_err, lb);
+                if (violated(c)) {
+                    amrex::Print() << " the VisMF headers differ on grid " << gid
+                                   << "; the errors are lower bounds\n";
+                    return true;
+                }
+            }
+        }
+    }
+
+    Vector<int> local_grids;
+    for (int gid = 0; gid < ba.size(); ++gid) {
+        if (dm[gid] == ParallelDescriptor::MyProc()) local_grids.push_back(gid);
+    }
+    int nrounds = local_grids.size();
+    ParallelDescriptor::ReduceIntMax(nrounds);
+
+    bool in_order = pf_b.nComp() >= ncomp;
+    for (int c = 0; c < ncomp; ++c) {
+        in_order = in_order and ivar_b[c] == c;
+    }
+
+    bool stop = false;
+    for (int round = 0; round < nrounds and not stop; ++round)
+    {
+        bool local_stop = false;
+        if (round < local_grids.size())
+        {
+            const int gid = local_grids[round];
+            const Box& bx = ba[gid];
+            const Long npts = bx.numPts();
+
+            FArrayBox fa(bx, ncomp);
+            FArrayBox fb(bx, ncomp);
+            pf_a.fill(ilev, fa, 0, 0, ncomp);
+            if (in_order) {
+                pf_b.fill(ilev, fb, 0, 0, ncomp);
+            } else {
+                for (int c = 0; c < ncomp; ++c) {
+                    if (ivar_b[c] >= 0) pf_b.fill(ilev, fb, ivar_b[c], c, 1);
+                }
+            }
+
+            for (int c = 0; c < ncomp; ++c)
+            {
+                if (ivar_b[c] < 0) continue;
+                const Real* pa = fa.dataPtr(c);
+                const Real* pb = fb.dataPtr(c);
+                Real* pd = (c == save_var_a) ? (*mf_diff)[gid].dataPtr() : nullptr;
+                const Real scale = (hmax[c] > 0.0) ? hmax[c] : 1.0;
+                auto& st = stats[c];
+#ifdef AMREX_USE_OMP
+#pragma omp parallel
+#endif
+                {
+                    StreamStats ts;
+                    Long max_loc = 0;
+#ifdef AMREX_USE_OMP
+#pragma omp for
+#endif
+                    for (Long i = 0; i < npts; ++i) {
+                        const Real a = pa[i];
+                        const Real b = pb[i];
+                        if (std::isnan(a)) ts.nan_a = true;
+                        if (std::isnan(b)) ts.nan_b = true;
+                        const Real d = std::abs(b - a);
+                        if (d > ts.max_err) {
+                            ts.max_err = d;
+                            max_loc = i;
+                        }
+                        ts.sum_err += d;
+                        ts.sum_err2 += d*d;
+                        const Real aa = std::abs(a);
+                        ts.max_a = std::max(ts.max_a, aa);
+                        ts.sum_a += aa;
+                        ts.sum_a2 += aa*aa;
+                        if (pd) pd[i] = d;
+                        if (!std::isnan(d)) ++ts.hist[HistBin(d/scale)];
+                    }
+#ifdef AMREX_USE_OMP
+#pragma omp critical (fcompare_stream)
+#endif
+                    {
+                        if (ts.max_err > st.max_err) {
+                            st.max_err = ts.max_err;
+                            st.max_grid = gid;
+                            st.max_cell = bx.atOffset(max_loc);
+                        }
+                        st.sum_err += ts.sum_err;
+                        st.sum_err2 += ts.sum_err2;
+                        st.max_a = std::max(st.max_a, ts.max_a);
+                        st.sum_a += ts.sum_a;
+                        st.sum_a2 += ts.sum_a2;
+                        st.nan_a = st.nan_a or ts.nan_a;
+                        st.nan_b = st.nan_b or ts.nan_b;
+                        for (int k = 0; k < nhist; ++k) st.hist[k] += ts.hist[k];
+                    }
+                }
+
+                if (early_exit and violated(c)) local_stop = true;
+            }
+        }
+
+        if (early_exit) {
+            stop = local_stop;
+            ParallelDescriptor::ReduceBoolOr(stop);
+        }
+    }
+
+    return stop;
+}
+
+// Reduce the errors of level ilev over the processes and compute the norms.
+void ReduceStreamStats (Vector<StreamStats>& stats, int norm, Real dv,
+                        Vector<Real>& aerror, Vector<Real>& rerror,
+                        Vector<int>& has_nan_a, Vector<int>& has_nan_b)
+{
+    const int ncomp = stats.size();
+    Vector<Real> rmax, rsum;
+    Vector<Long> lsum;
+    for (const auto& st : stats) {
+        rmax.push_back(st.max_err);
+        rmax.push_back(st.max_a);
+        rsum.push_back(st.sum_err);
+        rsum.push_back(st.sum_err2);
+        rsum.push_back(st.sum_a);
+        rsum.push_back(st.sum_a2);
+        lsum.push_back(st.nan_a);
+        lsum.push_back(st.nan_b);
+        lsum.insert(lsum.end(), st.hist.begin(), st.hist.end());
+    }
+    ParallelDescriptor::ReduceRealMax(rmax.dataPtr(), rmax.size());
+    ParallelDescriptor::ReduceRealSum(rsum.dataPtr(), rsum.size());
+    ParallelDescriptor::ReduceLongSum(lsum.dataPtr(), lsum.size());
+
+    const int nl = 2 + nhist;
+    for (int c = 0; c < ncomp; ++c) {
+        auto& st = stats[c];
+        st.max_err = rmax[2*c];
+        st.max_a = rmax[2*c+1];
+        st.sum_err = rsum[4*c];
+        st.sum_err2 = rsum[4*c+1];
+        st.sum_a = rsum[4*c+2];
+        st.sum_a2 = rsum[4*c+3];
+        has_nan_a[c] = lsum[nl*c] > 0;
+        has_nan_b[c] = lsum[nl*c+1] > 0;
+        std::copy(lsum.begin()+nl*c+2, lsum.begin()+nl*(c+1), st.hist.begin());
+
+        if (norm == 1) {
+            aerror[c] = st.sum_err * dv;
+            rerror[c] = st.sum_err / st.sum_a;
+        } else if (norm == 2) {
+            aerror[c] = std::sqrt(st.sum_err2 * dv);
+            rerror[c] = std::sqrt(st.sum_err2 / st.sum_a2);
+        } else {
+            aerror[c] = st.max_err;
+            rerror[c] = st.max_err / st.max_a;
+        }
+    }
+}
+
 int main_main()
 {
     const int narg = amrex::command_argument_count();
@@ -36,6 +281,10 @@ int main_main()
     std::string zone_info_var_name;
     Vector<std::string> plot_names(1);
     bool abort_if_not_all_found = false;
+    bool stream = false;
+    bool early_exit = false;
+    bool histogram = false;
+    bool ghost = false;
 
     int farg = 1;
     while (farg <= narg) {
@@ -52,18 +301,33 @@ int main_main()
         } else if (fname == "-d" or fname == "--diffvar") {
             diffvar = amrex::get_command_argument(++farg);
             plot_names[0] = diffvar;
+        } else if (fname == "-g" or fname == "--ghost") {
+            ghost = true;
         } else if (fname == "-a" or fname == "--allow_diff_grids") {
             allow_diff_grids = true;
         } else if (fname == "-r" or fname == "--rel_tol") {
             rtol = std::stod(amrex::get_command_argument(++farg));
         } else if (fname == "--abort_if_not_all_found") {
             abort_if_not_all_found = true;            
+        } else if (fname == "-s" or fname == "--stream") {
+            stream = true;
+        } else if (fname == "-e" or fname == "--early_exit") {
+            stream = true;
+            early_exit = true;
+        } else if (fname == "--histogram") {
+            stream = true;
+            histogram = true;
         } else {
             break;
         }
         ++farg;
     };
 
+    if (ghost and stream) {
+        amrex::Abort("fcompare: -g|--ghost cannot be used with --stream, --early_exit or "
+                     "--histogram, which compare the valid cells only");
+    }
+
     if (plotfile_a.empty()) {
         plotfile_a = amrex::get_command_argument(farg++);
     }
@@ -79,10 +343,11 @@ int main_main()
             << " variable.\n"
             << "\n"
             << " usage:\n"
-            << "    fcompare [-g|--ghost] [-n|--norm num] [-d|--diffvar var] [-z|--zone_info var] [-a|--allow_diff_grids] [-r|rel_tol] file1 file2\n"
+            << "    fcompare [-g|--ghost] [-n|--norm num] [-d|--diffvar var] [-z|--zone_info var] [-a|--allow_diff_grids] [-r|rel_tol] [-s|--stream] [-e|--early_exit] [--histogram] file1 file2\n"
             << "\n"
             << " optional arguments:\n"
             << "    -g|--ghost            : compare the ghost cells too (if stored)\n"
+            << "                            (not with --stream, --early_exit or --histogram)\n"
             << "    -n|--norm num         : what norm to use (default is 0 for inf norm)\n"
             << "    -d|--diffvar var      : output a plotfile showing the differences for\n"
             << "                            variable var\n"
@@ -90,6 +355,12 @@ int main_main()
             << "                            to the maximum error for the given variable\n"
             << "    -a|--allow_diff_grids : allow different BoxArrays covering the same domain\n"
             << "    -r|--rel_tol rtol     : relative tolerance (default is 0)\n"
+            << "    -s|--stream           : compare one grid at a time in parallel instead of\n"
+            << "                            reading the levels into MultiFabs\n"
+            << "    -e|--early_exit       : stop at the first error larger than the tolerance\n"
+            << "                            (implies --stream)\n"
+            << "    --histogram           : print histograms of the errors relative to the\n"
+            << "                            max of each variable (implies --stream)\n"
             << std::endl;
         return 0;
     }
@@ -178,8 +449,11 @@ int main_main()
                    << "  " << std::setw(24) << "(||A - B||/||A||)" << "\n"
                    << " " << std::string(76,'-') << "\n";
 
+    Vector<Vector<StreamStats> > stream_stats(nlevels);
+    int stopped_at_level = -1;
+
     // go level-by-level and patch-by-patch and compare the data
-    for (int ilev = 0; ilev < nlevels; ++ilev)
+    for (int ilev = 0; ilev < nlevels and stopped_at_level < 0; ++ilev)
     {
         if (pf_a.boxArray(ilev).empty() && pf_b.boxArray(ilev).empty()) {
             continue;
@@ -200,7 +474,47 @@ int main_main()
         Vector<Real> rerror_denom(ncomp_a, 0.0);
         Vector<int> has_nan_a(ncomp_a, false);
         Vector<int> has_nan_b(ncomp_a, false);
-        for (int icomp_a = 0; icomp_a < ncomp_a; ++icomp_a) {
+        if (stream) {
+            Real dv = 1.0;
+            for (int idim = 0; idim < dm; ++idim) {
+                dv *= pf_a.cellSize(ilev)[idim];
+            }
+            auto& stats = stream_stats[ilev];
+            stats.resize(ncomp_a);
+            bool stop = StreamLevel(pf_a, pf_b, ilev, grids_match, ivar_b, norm, rtol, early_exit,
+                                    save_var_a, (save_var_a >= 0) ? &mf_array[ilev] : nullptr,
+                                    stats);
+            if (zone_info_var_a >= 0) {
+                // find the process with the max error of the variable
+                const auto& st = stats[zone_info_var_a];
+                Real max_err = st.max_err;
+                ParallelDescriptor::ReduceRealMax(max_err);
+                int owner = ParallelDescriptor::NProcs();
+                if (st.max_grid >= 0 and st.max_err == max_err) {
+                    owner = ParallelDescriptor::MyProc();
+                }
+                ParallelDescriptor::ReduceIntMin(owner);
+                if (max_err > err_zone.max_abs_err and owner < ParallelDescriptor::NProcs()) {
+                    int buf[AMREX_SPACEDIM+1] = {AMREX_D_DECL(st.max_cell[0],st.max_cell[1],st.max_cell[2]),
+                                                 st.max_grid};
+                    ParallelDescriptor::Bcast(buf, AMREX_SPACEDIM+1, owner);
+                    err_zone.max_abs_err = max_err;
+                    err_zone.level = ilev;
+                    err_zone.cell = IntVect(AMREX_D_DECL(buf[0],buf[1],buf[2]));
+                    err_zone.grid_index = buf[AMREX_SPACEDIM];
+                }
+            }
+            ReduceStreamStats(stats, norm, dv, aerror, rerror, has_nan_a, has_nan_b);
+            if (early_exit) {
+                bool level_failed = false;
+                for (int icomp_a = 0; icomp_a < ncomp_a; ++icomp_a) {
+                    level_failed = level_failed or has_nan_a[icomp_a] or has_nan_b[icomp_a]
+                        or (aerror[icomp_a] > 0.0 and !(rerror[icomp_a] <= rtol));
+                }
+                if (stop or level_failed) stopped_at_level = ilev;
+            }
+        }
+        for (int icomp_a = 0; icomp_a < ncomp_a and not stream; ++icomp_a) {
             if (ivar_b[icomp_a] >= 0) {
                 const MultiFab& mf_a = pf_a.get(ilev, names_a[icomp_a]);
                 MultiFab mf_b;
@@ -299,6 +613,29 @@ int main_main()
         }
     }
 
+    if (stopped_at_level >= 0) {
+        amrex::Print() << " stopped early at level " << stopped_at_level
+                       << " because an error is larger than the tolerance\n";
+    }
+
+    if (histogram) {
+        amrex::Print() << "\n error histograms, number of cells with |A - B|/max|A| in\n"
+                       << " [1eN,1eN+1) for each listed 1eN\n";
+        for (int ilev = 0; ilev < nlevels; ++ilev) {
+            if (stream_stats[ilev].empty()) continue;
+            amrex::Print() << " level = " << ilev << "\n";
+            for (int icomp_a = 0; icomp_a < ncomp_a; ++icomp_a) {
+                if (ivar_b[icomp_a] < 0) continue;
+                amrex::Print() << " " << std::setw(24) << std::left << names_a[icomp_a];
+                const auto& hist = stream_stats[ilev][icomp_a].hist;
+                for (int k = 0; k < nhist; ++k) {
+                    if (hist[k] > 0) amrex::Print() << "  " << HistLabel(k) << ": " << hist[k];
+                }
+                amrex::Print() << "\n";
+            }
+        }
+    }
+
     if (save_var_a >= 0) {
         Vector<Geometry> geom;
         Vector<int> levsteps;
@@ -346,7 +683,9 @@ int main_main()
         if (abort_if_not_all_found) return EXIT_FAILURE;
     }
 
-    if (global_error == 0.0 and !any_nans) {
+    if (stopped_at_level >= 0) {
+        return EXIT_FAILURE;
+    } else if (global_error == 0.0 and !any_nans) {
         amrex::Print() << " PLOTFILE AGREE" << std::endl;
         return EXIT_SUCCESS;
     } else if (global_rerror <= rtol) {
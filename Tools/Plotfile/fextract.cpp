@@ -162,6 +162,9 @@ void main_main()
     Vector<Real> pos;
     Vector<Vector<Real> > data(var_names.size());
 
+    // Only the cells on the slice are read from the plotfile.  Each process
+    // handles the pieces of the slice in the grids it owns.
+    const int myproc = ParallelDescriptor::MyProc();
     IntVect rr{1};
     for (int ilev = coarse_level; ilev <= fine_level; ++ilev) {
         Box slice_box(ivloc*rr,ivloc*rr);
@@ -170,69 +173,58 @@ void main_main()
 
         Array<Real,AMREX_SPACEDIM> dx = pf.cellSize(ilev);
 
+        IntVect ratio{1};
+        BoxArray fine_ba;
         if (ilev < fine_level) {
-            IntVect ratio{pf.refRatio(ilev)};
+            ratio = IntVect{pf.refRatio(ilev)};
             for (int idim = dim; idim < AMREX_SPACEDIM; ++idim) {
                 ratio[idim] = 1;
             }
-            const iMultiFab mask = makeFineMask(pf.boxArray(ilev), pf.DistributionMap(ilev),
-                                                pf.boxArray(ilev+1), ratio);
+            fine_ba = amrex::coarsen(pf.boxArray(ilev+1), ratio);
+        }
+
+        const BoxArray& ba = pf.boxArray(ilev);
+        const DistributionMapping& dm = pf.DistributionMap(ilev);
+        for (auto const& isect : ba.intersections(slice_box)) {
+            if (dm[isect.first] != myproc) continue;
+            const Box& bx = isect.second;
+
+            FArrayBox slice_fab(bx, var_names.size());
             for (int ivar = 0; ivar < var_names.size(); ++ivar) {
-                const MultiFab& mf = pf.get(ilev, var_names[ivar]);
-                for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
-                    const Box& bx = mfi.validbox() & slice_box;
-                    if (bx.ok()) {
-                        const auto& m = mask.array(mfi);
-                        const auto& fab = mf.array(mfi);
-                        const auto lo = amrex::lbound(bx);
-                        const auto hi = amrex::ubound(bx);
-                        for         (int k = lo.z; k <= hi.z; ++k) {
-                            for     (int j = lo.y; j <= hi.y; ++j) {
-                                for (int i = lo.x; i <= hi.x; ++i) {
-                                    if (m(i,j,k) == 0) { // not covered by fine
-                                        if (pos.size() == data[ivar].size()) {
-                                            Array<Real,AMREX_SPACEDIM> p
-                                                = {AMREX_D_DECL(problo[0]+(i+0.5)*dx[0],
-                                                                problo[1]+(j+0.5)*dx[1],
-                                                                problo[2]+(k+0.5)*dx[2])};
-                                            pos.push_back(p[idir]);
-                                        }
-                                        data[ivar].push_back(fab(i,j,k));
-                                    }
-                                }
-                            }
-                        }
-                    }
+                pf.fill(ilev, var_names[ivar], slice_fab, ivar);
+            }
+
+            IArrayBox mask(bx);
+            mask.setVal<RunOn::Host>(0);
+            if (ilev < fine_level) {
+                for (auto const& fisect : fine_ba.intersections(bx)) {
+                    mask.setVal<RunOn::Host>(1, fisect.second, 0, 1);
                 }
             }
-            rr *= ratio;
-        } else {
-            for (int ivar = 0; ivar < var_names.size(); ++ivar) {
-                const MultiFab& mf = pf.get(ilev, var_names[ivar]);
-                for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
-                    const Box& bx = mfi.validbox() & slice_box;
-                    if (bx.ok()) {
-                        const auto& fab = mf.array(mfi);
-                        const auto lo = amrex::lbound(bx);
-                        const auto hi = amrex::ubound(bx);
-                        for         (int k = lo.z; k <= hi.z; ++k) {
-                            for     (int j = lo.y; j <= hi.y; ++j) {
-                                for (int i = lo.x; i <= hi.x; ++i) {
-                                    if (pos.size() == data[ivar].size()) {
-                                        Array<Real,AMREX_SPACEDIM> p
-                                            = {AMREX_D_DECL(problo[0]+(i+0.5)*dx[0],
-                                                            problo[1]+(j+0.5)*dx[1],
-                                                            problo[2]+(k+0.5)*dx[2])};
-                                        pos.push_back(p[idir]);
-                                    }
-                                    data[ivar].push_back(fab(i,j,k));
-                                }
+
+            const auto& m = mask.const_array();
+            const auto& fab = slice_fab.const_array();
+            const auto lo = amrex::lbound(bx);
+            const auto hi = amrex::ubound(bx);
+            for         (int k = lo.z; k <= hi.z; ++k) {
+                for     (int j = lo.y; j <= hi.y; ++j) {
+                    for (int i = lo.x; i <= hi.x; ++i) {
+                        if (m(i,j,k) == 0) { // not covered by fine
+                            Array<Real,AMREX_SPACEDIM> p
+                                = {AMREX_D_DECL(problo[0]+(i+0.5)*dx[0],
+                                                problo[1]+(j+0.5)*dx[1],
+                                                problo[2]+(k+0.5)*dx[2])};
+                            pos.push_back(p[idir]);
+                            for (int ivar = 0; ivar < var_names.size(); ++ivar) {
+                                data[ivar].push_back(fab(i,j,k,ivar));
                             }
                         }
                     }
                 }
             }
         }
+
+        rr *= ratio;
     }
 
 #ifdef BL_USE_MPI